@@ -20,5 +20,38 @@ export default [
     type: 'integer',
     min: 0,
     default: 0,
+  },
+  {
+    id: 'streamIdleTimeout',
+    name: 'Stream Idle Timeout (Seconds)',
+    type: 'integer',
+    min: 0,
+    default: 600,
+  },
+  {
+    id: 'streamMemoryLimit',
+    name: 'Stream Memory Limit (MiB)',
+    type: 'integer',
+    min: 0,
+    default: 256,
+  },
+  {
+    id: 'filterCacheSize',
+    name: 'Filter Cache Size',
+    type: 'integer',
+    min: 0,
+    default: 8,
+  },
+  {
+    id: 'filterSpecialization',
+    name: 'Specialize Native Filters',
+    type: 'boolean',
+    default: true,
+  },
+  {
+    id: 'filterJit',
+    name: 'Compile Native Filters to Machine Code',
+    type: 'boolean',
+    default: false,
   }
 ]
@@ -1,5 +1,5 @@
 import PcapFile from './pcap-file'
-import { SessionFactory } from 'plugkit'
+import { SessionFactory, Token } from 'plugkit'
 import fs from 'fs'
 import { promisify } from 'util'
 
@@ -10,8 +10,12 @@ const attributes = {}
 const filterTransforms = []
 export default class Session {
   static registerNativeDissector (file, type) {
+    const native = require(file)
+    if (native.tokenKeywords > Token.keywordCount) {
+      throw new Error(`${file} was built with newer token keywords`)
+    }
     dissectors.push({
-      main: require(file).dissector,
+      main: native.dissector,
       type,
     })
   }
@@ -96,8 +100,8 @@ export default class Session {
 
     return new Promise((res) => {
       sess.on('frame', (stat) => {
-        if (stat.frames === frames.length) {
-          res(sess.getFrames(0, stat.frames))
+        if (stat.completed === frames.length) {
+          res(sess.getFrames(0, stat.completed))
         }
       })
     })
@@ -148,10 +152,10 @@ export default class Session {
       // eslint-disable-next-line no-await-in-loop
       const result = await new Promise((res) => {
         sess.on('frame', (stat) => {
-          if (stat.frames === frames.length) {
+          if (stat.completed === frames.length) {
             const diff = process.hrtime(start)
             res({
-              frames: stat.frames,
+              frames: stat.completed,
               duration: (diff[0] * 1e9) + diff[1],
               pcap: samples[sourceId].pcap,
             })
@@ -2,6 +2,7 @@
 #include <plugkit/attribute.h>
 #include <plugkit/context.h>
 #include <plugkit/dissector.h>
+#include <plugkit/fixed_layer.h>
 #include <plugkit/layer.h>
 #include <plugkit/payload.h>
 #include <plugkit/reader.h>
@@ -13,67 +14,59 @@ using namespace plugkit;
 
 namespace {
 
-const auto ethToken = Token_get("eth");
-const auto srcToken = Token_get(".src");
-const auto dstToken = Token_get(".dst");
-const auto lenToken = Token_get("eth.len");
-const auto ethTypeToken = Token_get("eth.type");
-const auto macToken = Token_get("@eth:mac");
+constexpr Token ethToken = Token_const("eth");
+constexpr Token srcToken = Token_const(".src");
+constexpr Token dstToken = Token_const(".dst");
+constexpr Token lenToken = Token_const("eth.len");
+constexpr Token ethTypeToken = Token_const("eth.type");
+constexpr Token macToken = Token_const("@eth:mac");
 
-static const std::unordered_map<uint16_t, std::pair<Token, Token>> typeTable = {
-    {0x0800, std::make_pair(Token_get("[ipv4]"), Token_get("eth.type.ipv4"))},
-    {0x86DD, std::make_pair(Token_get("[ipv6]"), Token_get("eth.type.ipv6"))},
+constexpr Field fields[] = {
+    {srcToken, macToken, 0, 6, FIELD_SLICE},
+    {dstToken, macToken, 6, 6, FIELD_SLICE},
 };
 
-void analyze(Context *ctx, const Dissector *diss, Worker worker, Layer *layer) {
-  Reader reader;
-  Reader_reset(&reader);
-  reader.data = Payload_slices(Layer_payloads(layer, nullptr)[0], nullptr)[0];
-
-  Layer *child = Layer_addLayer(layer, ethToken);
-  Layer_addTag(child, ethToken);
-
-  const auto &srcSlice = Reader_slice(&reader, 0, 6);
-  Attr *src = Layer_addAttr(child, srcToken);
-  Attr_setSlice(src, srcSlice);
-  Attr_setType(src, macToken);
-  Attr_setRange(src, reader.lastRange);
-
-  const auto &dstSlice = Reader_slice(&reader, 0, 6);
-  Attr *dst = Layer_addAttr(child, dstToken);
-  Attr_setSlice(dst, dstSlice);
-  Attr_setType(dst, macToken);
-  Attr_setRange(dst, reader.lastRange);
+static const std::unordered_map<uint16_t, std::pair<Token, Token>> typeTable = {
+    {0x0800, std::make_pair(Token_const("[ipv4]"), Token_const("eth.type.ipv4"))},
+    {0x86DD, std::make_pair(Token_const("[ipv6]"), Token_const("eth.type.ipv6"))},
+};
 
-  auto protocolType = Reader_getUint16(&reader, false);
+void analyzeType(Context *ctx, Layer *child, Reader *reader,
+                 Attr *const *attrs) {
+  auto protocolType = Reader_getUint16(reader, false);
   if (protocolType <= 1500) {
     Attr *length = Layer_addAttr(child, lenToken);
     Attr_setUint32(length, protocolType);
-    Attr_setRange(length, reader.lastRange);
+    Attr_setRange(length, reader->lastRange);
   } else {
     Attr *etherType = Layer_addAttr(child, ethTypeToken);
     Attr_setUint32(etherType, protocolType);
-    Attr_setRange(etherType, reader.lastRange);
+    Attr_setRange(etherType, reader->lastRange);
     const auto &it = typeTable.find(protocolType);
     if (it != typeTable.end()) {
       Attr *type = Layer_addAttr(child, it->second.second);
       Attr_setBool(type, true);
-      Attr_setRange(type, reader.lastRange);
+      Attr_setRange(type, reader->lastRange);
       Layer_addTag(child, it->second.first);
     }
   }
 
   Payload *chunk = Layer_addPayload(child);
-  Payload_addSlice(chunk, Reader_sliceAll(&reader, 0));
+  Payload_addSlice(chunk, Reader_sliceAll(reader, 0));
 }
+
+constexpr FixedLayer eth = {ethToken, Layout_make(fields), nullptr, 0, 0,
+                            analyzeType};
 } // namespace
 
 void Init(v8::Local<v8::Object> exports) {
   static Dissector diss;
-  diss.layerHints[0] = (Token_get("[eth]"));
-  diss.analyze = analyze;
+  diss.layerHints[0] = (Token_const("[eth]"));
+  diss.analyze = FixedLayer_analyze<eth>;
   exports->Set(Nan::New("dissector").ToLocalChecked(),
                Nan::New<v8::External>(&diss));
+  exports->Set(Nan::New("tokenKeywords").ToLocalChecked(),
+               Nan::New(Token_keywordCount));
 }
 
 NODE_MODULE(dissectorEssentials, Init);
@@ -7,6 +7,7 @@
 #include <plugkit/stream_reader.h>
 #include <plugkit/token.h>
 #include <plugkit/variant.h>
+#include <memory>
 #include <unordered_set>
 
 #define PLUGKIT_ENABLE_LOGGING
@@ -16,13 +17,13 @@ using namespace plugkit;
 
 namespace {
 
-const auto httpToken = Token_get("http");
-const auto srcToken = Token_get(".src");
-const auto dstToken = Token_get(".dst");
-const auto headersToken = Token_get("http.headers");
-const auto reassembledToken = Token_get("@reassembled");
-const auto mimeToken = Token_get("@mime");
-const auto mimeTypeToken = Token_get(".mimeType");
+constexpr Token httpToken = Token_const("http");
+constexpr Token srcToken = Token_const(".src");
+constexpr Token dstToken = Token_const(".dst");
+constexpr Token headersToken = Token_const("http.headers");
+constexpr Token reassembledToken = Token_const("@reassembled");
+constexpr Token mimeToken = Token_const("@mime");
+constexpr Token mimeTypeToken = Token_const(".mimeType");
 
 enum State { STATE_START, STATE_HEADER, STATE_BODY, STATE_CLOSED };
 
@@ -36,8 +37,8 @@ public:
 
 public:
   const std::unordered_set<uint16_t> ports;
-  size_t offset = 0;
   StreamReader *reader;
+  char lineBuffer[8192];
 
   State state = STATE_START;
   size_t headerLength = 0;
@@ -64,22 +65,24 @@ bool HTTPWorker::analyze_start(Context *ctx, Layer *layer) {
 
 bool HTTPWorker::analyze_header(Context *ctx, Layer *layer, Layer *child,
                                 Attr *headers) {
-  size_t index = StreamReader_search(reader, "\r\n", 2, offset);
-
-  if (index == 0)
+  size_t lineLength = 0;
+  Slice slice = StreamReader_readUntil(reader, lineBuffer, sizeof(lineBuffer),
+                                       "\r\n", 2, &lineLength);
+  std::unique_ptr<char[]> longLine;
+  if (slice.begin == nullptr && lineLength > sizeof(lineBuffer)) {
+    longLine.reset(new char[lineLength]);
+    slice = StreamReader_readUntil(reader, longLine.get(), lineLength, "\r\n",
+                                   2, nullptr);
+  }
+  if (slice.begin == nullptr)
     return false;
-  size_t length = index - 2 - offset;
 
-  if (length == 0) {
-    headerLength = index;
-    offset = index;
+  if (Slice_length(slice) == 0) {
+    headerLength = StreamReader_tell(reader);
     state = STATE_BODY;
     return false;
   }
 
-  std::unique_ptr<char[]> buf(new char[length]);
-  const Slice &slice = StreamReader_read(reader, &buf[0], length, offset);
-
   const char *keyBegin = nullptr;
   const char *keyEnd = nullptr;
   const char *valueBegin = nullptr;
@@ -124,7 +127,6 @@ bool HTTPWorker::analyze_header(Context *ctx, Layer *layer, Layer *child,
     }
   }
 
-  offset = index;
   return true;
 }
 
@@ -165,7 +167,8 @@ bool HTTPWorker::analyze_body(Context *ctx, Layer *layer, Layer *child,
       bodyOffset += Slice_length(slice);
     }
 
-    offset = headerLength + contentLength;
+    StreamReader_advance(reader, contentLength);
+    StreamReader_discard(reader, StreamReader_tell(reader));
     headers = nullptr;
     state = STATE_HEADER;
   }
@@ -215,7 +218,7 @@ void HTTPWorker::analyze(Context *ctx, Layer *layer) {
 
 void Init(v8::Local<v8::Object> exports) {
   static Dissector diss;
-  diss.layerHints[0] = Token_get("tcp-stream");
+  diss.layerHints[0] = Token_const("tcp-stream");
   diss.analyze = [](Context *ctx, const Dissector *diss, Worker data,
                     Layer *layer) {
     HTTPWorker *worker = static_cast<HTTPWorker *>(data.data);
@@ -241,6 +244,8 @@ void Init(v8::Local<v8::Object> exports) {
   };
   exports->Set(Nan::New("dissector").ToLocalChecked(),
                Nan::New<v8::External>(&diss));
+  exports->Set(Nan::New("tokenKeywords").ToLocalChecked(),
+               Nan::New(Token_keywordCount));
 }
 } // namespace
 
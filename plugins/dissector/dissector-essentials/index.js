@@ -445,6 +445,27 @@ export default {
       default: [80, 8080],
       toJSON: (str) => str.split(',').map((str) => Number.parseInt(str)),
       toString: (json) => json.join(', ')
+    },
+    {
+      id: 'tcpIdleTimeout',
+      name: 'TCP Stream Idle Timeout (Seconds)',
+      type: 'integer',
+      min: 0,
+      default: 600
+    },
+    {
+      id: 'tcpClosedTimeout',
+      name: 'TCP Stream Timeout after FIN/RST (Seconds)',
+      type: 'integer',
+      min: 0,
+      default: 60
+    },
+    {
+      id: 'tcpMemoryLimit',
+      name: 'TCP Stream Memory Limit (MiB)',
+      type: 'integer',
+      min: 0,
+      default: 64
     }
   ]
 }
@@ -2,94 +2,56 @@
 #include <plugkit/attribute.h>
 #include <plugkit/context.h>
 #include <plugkit/dissector.h>
+#include <plugkit/fixed_layer.h>
 #include <plugkit/layer.h>
 #include <plugkit/payload.h>
 #include <plugkit/reader.h>
 #include <plugkit/token.h>
 #include <plugkit/variant.h>
-#include <unordered_map>
 
 using namespace plugkit;
 
 namespace {
 
-const std::unordered_map<uint16_t, std::pair<Token, Token>> protoTable = {
-    {0x01,
-     std::make_pair(Token_get("[icmp]"), Token_get("ipv6.protocol.icmp"))},
-    {0x02,
-     std::make_pair(Token_get("[igmp]"), Token_get("ipv6.protocol.igmp"))},
-    {0x06, std::make_pair(Token_get("[tcp]"), Token_get("ipv6.protocol.tcp"))},
-    {0x11, std::make_pair(Token_get("[udp]"), Token_get("ipv6.protocol.udp"))},
+constexpr FieldTag protoTable[] = {
+    {0x01, Token_const("[icmp]"), Token_const("ipv6.protocol.icmp")},
+    {0x02, Token_const("[igmp]"), Token_const("ipv6.protocol.igmp")},
+    {0x06, Token_const("[tcp]"), Token_const("ipv6.protocol.tcp")},
+    {0x11, Token_const("[udp]"), Token_const("ipv6.protocol.udp")},
 };
 
-const auto ipv6Token = Token_get("ipv6");
-const auto versionToken = Token_get("ipv6.version");
-const auto tClassToken = Token_get("ipv6.trafficClass");
-const auto fLevelToken = Token_get("ipv6.flowLevel");
-const auto pLenToken = Token_get("ipv6.payloadLength");
-const auto nHeaderToken = Token_get("ipv6.nextHeader");
-const auto hLimitToken = Token_get("ipv6.hopLimit");
-const auto srcToken = Token_get(".src");
-const auto dstToken = Token_get(".dst");
-const auto hbyhToken = Token_get("ipv6.hopByHop");
-const auto protocolToken = Token_get("ipv6.protocol");
-const auto ipv6AddrToken = Token_get("@ipv6:addr");
-const auto flagsTypeToken = Token_get("@flags");
-const auto enumToken = Token_get("@enum");
-
-void analyze(Context *ctx, const Dissector *diss, Worker data, Layer *layer) {
-  Reader reader;
-  Reader_reset(&reader);
-  reader.data = Payload_slices(Layer_payloads(layer, nullptr)[0], nullptr)[0];
-
-  Layer *child = Layer_addLayer(layer, ipv6Token);
-  Layer_addTag(child, ipv6Token);
-
-  uint8_t header = Reader_getUint8(&reader);
-  uint8_t header2 = Reader_getUint8(&reader);
-  int version = header >> 4;
-  int trafficClass = (header & 0b00001111 << 4) | ((header2 & 0b11110000) >> 4);
-  int flowLevel =
-      Reader_getUint16(&reader, false) | ((header2 & 0b00001111) << 16);
-
-  Attr *ver = Layer_addAttr(child, versionToken);
-  Attr_setUint32(ver, version);
-  Attr_setRange(ver, Range{0, 1});
-
-  Attr *tClass = Layer_addAttr(child, tClassToken);
-  Attr_setUint32(tClass, trafficClass);
-  Attr_setRange(tClass, Range{0, 2});
-
-  Attr *fLevel = Layer_addAttr(child, fLevelToken);
-  Attr_setUint32(fLevel, flowLevel);
-  Attr_setRange(fLevel, Range{1, 4});
-
-  Attr *pLen = Layer_addAttr(child, pLenToken);
-  Attr_setUint32(pLen, Reader_getUint16(&reader, false));
-  Attr_setRange(pLen, reader.lastRange);
-
-  int nextHeader = Reader_getUint8(&reader);
-  auto nextHeaderRange = reader.lastRange;
-
-  Attr *nHeader = Layer_addAttr(child, nHeaderToken);
-  Attr_setUint32(nHeader, nextHeader);
-  Attr_setRange(nHeader, nextHeaderRange);
-
-  Attr *hLimit = Layer_addAttr(child, hLimitToken);
-  Attr_setUint32(hLimit, Reader_getUint8(&reader));
-  Attr_setRange(hLimit, reader.lastRange);
-
-  const auto &srcSlice = Reader_slice(&reader, 0, 16);
-  Attr *src = Layer_addAttr(child, srcToken);
-  Attr_setSlice(src, srcSlice);
-  Attr_setType(src, ipv6AddrToken);
-  Attr_setRange(src, reader.lastRange);
+constexpr Token ipv6Token = Token_const("ipv6");
+constexpr Token versionToken = Token_const("ipv6.version");
+constexpr Token tClassToken = Token_const("ipv6.trafficClass");
+constexpr Token fLevelToken = Token_const("ipv6.flowLevel");
+constexpr Token pLenToken = Token_const("ipv6.payloadLength");
+constexpr Token nHeaderToken = Token_const("ipv6.nextHeader");
+constexpr Token hLimitToken = Token_const("ipv6.hopLimit");
+constexpr Token srcToken = Token_const(".src");
+constexpr Token dstToken = Token_const(".dst");
+constexpr Token hbyhToken = Token_const("ipv6.hopByHop");
+constexpr Token protocolToken = Token_const("ipv6.protocol");
+constexpr Token ipv6AddrToken = Token_const("@ipv6:addr");
+constexpr Token flagsTypeToken = Token_const("@flags");
+constexpr Token enumToken = Token_const("@enum");
+
+enum { NEXT_HEADER_FIELD = 4 };
+
+constexpr Field fields[] = {
+    {versionToken, 0, 0, 1, 0, 4, 0xf},
+    {tClassToken, 0, 0, 2, 0, 4, 0xff},
+    {fLevelToken, 0, 0, 4, 0, 0, 0xfffff},
+    {pLenToken, 0, 4, 2},
+    {nHeaderToken, 0, 6, 1},
+    {hLimitToken, 0, 7, 1},
+    {srcToken, ipv6AddrToken, 8, 16, FIELD_SLICE},
+    {dstToken, ipv6AddrToken, 24, 16, FIELD_SLICE},
+};
 
-  const auto &dstSlice = Reader_slice(&reader, 0, 16);
-  Attr *dst = Layer_addAttr(child, dstToken);
-  Attr_setSlice(dst, dstSlice);
-  Attr_setType(dst, ipv6AddrToken);
-  Attr_setRange(dst, reader.lastRange);
+void analyzeExtensions(Context *ctx, Layer *child, Reader *reader,
+                       Attr *const *attrs) {
+  int nextHeader = Attr_uint32(attrs[NEXT_HEADER_FIELD]);
+  Range nextHeaderRange = Attr_range(attrs[NEXT_HEADER_FIELD]);
 
   bool ext = true;
   while (ext) {
@@ -98,10 +60,11 @@ void analyze(Context *ctx, const Dissector *diss, Worker data, Layer *layer) {
     case 0:
     case 60: // Hop-by-Hop Options, Destination Options
     {
-      header = Reader_getUint8(&reader);
-      size_t extLen = Reader_getUint8(&reader);
+      header = Reader_getUint8(reader);
+      nextHeaderRange = reader->lastRange;
+      size_t extLen = Reader_getUint8(reader);
       size_t byteLen = (extLen + 1) * 8;
-      Reader_slice(&reader, 0, byteLen);
+      Reader_slice(reader, 0, byteLen);
       Token id = (nextHeader == 0) ? hbyhToken : dstToken;
     }
 
@@ -125,26 +88,33 @@ void analyze(Context *ctx, const Dissector *diss, Worker data, Layer *layer) {
   Attr *proto = Layer_addAttr(child, protocolToken);
   Attr_setUint32(proto, protocolNumber);
   Attr_setType(proto, enumToken);
-  Attr_setRange(proto, reader.lastRange);
-  const auto &it = protoTable.find(protocolNumber);
-  if (it != protoTable.end()) {
-    Attr *sub = Layer_addAttr(child, it->second.second);
-    Attr_setBool(sub, true);
-    Attr_setRange(sub, reader.lastRange);
-    Layer_addTag(child, it->second.first);
+  Attr_setRange(proto, nextHeaderRange);
+  for (const FieldTag &entry : protoTable) {
+    if (entry.value == protocolNumber) {
+      Attr *sub = Layer_addAttr(child, entry.id);
+      Attr_setBool(sub, true);
+      Attr_setRange(sub, nextHeaderRange);
+      Layer_addTag(child, entry.tag);
+      break;
+    }
   }
 
   Payload *chunk = Layer_addPayload(child);
-  Payload_addSlice(chunk, Reader_sliceAll(&reader, 0));
+  Payload_addSlice(chunk, Reader_sliceAll(reader, 0));
 }
+
+constexpr FixedLayer ipv6 = {ipv6Token, Layout_make(fields), nullptr, 0, 0,
+                             analyzeExtensions};
 } // namespace
 
 void Init(v8::Local<v8::Object> exports) {
   static Dissector diss;
-  diss.layerHints[0] = (Token_get("[ipv6]"));
-  diss.analyze = analyze;
+  diss.layerHints[0] = (Token_const("[ipv6]"));
+  diss.analyze = FixedLayer_analyze<ipv6>;
   exports->Set(Nan::New("dissector").ToLocalChecked(),
                Nan::New<v8::External>(&diss));
+  exports->Set(Nan::New("tokenKeywords").ToLocalChecked(),
+               Nan::New(Token_keywordCount));
 }
 
 NODE_MODULE(dissectorEssentials, Init);
@@ -1,143 +1,178 @@
 #include <algorithm>
-#include <list>
+#include <atomic>
 #include <nan.h>
 #include <plugkit/attribute.h>
 #include <plugkit/context.h>
 #include <plugkit/dissector.h>
+#include <plugkit/flow.h>
+#include <plugkit/flow_table.h>
 #include <plugkit/layer.h>
 #include <plugkit/payload.h>
 #include <plugkit/reader.h>
 #include <plugkit/token.h>
 #include <plugkit/variant.h>
-#include <unordered_map>
+#include <vector>
 
 using namespace plugkit;
 
-using StreamID = std::tuple<uint16_t, uint16_t, std::string, std::string>;
-
-namespace std {
-template <> struct hash<StreamID> {
+namespace {
+constexpr Token srcToken = Token_const(".src");
+constexpr Token dstToken = Token_const(".dst");
+constexpr Token streamIdToken = Token_const("tcp.streamId");
+constexpr Token seqToken = Token_const("tcp.seq");
+constexpr Token flagsToken = Token_const("tcp.flags");
+constexpr Token tcpStreamToken = Token_const("tcp-stream");
+constexpr Token reassembledToken = Token_const("@reassembled");
+const uint8_t tcpProtocolNumber = 0x06;
+
+std::atomic<uint32_t> streamCounter(0);
+
+// Keeps out-of-order segments as a sorted array of non-overlapping
+// intervals. Slices point into the captured frames and are never copied.
+class Reassembler {
 public:
-  size_t operator()(const StreamID &id) const {
-    return hash<uint16_t>()(std::get<0>(id)) ^
-           hash<uint16_t>()(std::get<1>(id)) ^
-           hash<std::string>()(std::get<2>(id)) ^
-           hash<std::string>()(std::get<3>(id));
-  }
+  void put(uint64_t pos, Slice slice);
+  void fetch(std::vector<Slice> *slices);
+  size_t memoryUsage() const;
+
+private:
+  struct Segment {
+    uint64_t begin;
+    Slice slice;
+    uint64_t end() const { return begin + Slice_length(slice); }
+  };
+
+private:
+  uint64_t offset = 0;
+  std::vector<Segment> segments;
 };
-} // namespace std
 
-namespace {
-const auto srcToken = Token_get(".src");
-const auto dstToken = Token_get(".dst");
-const auto streamIdToken = Token_get("tcp.streamId");
-const auto seqToken = Token_get("tcp.seq");
-const auto windowToken = Token_get("tcp.window");
-const auto flagsToken = Token_get("tcp.flags");
-const auto tcpStreamToken = Token_get("tcp-stream");
-const auto reassembledToken = Token_get("@reassembled");
-
-class Ring {
-public:
-  Ring() {}
-  ~Ring() {}
-
-  void put(size_t pos, const Slice &slice) {
-    auto lower = std::lower_bound(
-        slices.begin(), slices.end(), std::make_pair(pos, Slice()),
-        [](const std::pair<size_t, Slice> &a,
-           const std::pair<size_t, Slice> &b) { return a.first < b.first; });
-    slices.insert(lower, std::make_pair(pos, slice));
-    size_t end = offset;
-    for (auto &pair : slices) {
-      if (pair.first < end) {
-        pair.second = Slice_sliceAll(pair.second, end - pair.first);
-        pair.first = end;
-      }
-      end = pair.first + Slice_length(pair.second);
-    }
-    slices.remove_if([](const std::pair<size_t, Slice> &pair) {
-      return Slice_length(pair.second) == 0;
-    });
+void Reassembler::put(uint64_t pos, Slice slice) {
+  uint64_t end = pos + Slice_length(slice);
+  if (end <= offset)
+    return;
+  if (pos < offset) {
+    slice = Slice_sliceAll(slice, offset - pos);
+    pos = offset;
   }
 
-  std::list<Slice> fetch() {
-    std::list<Slice> sequence;
-    auto it = slices.begin();
-    for (; it != slices.end() && it->first == offset; ++it) {
-      sequence.push_back(it->second);
-      offset += Slice_length(it->second);
+  // Data already received wins, so the new segment only fills the holes
+  // between the existing ones.
+  auto it = std::upper_bound(
+      segments.begin(), segments.end(), pos,
+      [](uint64_t pos, const Segment &seg) { return pos < seg.end(); });
+  while (pos < end) {
+    if (it == segments.end() || end <= it->begin) {
+      segments.insert(it, Segment{pos, slice});
+      break;
     }
-    slices.erase(slices.begin(), it);
-    return sequence;
+    if (pos < it->begin) {
+      size_t length = it->begin - pos;
+      it = segments.insert(it, Segment{pos, Slice_slice(slice, 0, length)});
+      ++it;
+      slice = Slice_sliceAll(slice, length);
+      pos += length;
+    }
+    size_t overlap = std::min(end, it->end()) - pos;
+    slice = Slice_sliceAll(slice, overlap);
+    pos += overlap;
+    ++it;
   }
+}
 
-private:
-  size_t offset = 0;
-  std::list<std::pair<size_t, Slice>> slices;
-};
+void Reassembler::fetch(std::vector<Slice> *slices) {
+  size_t count = 0;
+  for (; count < segments.size() && segments[count].begin == offset;
+       ++count) {
+    slices->push_back(segments[count].slice);
+    offset = segments[count].end();
+  }
+  segments.erase(segments.begin(), segments.begin() + count);
+}
+
+size_t Reassembler::memoryUsage() const {
+  return segments.capacity() * sizeof(Segment);
+}
 
 struct Stream {
   uint32_t id = 0;
-  int64_t currentSeq = -1;
-  uint64_t receivedLength = 0;
-  Ring ring;
+  bool established = false;
+  uint32_t initialSeq = 0;
+  uint64_t position = 0;
+  Reassembler reassembler;
+
+  size_t footprint() const { return sizeof(Stream) + reassembler.memoryUsage(); }
 };
 
 struct TCPWorker {
-  std::unordered_map<StreamID, Stream> idMap;
+  FlowTable *idMap;
+  std::vector<Slice> slices;
 };
 
+// Extends a 32-bit sequence offset to the stream position closest to the
+// reference position. Negative positions lie before the start of the stream.
+int64_t unwrap(uint32_t offset, uint64_t reference) {
+  int32_t delta =
+      static_cast<int32_t>(offset - static_cast<uint32_t>(reference));
+  return static_cast<int64_t>(reference) + delta;
+}
+
 void analyze(Context *ctx, const Dissector *diss, Worker data, Layer *layer) {
   TCPWorker *worker = static_cast<TCPWorker *>(data.data);
 
   const auto &parentSrc = Attr_slice(Layer_attr(Layer_parent(layer), srcToken));
   const auto &parentDst = Attr_slice(Layer_attr(Layer_parent(layer), dstToken));
 
-  const auto &id =
-      StreamID(Attr_uint32(Layer_attr(layer, srcToken)),
-               Attr_uint32(Layer_attr(layer, dstToken)),
-               std::string(parentSrc.begin, Slice_length(parentSrc)),
-               std::string(parentDst.begin, Slice_length(parentDst)));
-
-  Stream &stream = worker->idMap[id];
-  if (stream.id == 0) {
-    stream.id = (worker->idMap.size() << 8) | Layer_worker(layer);
+  FlowKey key;
+  FlowKey_set(&key, parentSrc, parentDst,
+              Attr_uint32(Layer_attr(layer, srcToken)),
+              Attr_uint32(Layer_attr(layer, dstToken)), tcpProtocolNumber);
+  const char *id = reinterpret_cast<const char *>(&key);
+
+  const uint64_t time = Layer_timestamp(layer);
+  Stream *found = static_cast<Stream *>(
+      FlowTable_find(worker->idMap, id, sizeof(key), time));
+  if (!found) {
+    found = new Stream();
+    found->id = streamCounter.fetch_add(1, std::memory_order_relaxed) + 1;
+    FlowTable_insert(worker->idMap, id, sizeof(key), found,
+                     found->footprint(), time);
   }
+  Stream &stream = *found;
   Attr_setUint32(Layer_addAttr(layer, streamIdToken), stream.id);
   const Slice payload =
       Payload_slices(Layer_payloads(layer, nullptr)[0], nullptr)[0];
 
   uint32_t seq = Attr_uint32(Layer_attr(layer, seqToken));
-  uint16_t window = Attr_uint32(Layer_attr(layer, windowToken));
   uint8_t flags = Attr_uint32(Layer_attr(layer, flagsToken));
   bool syn = (flags & (0x1 << 1));
-  if (syn) {
-    if (stream.currentSeq < 0) {
-      stream.currentSeq = seq;
-      stream.ring.put(stream.receivedLength, payload);
-      stream.receivedLength += Slice_length(payload);
-    }
-  } else if (stream.currentSeq >= 0) {
-    if (Slice_length(payload)) {
-      uint64_t start = stream.receivedLength;
-      if (seq >= stream.currentSeq) {
-        start += seq - stream.currentSeq;
-        stream.currentSeq = seq;
-        stream.ring.put(stream.receivedLength, payload);
-        stream.receivedLength += Slice_length(payload);
-      } else if (stream.currentSeq - seq > window) {
-        start += (UINT32_MAX - stream.currentSeq) + seq;
-        stream.currentSeq = seq;
-        stream.ring.put(stream.receivedLength, payload);
-        stream.receivedLength += Slice_length(payload);
+  if (syn && !stream.established) {
+    stream.established = true;
+    stream.initialSeq = seq + 1;
+  }
+  if (stream.established && Slice_length(payload) > 0) {
+    // The SYN itself occupies one sequence number before the data.
+    uint32_t offset = syn ? 0 : seq - stream.initialSeq;
+    int64_t pos = unwrap(offset, stream.position);
+    int64_t end = pos + Slice_length(payload);
+    if (end > 0) {
+      Slice slice = payload;
+      if (pos < 0) {
+        slice = Slice_sliceAll(slice, -pos);
+        pos = 0;
+      }
+      size_t usage = stream.reassembler.memoryUsage();
+      stream.reassembler.put(pos, slice);
+      stream.position = std::max<uint64_t>(stream.position, end);
+      if (usage != stream.reassembler.memoryUsage()) {
+        FlowTable_setSize(worker->idMap, id, sizeof(key), stream.footprint());
       }
-    } else if ((stream.currentSeq + 1) % UINT32_MAX == seq) {
-      stream.currentSeq = seq;
     }
   }
 
-  const auto slices = stream.ring.fetch();
+  auto &slices = worker->slices;
+  slices.clear();
+  stream.reassembler.fetch(&slices);
   if (slices.size() > 0) {
     Payload *chunk = Layer_addPayload(layer);
     Payload_setType(chunk, reassembledToken);
@@ -146,24 +181,56 @@ void analyze(Context *ctx, const Dissector *diss, Worker data, Layer *layer) {
     }
   }
 
+  bool fin = (flags & 0x1);
+  bool rst = (flags & (0x1 << 2));
+  if (fin || rst) {
+    FlowTable_close(worker->idMap, id, sizeof(key), time);
+  }
+
   Layer *sub = Layer_addSubLayer(layer, tcpStreamToken);
   Layer_addTag(sub, tcpStreamToken);
+
+  Context_setWorkerMemory(ctx, sizeof(TCPWorker) +
+                                   FlowTable_stats(worker->idMap).bytes +
+                                   slices.capacity() * sizeof(Slice));
 }
 } // namespace
 
 void Init(v8::Local<v8::Object> exports) {
   static Dissector diss;
-  diss.layerHints[0] = Token_get("tcp");
+  diss.layerHints[0] = Token_const("tcp");
   diss.analyze = analyze;
   diss.createWorker = [](Context *ctx, const Dissector *diss) {
-    return Worker{new TCPWorker()};
+    auto options =
+        Variant_mapValue(Context_options(ctx), "dissector-essentials", -1);
+    const uint64_t second = 1000000000;
+    TCPWorker *worker = new TCPWorker();
+    worker->idMap = FlowTable_create(
+        [](void *value, void *data) { delete static_cast<Stream *>(value); },
+        nullptr);
+    FlowTable_setIdleTimeout(
+        worker->idMap,
+        Variant_uint64(Variant_mapValue(options, "tcpIdleTimeout", -1)) *
+            second);
+    FlowTable_setClosedTimeout(
+        worker->idMap,
+        Variant_uint64(Variant_mapValue(options, "tcpClosedTimeout", -1)) *
+            second);
+    FlowTable_setMemoryLimit(
+        worker->idMap,
+        Variant_uint64(Variant_mapValue(options, "tcpMemoryLimit", -1)) *
+            1024 * 1024);
+    return Worker{worker};
   };
   diss.destroyWorker = [](Context *ctx, const Dissector *diss, Worker data) {
     TCPWorker *worker = static_cast<TCPWorker *>(data.data);
+    FlowTable_destroy(worker->idMap);
     delete worker;
   };
   exports->Set(Nan::New("dissector").ToLocalChecked(),
                Nan::New<v8::External>(&diss));
+  exports->Set(Nan::New("tokenKeywords").ToLocalChecked(),
+               Nan::New(Token_keywordCount));
 }
 
 NODE_MODULE(dissectorEssentials, Init);
@@ -2,6 +2,7 @@
 #include <plugkit/attribute.h>
 #include <plugkit/context.h>
 #include <plugkit/dissector.h>
+#include <plugkit/fixed_layer.h>
 #include <plugkit/layer.h>
 #include <plugkit/payload.h>
 #include <plugkit/reader.h>
@@ -11,55 +12,41 @@
 
 using namespace plugkit;
 
-const auto udpToken = Token_get("udp");
-const auto srcToken = Token_get(".src");
-const auto dstToken = Token_get(".dst");
-const auto lengthToken = Token_get("udp.length");
-const auto checksumToken = Token_get("udp.checksum");
+constexpr Token udpToken = Token_const("udp");
+constexpr Token srcToken = Token_const(".src");
+constexpr Token dstToken = Token_const(".dst");
+constexpr Token lengthToken = Token_const("udp.length");
+constexpr Token checksumToken = Token_const("udp.checksum");
 
-namespace {
-void analyze(Context *ctx, const Dissector *diss, Worker data, Layer *layer) {
-  Reader reader;
-  Reader_reset(&reader);
-  reader.data = Payload_slices(Layer_payloads(layer, nullptr)[0], nullptr)[0];
-
-  Layer *child = Layer_addLayer(layer, udpToken);
-  Layer_addTag(child, udpToken);
-
-  const auto &parentSrc = Layer_attr(layer, srcToken);
-  const auto &parentDst = Layer_attr(layer, dstToken);
-
-  uint16_t sourcePort = Reader_getUint16(&reader, false);
-  Attr *src = Layer_addAttr(child, srcToken);
-  Attr_setUint32(src, sourcePort);
-  Attr_setRange(src, reader.lastRange);
+enum { LENGTH_FIELD = 2 };
 
-  uint16_t dstPort = Reader_getUint16(&reader, false);
-  Attr *dst = Layer_addAttr(child, dstToken);
-  Attr_setUint32(dst, dstPort);
-  Attr_setRange(dst, reader.lastRange);
+constexpr Field fields[] = {
+    {srcToken, 0, 0, 2},
+    {dstToken, 0, 2, 2},
+    {lengthToken, 0, 4, 2},
+    {checksumToken, 0, 6, 2},
+};
 
-  uint32_t lengthNumber = Reader_getUint16(&reader, false);
-  Attr *length = Layer_addAttr(child, lengthToken);
-  Attr_setUint32(length, lengthNumber);
-  Attr_setRange(length, reader.lastRange);
-
-  uint32_t checksumNumber = Reader_getUint16(&reader, false);
-  Attr *checksum = Layer_addAttr(child, checksumToken);
-  Attr_setUint32(checksum, checksumNumber);
-  Attr_setRange(checksum, reader.lastRange);
-
-  Payload *chunk = Layer_addPayload(child);
-  Payload_addSlice(chunk, Reader_slice(&reader, 0, lengthNumber - 8));
+namespace {
+void analyzePayload(Context *ctx, Layer *layer, Reader *reader,
+                    Attr *const *attrs) {
+  uint32_t lengthNumber = Attr_uint32(attrs[LENGTH_FIELD]);
+  Payload *chunk = Layer_addPayload(layer);
+  Payload_addSlice(chunk, Reader_slice(reader, 0, lengthNumber - 8));
 }
+
+constexpr FixedLayer udp = {udpToken, Layout_make(fields), nullptr, 0, 0,
+                            analyzePayload};
 } // namespace
 
 void Init(v8::Local<v8::Object> exports) {
   static Dissector diss;
-  diss.layerHints[0] = (Token_get("[udp]"));
-  diss.analyze = analyze;
+  diss.layerHints[0] = (Token_const("[udp]"));
+  diss.analyze = FixedLayer_analyze<udp>;
   exports->Set(Nan::New("dissector").ToLocalChecked(),
                Nan::New<v8::External>(&diss));
+  exports->Set(Nan::New("tokenKeywords").ToLocalChecked(),
+               Nan::New(Token_keywordCount));
 }
 
 NODE_MODULE(dissectorEssentials, Init);
@@ -44,6 +44,8 @@ export default class FrameListView {
     this.viewHeight = 0
     this.mapHeight = mapResolution
     this.previousScrollTop = 0
+    this.following = true
+    this.filterLimit = null
     this.selectedFrames = []
 
     Channel.on('core:frame:selected', (frames) => {
@@ -70,6 +72,7 @@ export default class FrameListView {
     Channel.on('core:pcap:session-created', (sess) => {
       this.session = sess
       this.filtered = null
+      this.filterLimit = null
       this.session.on('frame', (stat) => {
         this.frame = stat
         m.redraw()
@@ -84,6 +87,7 @@ export default class FrameListView {
     Channel.on('core:display-filter:set', (filter) => {
       if (this.session) {
         this.session.setDisplayFilter('main', filter)
+        this.filterLimit = null
       }
     })
   }
@@ -105,7 +109,8 @@ export default class FrameListView {
     this.updateMapThrottle(vnode)
 
     const maxScrollTop = this.frameView.scrollHeight - this.frameView.clientHeight
-    if (this.previousScrollTop <= this.frameView.scrollTop) {
+    this.following = (this.previousScrollTop <= this.frameView.scrollTop)
+    if (this.following) {
       this.frameView.scrollTop = maxScrollTop
       this.previousScrollTop = maxScrollTop
     } else {
@@ -143,19 +148,55 @@ export default class FrameListView {
     }
   }
 
+  updateFilterLimit(end, rows) {
+    // Stops the scan once the matches up to a page below the viewport are
+    // found, unless the list follows the end of the capture.
+    const limit = this.following ? 0 : end + rows
+    if (limit !== this.filterLimit) {
+      this.filterLimit = limit
+      this.session.setFilterLimit('main', limit)
+    }
+  }
+
+  filteredFrames(begin, end, tail) {
+    const list = this.session.getFilteredFrames('main', begin, (end - begin))
+    if (tail === null) {
+      return list
+    }
+
+    // The rows at the bottom are filled with the matches nearest to the end
+    // of the capture until the scan reaches them.
+    const last = tail.slice(Math.max(0, tail.length - (end - begin)))
+    const head = list.slice(0, (end - begin) - last.length)
+      .filter((id) => last.length === 0 || id < last[0])
+    return (new Array((end - begin) - last.length - head.length))
+      .fill(0).concat(head, last)
+  }
+
   view(vnode) {
-    const frames = (this.filtered ? this.filtered.frames : this.frame.frames)
     const itemHeight = 30
-    const viewHeight = frames * itemHeight
     const margin = 5
+    const rows = Math.ceil(this.viewHeight / itemHeight) + margin * 2
+
+    let frames = this.frame.frames
+    let tail = null
+    if (this.filtered) {
+      frames = this.filtered.frames
+      if (this.following) {
+        tail = this.session.getNearestFrames('main', this.frame.frames, rows)
+        frames = Math.max(frames, tail.length)
+      }
+    }
+
+    const viewHeight = frames * itemHeight
     const begin = Math.max(0,
       Math.floor(Math.min(this.viewScrollTop, viewHeight - this.viewHeight) / itemHeight) - margin)
-    const end = Math.min(begin +
-      Math.ceil(this.viewHeight / itemHeight) + margin * 2, frames)
+    const end = Math.min(begin + rows, frames)
 
     let filterdFrames = null
     if (this.filtered) {
-      filterdFrames = this.session.getFilteredFrames('main', begin, (end - begin))
+      this.updateFilterLimit(end, rows)
+      filterdFrames = this.filteredFrames(begin, end, tail)
     }
 
     return [
@@ -185,6 +226,9 @@ export default class FrameListView {
           {
             (new Array(end - begin)).fill().map((dev, index) => {
               const id = filterdFrames ? filterdFrames[index] : (index + begin + 1)
+              if (id === 0) {
+                return null
+              }
               const selected = this.selectedFrames.some((frame) => frame.index === id )
               return m(FrameItem, {
                 key: id,
@@ -5,20 +5,21 @@ import { Channel } from 'deplug'
 export default class StreamView {
   constructor() {
     this.session = null
+    this.streamId = null
     this.payloads = []
     this.frames = 0
     this.length = 0
 
     Channel.on('core:frame:selected', (frames) => {
+      this.streamId = null
       this.payloads = []
       this.frames = 0
       this.length = 0
       if (frames.length) {
         const id = frames[0].attr('tcp.streamId')
         if (id) {
-          if (this.session) {
-            this.session.setDisplayFilter('stream-panel', `tcp.streamId === ${id.value}`)
-          }
+          this.streamId = id.value
+          this.update()
         }
       }
       m.redraw()
@@ -26,26 +27,37 @@ export default class StreamView {
 
     Channel.on('core:pcap:session-created', (sess) => {
       this.session = sess
-      this.session.on('filter', (stat) => {
-        if ('stream-panel' in stat) {
-          const { frames } = stat['stream-panel']
-          const indices = this.session.getFilteredFrames('stream-panel', this.frames, frames - this.frames)
-          for (const index of indices) {
-            const tcp = this.session.getFrames(index - 1, 1)[0].layer('tcp')
-            for (const payload of tcp.payloads) {
-              if (payload.type === '@reassembled') {
-                this.payloads.push(payload)
-                this.length += payload.length
-              }
-            }
-          }
-          this.frames = frames
+      this.session.on('frame', () => {
+        if (this.update()) {
+          m.redraw()
         }
-        m.redraw()
       })
     })
   }
 
+  update() {
+    if (this.session === null || this.streamId === null) {
+      return false
+    }
+    const indices = this.session.getIndexedFrames('tcp.streamId', this.streamId, this.frames)
+    let read = 0
+    for (const index of indices) {
+      if (index > this.session.frame.frames) {
+        break
+      }
+      read += 1
+      const tcp = this.session.getFrames(index - 1, 1)[0].layer('tcp')
+      for (const payload of tcp.payloads) {
+        if (payload.type === '@reassembled') {
+          this.payloads.push(payload)
+          this.length += payload.length
+        }
+      }
+    }
+    this.frames += read
+    return read > 0
+  }
+
   view(vnode) {
     return <div class="stream-view">{ this.length } bytes</div>
   }
@@ -1,5 +1,5 @@
 import { File, PluginLoader, Profile, Session, Tab, Channel, GlobalChannel } from 'deplug'
-import { Pcap, SessionFactory } from 'plugkit'
+import { Pcap, SessionFactory, bpf } from 'plugkit'
 import m from 'mithril'
 
 class PermissionMassage {
@@ -71,6 +71,8 @@ export default class ConfigView {
     const opt = ifsSelector.options[ifsSelector.selectedIndex]
     const ifs = opt.value
     const ifsName = opt.getAttribute('data-name')
+    const filter = vnode.dom.querySelector('[name=filter]').value.trim()
+    const captureMatching = vnode.dom.querySelector('[name=capture-matching]').checked
     Object.assign(Tab.options, {
       ifs,
       ifsName
@@ -80,11 +82,19 @@ export default class ConfigView {
     setTimeout(() => {
       const factory = prepareSession()
       factory.snaplen = Profile.current.get('_', 'snaplen')
+      if (captureMatching && filter.length) {
+        // Frames rejected by the translated part of the filter are dropped
+        // in the kernel; the display filter still applies the rest.
+        factory.bpf = bpf(filter) || ''
+      }
       factory.create().then((sess) => {
         if (Tab.options.ifs) {
           sess.startPcap()
         }
         Channel.emit('core:pcap:session-created', sess)
+        if (filter.length) {
+          Channel.emit('core:display-filter:set', filter)
+        }
       }, (err) => {
         console.log(err)
       })
@@ -138,6 +148,15 @@ export default class ConfigView {
           }
           </select>
         </li>
+        <li>
+          <input type="text" name="filter" placeholder="Display Filter"></input>
+        </li>
+        <li>
+          <label>
+            <input type="checkbox" name="capture-matching"></input>
+            Capture only matching frames
+          </label>
+        </li>
         <li>
           <input
             type="button"
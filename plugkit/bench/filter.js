@@ -0,0 +1,34 @@
+/* eslint-disable no-console */
+const fs = require('fs')
+const path = require('path')
+const esprima = require('esprima')
+const escodegen = require('escodegen')
+const transform = require('../transform')
+const {Testing} = require('../test')
+
+const filterScript = fs.readFileSync(path.join(__dirname, '../filter.js'))
+const attributes = {
+  eth: {},
+  ipv4: {},
+  tcp: {},
+  'tcp.src': {},
+  'tcp.dst': {},
+}
+const filters = [
+  'tcp.dst == 80',
+  'tcp.dst >= 1024',
+  '1024 < tcp.src && tcp.dst != 443',
+  'tcp.dst.value & 1',
+]
+const frames = 100000
+
+for (const filter of filters) {
+  const ast = transform(esprima.parse(filter), [], attributes)
+  const body = filterScript + escodegen.generate(ast)
+  const result = Testing.runFilterBenchmark(body, JSON.stringify(ast), frames)
+  console.log(filter)
+  for (const name of ['script', 'interpreter', 'specialized', 'jit']) {
+    const {nsPerFrame, matches} = result[name]
+    console.log(`  ${name}:\t${nsPerFrame.toFixed(1)} ns/frame\t${matches} matches`)
+  }
+}
@@ -8,6 +8,7 @@
       "src/worker_thread.cpp",
       "src/filter_thread.cpp",
       "src/filter_thread_pool.cpp",
+      "src/filter_scan.cpp",
       "src/dissector_thread.cpp",
       "src/dissector_thread_pool.cpp",
       "src/stream_dissector_thread.cpp",
@@ -17,6 +18,9 @@
       "src/frame_view.cpp",
       "src/frame_store.cpp",
       "src/filter.cpp",
+      "src/filter_program.cpp",
+      "src/filter_jit.cpp",
+      "src/bitmap.cpp",
       "src/token.cpp",
       "src/logger.cpp",
       "src/context.cpp",
@@ -40,12 +44,15 @@
       "src/script_dissector.cpp",
       "src/frame.cpp",
       "src/attribute.cpp",
+      "src/attribute_index.cpp",
       "src/payload.cpp",
       "src/layer.cpp",
       "src/slice.cpp",
       "src/reader.cpp",
       "src/stream_reader.cpp",
       "src/tag_filter.cpp",
+      "src/flow.cpp",
+      "src/flow_table.cpp",
       "src/capi.c",
       "vendor/json11/json11.cpp"
     ]
@@ -128,8 +135,21 @@
         "test/tag_filter_test.cpp",
         "test/slice_test.cpp",
         "test/reader_test.cpp",
+        "test/fixed_layer_test.cpp",
+        "test/dissector_test.cpp",
+        "test/dissector_thread_test.cpp",
         "test/stream_reader_test.cpp",
-        "test/payload_test.cpp"
+        "test/payload_test.cpp",
+        "test/layer_test.cpp",
+        "test/flow_test.cpp",
+        "test/flow_table_test.cpp",
+        "test/frame_view_test.cpp",
+        "test/filter_program_test.cpp",
+        "test/filter_jit_test.cpp",
+        "test/bitmap_test.cpp",
+        "test/filter_scan_test.cpp",
+        "test/filter_thread_pool_test.cpp",
+        "test/attribute_index_test.cpp"
       ],
       "xcode_settings":{
         "GCC_ENABLE_CPP_EXCEPTIONS":"YES"
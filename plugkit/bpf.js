@@ -0,0 +1,191 @@
+const esprima = require('esprima')
+
+const layers = {
+  ipv4: 'ip',
+  ipv6: 'ip6',
+  tcp: 'tcp',
+  udp: 'udp',
+}
+
+// Only attributes emitted by the dissectors are listed. Any other path is
+// null in the display filter, so translating it would drop frames the
+// display filter accepts.
+const hosts = {
+  'ipv4.src': 'ip src host',
+  'ipv4.dst': 'ip dst host',
+}
+
+const ports = {
+  'tcp.src': 'tcp src',
+  'tcp.dst': 'tcp dst',
+  'udp.src': 'udp src',
+  'udp.dst': 'udp dst',
+}
+
+const reversed = {
+  '<': '>',
+  '<=': '>=',
+  '>': '<',
+  '>=': '<=',
+  '==': '==',
+  '===': '===',
+  '!=': '!=',
+  '!==': '!==',
+}
+
+function path(node) {
+  const identifiers = []
+  while (node.type === 'MemberExpression' && !node.computed) {
+    identifiers.unshift(node.property.name)
+    node = node.object
+  }
+  if (node.type !== 'Identifier') {
+    return null
+  }
+  identifiers.unshift(node.name)
+  return identifiers.join('.')
+}
+
+function number(node) {
+  if (node.type === 'Literal' && Number.isInteger(node.value)) {
+    return node.value
+  }
+  return null
+}
+
+function address(node) {
+  let bytes = null
+  if (node.type === 'TemplateLiteral' && node.expressions.length === 0) {
+    bytes = node.quasis[0].value.cooked.split('.').map((n) => parseInt(n, 10))
+  } else if (node.type === 'ArrayExpression') {
+    bytes = node.elements.map(number)
+  }
+  if (bytes === null || bytes.length !== 4 ||
+      !bytes.every((n) => Number.isInteger(n) && n >= 0 && n <= 255)) {
+    return null
+  }
+  return bytes.join('.')
+}
+
+function port(prefix, operator, value) {
+  if (value < 0 || value > 65535) {
+    return null
+  }
+  switch (operator) {
+    case '==':
+    case '===':
+      return `${prefix} port ${value}`
+    case '!=':
+    case '!==':
+      return `not ${prefix} port ${value}`
+    case '<':
+      return value > 0 ? `${prefix} portrange 0-${value - 1}` : null
+    case '<=':
+      return `${prefix} portrange 0-${value}`
+    case '>':
+      return value < 65535 ? `${prefix} portrange ${value + 1}-65535` : null
+    case '>=':
+      return `${prefix} portrange ${value}-65535`
+  }
+  return null
+}
+
+function compare(operator, left, right) {
+  let name = path(left)
+  let value = right
+  if (!(name in ports) && !(name in hosts)) {
+    name = path(right)
+    value = left
+    operator = reversed[operator]
+  }
+  if (name in ports) {
+    const n = number(value)
+    return n === null ? null : port(ports[name], operator, n)
+  }
+  if (name in hosts) {
+    const addr = address(value)
+    if (addr === null) {
+      return null
+    }
+    switch (operator) {
+      case '==':
+      case '===':
+        return `${hosts[name]} ${addr}`
+      case '!=':
+      case '!==':
+        return `not ${hosts[name]} ${addr}`
+    }
+  }
+  return null
+}
+
+// Returns {expr, exact}. `expr` is null when nothing could be translated.
+// `exact` is false when the expression matches a superset of the frames
+// accepted by the display filter.
+function translate(node) {
+  switch (node.type) {
+    case 'Identifier':
+      if (node.name in layers) {
+        return { expr: layers[node.name], exact: true }
+      }
+      break
+    case 'BinaryExpression':
+      if (node.operator in reversed) {
+        const expr = compare(node.operator, node.left, node.right)
+        if (expr !== null) {
+          return { expr, exact: true }
+        }
+      }
+      break
+    case 'LogicalExpression':
+      {
+        const left = translate(node.left)
+        const right = translate(node.right)
+        if (node.operator === '&&') {
+          // Dropping an untranslatable conjunct only widens the match.
+          const exprs = [left, right].filter((e) => e.expr !== null)
+          if (exprs.length === 0) {
+            break
+          }
+          return {
+            expr: exprs.map((e) => `(${e.expr})`).join(' and '),
+            exact: left.exact && right.exact
+          }
+        } else if (node.operator === '||') {
+          if (left.expr === null || right.expr === null) {
+            break
+          }
+          return {
+            expr: `(${left.expr}) or (${right.expr})`,
+            exact: left.exact && right.exact
+          }
+        }
+      }
+      break
+    case 'UnaryExpression':
+      if (node.operator === '!') {
+        const arg = translate(node.argument)
+        if (arg.expr !== null && arg.exact) {
+          return { expr: `not (${arg.expr})`, exact: true }
+        }
+      }
+      break
+    default:
+  }
+  return { expr: null, exact: false }
+}
+
+// Translates the capturable subset of a display filter into a pcap filter
+// expression, or returns null if no part of it can be evaluated by BPF.
+module.exports = function bpf(filter) {
+  let ast = null
+  try {
+    ast = esprima.parse(filter)
+  } catch (err) {
+    return null
+  }
+  if (ast.body.length !== 1 || ast.body[0].type !== 'ExpressionStatement') {
+    return null
+  }
+  return translate(ast.body[0].expression).expr
+}
@@ -143,6 +143,8 @@ function $_op(opcode, ...args) {
       return left > right
     case '<=':
       return left <= right
+    case '>=':
+      return left >= right
     case '<<':
       return left << right
     case '>>':
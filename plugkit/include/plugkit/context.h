@@ -17,6 +17,12 @@ PLUGKIT_EXPORT void Context_dealloc(Context *ctx, void *ptr);
 /// Gets options.
 PLUGKIT_EXPORT const Variant *Context_options(Context *ctx);
 
+/// Reports the bytes retained by the stream worker being called.
+///
+/// Stream dissectors call this from analyze(), so that the stream memory
+/// limit covers their per-flow state such as reassembly buffers.
+PLUGKIT_EXPORT void Context_setWorkerMemory(Context *ctx, size_t bytes);
+
 PLUGKIT_NAMESPACE_END
 
 #endif
@@ -4,6 +4,7 @@
 #include "export.h"
 #include "token.h"
 #include <stdbool.h>
+#include <stddef.h>
 
 PLUGKIT_NAMESPACE_BEGIN
 
@@ -18,6 +19,8 @@ typedef void(TerminateFunc)(Context *ctx, Dissector *);
 typedef Worker(CreateWorkerFunc)(Context *ctx, const Dissector *);
 typedef void(DestroyWorkerFunc)(Context *ctx, const Dissector *, Worker);
 typedef void(AnalyzeFunc)(Context *ctx, const Dissector *, Worker, Layer *);
+typedef void(AnalyzeBatchFunc)(Context *ctx, const Dissector *, Worker,
+                               Layer **layers, size_t size);
 
 typedef struct Dissector {
   IntializeFunc *initialize;
@@ -27,10 +30,26 @@ typedef struct Dissector {
   AnalyzeFunc *analyze;
   Token layerHints[8];
   void *data;
+
+  /// Optional. If set, it is called instead of analyze with all the layers
+  /// of a batch of frames which match layerHints, in frame order.
+  ///
+  /// Only read from dissectors set up by Dissector_init().
+  AnalyzeBatchFunc *analyzeBatch;
 } Dissector;
 
+/// Zeroes the fields up to `data`.
+///
+/// Plugins built against older headers call this with a shorter struct, so
+/// the fields appended since are left untouched.
 PLUGKIT_EXPORT void Dissector_reset(Dissector *diss);
 
+/// Zeroes all the fields and marks the dissector as built against this
+/// header, so that the fields appended after `data` are read.
+///
+/// `diss` should have static storage, as exported dissectors do.
+PLUGKIT_EXPORT void Dissector_init(Dissector *diss);
+
 PLUGKIT_NAMESPACE_END
 
 #endif
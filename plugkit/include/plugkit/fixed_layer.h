@@ -0,0 +1,91 @@
+/// @file
+/// Dissectors for fixed-format protocols
+#ifndef PLUGKIT_FIXED_LAYER_H
+#define PLUGKIT_FIXED_LAYER_H
+
+#ifdef __cplusplus
+#include "attribute.h"
+#include "dissector.h"
+#include "layer.h"
+#include "payload.h"
+#include "reader.h"
+
+namespace plugkit {
+
+/// Maps a field value to a layer tag and a boolean attribute.
+struct FieldTag {
+  uint64_t value;
+  Token tag;
+  Token id;
+};
+
+/// Analyzes the rest of a layer after the fixed fields have been added.
+/// `attrs` holds the attributes of the layout fields in order.
+typedef void(FixedLayerFunc)(Context *ctx, Layer *layer, Reader *reader,
+                             Attr *const *attrs);
+
+/// Describes a protocol which starts with a fixed header.
+///
+/// If `tagLength` is not 0, the value of `fields[tagField]` is looked up in
+/// `tags` and the matching tag and attribute are added. If `analyze` is null,
+/// the bytes after the header become the payload of the layer; otherwise
+/// `analyze` has to add the payload.
+struct FixedLayer {
+  Token id;
+  Layout layout;
+  const FieldTag *tags;
+  size_t tagLength;
+  size_t tagField;
+  FixedLayerFunc *analyze;
+};
+
+/// Returns an AnalyzeFunc specialized for a given fixed-format protocol.
+///
+/// @code
+/// constexpr Field fields[] = {
+///     {Token_const(".src"), 0, 0, 2},
+///     {Token_const(".dst"), 0, 2, 2},
+/// };
+/// constexpr FixedLayer udp = {Token_const("udp"), Layout_make(fields)};
+///
+/// diss.analyze = FixedLayer_analyze<udp>;
+/// @endcode
+template <const FixedLayer &L>
+void FixedLayer_analyze(Context *ctx, const Dissector *diss, Worker worker,
+                        Layer *layer) {
+  Reader reader;
+  Reader_reset(&reader);
+  reader.data = Payload_slices(Layer_payloads(layer, nullptr)[0], nullptr)[0];
+
+  Layer *child = Layer_addLayer(layer, L.id);
+  Layer_addTag(child, L.id);
+
+  Attr *attrs[L.layout.length];
+  Reader_readLayout(&reader, &L.layout, child, attrs);
+
+  if (L.tagLength > 0) {
+    const Attr *field = attrs[L.tagField];
+    uint64_t value = Attr_uint64(field);
+    for (size_t i = 0; i < L.tagLength; ++i) {
+      if (L.tags[i].value == value) {
+        Attr *attr = Layer_addAttr(child, L.tags[i].id);
+        Attr_setBool(attr, true);
+        Attr_setRange(attr, Attr_range(field));
+        Layer_addTag(child, L.tags[i].tag);
+        break;
+      }
+    }
+  }
+
+  FixedLayerFunc *analyze = L.analyze;
+  if (analyze) {
+    analyze(ctx, child, &reader, attrs);
+  } else {
+    Payload *chunk = Layer_addPayload(child);
+    Payload_addSlice(chunk, Reader_sliceAll(&reader, 0));
+  }
+}
+} // namespace plugkit
+#endif
+
+#endif
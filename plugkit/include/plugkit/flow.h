@@ -0,0 +1,46 @@
+/// @file
+/// Flow identification
+#ifndef PLUGKIT_FLOW_H
+#define PLUGKIT_FLOW_H
+
+#include "export.h"
+#include "slice.h"
+#include <stdint.h>
+
+PLUGKIT_NAMESPACE_BEGIN
+
+/// Fixed-size key identifying one direction of a flow.
+///
+/// Addresses are zero-padded so that keys can be compared and hashed as
+/// plain bytes, e.g. by FlowTable.
+typedef struct FlowKey {
+  uint8_t src[16];
+  uint8_t dst[16];
+  uint16_t srcPort;
+  uint16_t dstPort;
+  uint8_t srcLength;
+  uint8_t dstLength;
+  uint8_t protocol;
+  uint8_t reserved;
+} FlowKey;
+
+/// Fills the key with the given 5-tuple.
+///
+/// Addresses longer than 16 bytes are truncated.
+PLUGKIT_EXPORT void FlowKey_set(FlowKey *key, Slice src, Slice dst,
+                                uint16_t srcPort, uint16_t dstPort,
+                                uint8_t protocol);
+
+/// Returns a 32-bit hash of the given 5-tuple.
+///
+/// The hash is symmetric: swapping the source and destination endpoints
+/// gives the same value, so both directions of a connection are routed to the
+/// same stream dissector thread.
+/// Addresses longer than 16 bytes are truncated.
+/// @remarks This function is thread-safe.
+PLUGKIT_EXPORT uint32_t Flow_hash(Slice src, Slice dst, uint16_t srcPort,
+                                  uint16_t dstPort, uint8_t protocol);
+
+PLUGKIT_NAMESPACE_END
+
+#endif
@@ -0,0 +1,97 @@
+/// @file
+/// Flow table
+#ifndef PLUGKIT_FLOW_TABLE_H
+#define PLUGKIT_FLOW_TABLE_H
+
+#include "export.h"
+#include <stddef.h>
+#include <stdint.h>
+
+PLUGKIT_NAMESPACE_BEGIN
+
+typedef struct FlowTable FlowTable;
+
+/// Called when an entry is removed from the table.
+typedef void(FlowTableDestroyFunc)(void *value, void *data);
+
+typedef struct FlowTableStats {
+  uint64_t flows;
+  uint64_t bytes;
+  uint64_t inserted;
+  uint64_t lookups;
+  uint64_t hits;
+  uint64_t expired;
+  uint64_t closed;
+  uint64_t evicted;
+} FlowTableStats;
+
+/// Allocates a new FlowTable.
+///
+/// `destroy` is called with `data` for every value leaving the table,
+/// whether it expires, gets evicted or the table is destroyed.
+PLUGKIT_EXPORT FlowTable *FlowTable_create(FlowTableDestroyFunc *destroy,
+                                           void *data);
+
+/// Destroys the table and every value in it.
+PLUGKIT_EXPORT void FlowTable_destroy(FlowTable *table);
+
+/// Sets the idle timeout in nanoseconds.
+///
+/// Entries which have not been accessed for longer are removed.
+/// 0 disables the timeout. (default: 0)
+PLUGKIT_EXPORT void FlowTable_setIdleTimeout(FlowTable *table,
+                                             uint64_t timeout);
+
+/// Sets the timeout in nanoseconds for entries marked by FlowTable_close().
+///
+/// 0 removes them on the next access to the table. (default: 0)
+PLUGKIT_EXPORT void FlowTable_setClosedTimeout(FlowTable *table,
+                                               uint64_t timeout);
+
+/// Sets the memory limit in bytes.
+///
+/// The least recently used entries are evicted while the total size of the
+/// entries exceeds the limit. Closed entries are evicted first.
+/// 0 disables the limit. (default: 0)
+PLUGKIT_EXPORT void FlowTable_setMemoryLimit(FlowTable *table, size_t bytes);
+
+/// Finds the value with the given key and marks it as accessed at `time`.
+///
+/// If no entry is found, returns nullptr.
+PLUGKIT_EXPORT void *FlowTable_find(FlowTable *table, const char *key,
+                                    size_t length, uint64_t time);
+
+/// Inserts a value with the given key.
+///
+/// `size` is the approximate memory footprint of the value in bytes.
+/// An existing value with the same key is destroyed and replaced.
+PLUGKIT_EXPORT void FlowTable_insert(FlowTable *table, const char *key,
+                                     size_t length, void *value, size_t size,
+                                     uint64_t time);
+
+/// Updates the approximate memory footprint of the value with the given key.
+PLUGKIT_EXPORT void FlowTable_setSize(FlowTable *table, const char *key,
+                                      size_t length, size_t size);
+
+/// Marks the entry with the given key as closed, e.g. on TCP FIN or RST.
+PLUGKIT_EXPORT void FlowTable_close(FlowTable *table, const char *key,
+                                    size_t length, uint64_t time);
+
+/// Removes the entry with the given key.
+PLUGKIT_EXPORT void FlowTable_remove(FlowTable *table, const char *key,
+                                     size_t length);
+
+/// Removes the entries which have timed out at `time`.
+///
+/// FlowTable_find() and FlowTable_insert() call this implicitly.
+PLUGKIT_EXPORT void FlowTable_expire(FlowTable *table, uint64_t time);
+
+/// Returns the number of entries.
+PLUGKIT_EXPORT size_t FlowTable_size(const FlowTable *table);
+
+/// Returns the counters.
+PLUGKIT_EXPORT FlowTableStats FlowTable_stats(const FlowTable *table);
+
+PLUGKIT_NAMESPACE_END
+
+#endif
@@ -31,10 +31,18 @@ PLUGKIT_EXPORT void Layer_setConfidence(Layer *layer,
                                         LayerConfidence confidence);
 
 /// Gets worker
-PLUGKIT_EXPORT uint8_t Layer_worker(const Layer *layer);
+PLUGKIT_EXPORT uint32_t Layer_worker(const Layer *layer);
 
 /// Sets worker
-PLUGKIT_EXPORT void Layer_setWorker(Layer *layer, uint8_t id);
+///
+/// Stream layers sharing the same worker id are dissected on the same thread.
+/// Use a well-distributed value such as Flow_hash().
+PLUGKIT_EXPORT void Layer_setWorker(Layer *layer, uint32_t id);
+
+/// Gets the timestamp of the frame in nanoseconds since the epoch.
+///
+/// Returns 0 if the layer does not belong to a frame.
+PLUGKIT_EXPORT uint64_t Layer_timestamp(const Layer *layer);
 
 /// Gets parent layer
 PLUGKIT_EXPORT const Layer *Layer_parent(const Layer *layer);
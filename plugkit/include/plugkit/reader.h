@@ -8,12 +8,51 @@
 
 PLUGKIT_NAMESPACE_BEGIN
 
+typedef struct Layer Layer;
+typedef struct Attr Attr;
+
 typedef struct Reader {
   Slice data;
   Range lastRange;
   Token lastError;
 } Reader;
 
+typedef enum {
+  /// The field is stored in little endian. Big endian is the default.
+  FIELD_LITTLE_ENDIAN = 1 << 0,
+
+  /// The field is a two's complement integer.
+  FIELD_SIGNED = 1 << 1,
+
+  /// The field is a boolean which is true if any selected bit is set.
+  FIELD_BOOL = 1 << 2,
+
+  /// The field is a byte sequence.
+  FIELD_SLICE = 1 << 3
+} FieldFlag;
+
+/// A field at a fixed position of a header.
+///
+/// Numeric fields are 1, 2, 4 or 8 bytes long. After the byte order is
+/// resolved, the value is shifted right by `shift` bits and masked with
+/// `mask` unless `mask` is 0.
+typedef struct Field {
+  Token id;
+  Token type;
+  uint16_t offset;
+  uint16_t size;
+  uint8_t flags;
+  uint8_t shift;
+  uint64_t mask;
+} Field;
+
+/// A list of fields and the number of bytes they cover.
+typedef struct Layout {
+  const Field *fields;
+  size_t length;
+  size_t size;
+} Layout;
+
 /// Clears Reader's state
 PLUGKIT_EXPORT void Reader_reset(Reader *reader);
 PLUGKIT_EXPORT Slice Reader_slice(Reader *reader, size_t begin, size_t end);
@@ -33,6 +72,43 @@ PLUGKIT_EXPORT int64_t Reader_getInt64(Reader *reader, bool littleEndian);
 PLUGKIT_EXPORT float Reader_getFloat32(Reader *reader, bool littleEndian);
 PLUGKIT_EXPORT double Reader_getFloat64(Reader *reader, bool littleEndian);
 
+/// Adds an attribute to a layer for each field of a layout, which starts at
+/// the current position, and moves the reader past the layout.
+///
+/// The bounds are checked once for the whole layout. If the data is too
+/// short, lastError is set and the fields out of bounds are zero or empty.
+/// If `attrs` is not null, it receives the attribute of each field.
+PLUGKIT_EXPORT void Reader_readLayout(Reader *reader, const Layout *layout,
+                                      Layer *layer, Attr **attrs);
+
 PLUGKIT_NAMESPACE_END
 
+#ifdef __cplusplus
+namespace plugkit {
+
+constexpr size_t Layout_size_(const Field *fields, size_t length,
+                              size_t size = 0) {
+  return length == 0
+             ? size
+             : Layout_size_(fields + 1, length - 1,
+                            size > size_t(fields[0].offset) + fields[0].size
+                                ? size
+                                : size_t(fields[0].offset) + fields[0].size);
+}
+
+/// Returns a layout of a given field array.
+///
+/// @code
+/// constexpr Field fields[] = {
+///     {Token_const(".src"), 0, 0, 2},
+///     {Token_const(".dst"), 0, 2, 2},
+/// };
+/// constexpr Layout layout = Layout_make(fields);
+/// @endcode
+template <size_t N> constexpr Layout Layout_make(const Field (&fields)[N]) {
+  return Layout{fields, N, Layout_size_(fields, N)};
+}
+} // namespace plugkit
+#endif
+
 #endif
@@ -21,6 +21,36 @@ PLUGKIT_EXPORT size_t StreamReader_search(StreamReader *reader,
 PLUGKIT_EXPORT Slice StreamReader_read(StreamReader *reader, char *buffer,
                                        size_t length, size_t offset);
 
+/// Releases the slices which end at or before a given offset.
+/// Offsets are not shifted; reading the discarded range yields nothing.
+PLUGKIT_EXPORT void StreamReader_discard(StreamReader *reader, size_t offset);
+
+/// Returns the offset of the cursor.
+PLUGKIT_EXPORT size_t StreamReader_tell(const StreamReader *reader);
+
+/// Moves the cursor forward and returns the number of bytes skipped.
+PLUGKIT_EXPORT size_t StreamReader_advance(StreamReader *reader,
+                                           size_t length);
+
+/// Reads bytes at the cursor without moving it.
+PLUGKIT_EXPORT Slice StreamReader_peek(StreamReader *reader, char *buffer,
+                                       size_t length);
+
+/// Reads bytes from the cursor up to a given delimiter and moves the cursor
+/// past the delimiter.
+///
+/// If lineLength is not null, it receives the number of bytes before the
+/// delimiter, or 0 if the delimiter is not found.
+/// The buffer is used only if the bytes span non-adjacent slices. If they do
+/// not fit in it, the cursor is not moved and the call can be repeated with a
+/// buffer of lineLength bytes.
+/// Returns a slice with null pointers if nothing is read.
+PLUGKIT_EXPORT Slice StreamReader_readUntil(StreamReader *reader,
+                                            char *buffer, size_t length,
+                                            const char *data,
+                                            size_t dataLength,
+                                            size_t *lineLength);
+
 PLUGKIT_NAMESPACE_END
 
 #endif
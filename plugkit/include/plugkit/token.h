@@ -46,4 +46,68 @@ PLUGKIT_EXPORT const char *Token_string(Token token);
 
 PLUGKIT_NAMESPACE_END
 
+#ifdef __cplusplus
+#include "token_keys.h"
+
+namespace plugkit {
+
+constexpr uint32_t Token_hash_(const char *str, uint32_t hash = 2166136261u) {
+  return str[0] == '\0'
+             ? hash
+             : Token_hash_(str + 1,
+                           (hash ^ static_cast<unsigned char>(str[0])) *
+                               16777619u);
+}
+
+constexpr bool Token_equal_(const char *a, const char *b) {
+  return a[0] == b[0] && (a[0] == '\0' || Token_equal_(a + 1, b + 1));
+}
+
+constexpr size_t Token_lowerBound_(uint32_t hash, size_t begin, size_t end) {
+  return begin == end
+             ? begin
+             : Token_keys_[begin + (end - begin) / 2].hash < hash
+                   ? Token_lowerBound_(hash, begin + (end - begin) / 2 + 1,
+                                       end)
+                   : Token_lowerBound_(hash, begin, begin + (end - begin) / 2);
+}
+
+constexpr Token Token_find_(const char *str, uint32_t hash, size_t index) {
+  return index < Token_keyCount_ && Token_keys_[index].hash == hash
+             ? Token_equal_(str, Token_keywords_[Token_keys_[index].token - 1])
+                   ? Token_keys_[index].token
+                   : Token_find_(str, hash, index + 1)
+             : Token_get(str);
+}
+
+/// Number of keywords known to Token_const().
+///
+/// A keyword's token is its position in src/token.keys. The list is
+/// append-only, so a token resolved at compile time stays valid with any
+/// plugkit which knows at least as many keywords. A native module which
+/// uses Token_const() exports this value as `tokenKeywords`, and loading it
+/// fails if plugkit knows fewer keywords.
+constexpr uint32_t Token_keywordCount = Token_keyCount_;
+
+/// Returns a token corresponded with a given keyword at compile time.
+///
+/// Keywords are listed in src/token.keys. The build appends the string
+/// literals passed to Token_get() and Token_const() in the dissector sources
+/// to that list. A constant expression with any other string fails to
+/// compile; evaluated at runtime, it falls back to Token_get().
+///
+/// @code
+/// constexpr Token ipv4Token = Token_const("ipv4");
+/// @endcode
+/// @remarks This function is thread-safe.
+constexpr Token Token_const(const char *str) {
+  return str == nullptr || str[0] == '\0'
+             ? 0
+             : Token_find_(str, Token_hash_(str),
+                           Token_lowerBound_(Token_hash_(str), 0,
+                                             Token_keyCount_));
+}
+} // namespace plugkit
+#endif
+
 #endif
@@ -71,6 +71,10 @@ PLUGKIT_EXPORT const Variant *Variant_mapValue(const Variant *var,
                                                const char *key, int length);
 
 /// Gets a mutable value associated with a given key
+///
+/// If the key does not exist, a new entry is inserted. Entries are stored
+/// in a sorted array, so an insertion invalidates every pointer previously
+/// returned for the same map. Looking up an existing key does not.
 PLUGKIT_EXPORT Variant *Variant_mapValueRef(Variant *var, const char *key,
                                             int length);
 
@@ -6,6 +6,7 @@ const escodegen = require('escodegen')
 const {rollup} = require('rollup')
 const EventEmitter = require('events')
 const transform = require('./transform')
+const bpf = require('./bpf')
 
 const filterScript = fs.readFileSync(path.join(__dirname, 'filter.js'))
 
@@ -48,7 +49,8 @@ class Session extends EventEmitter {
     };
     this.filter = {};
     this.frame = {
-      frames: 0
+      frames: 0,
+      completed: 0
     };
 
     sess.setStatusCallback((status) => {
@@ -100,14 +102,30 @@ class Session extends EventEmitter {
     return internal(this).sess.destroy()
   }
 
-  getFilteredFrames(name, offset, length) {
-    return internal(this).sess.getFilteredFrames(name, offset, length)
+  getFilteredFrames(name, offset, length, op = 'and') {
+    return internal(this).sess.getFilteredFrames(name, offset, length, op)
+  }
+
+  getNearestFrames(name, index, length) {
+    return internal(this).sess.getNearestFrames(name, index, length)
+  }
+
+  getIndexedFrames(name, value, offset = 0, length = 0xffffffff) {
+    return internal(this).sess.getIndexedFrames(name, value, offset, length)
+  }
+
+  getFramesByTime(begin, end) {
+    return internal(this).sess.getFramesByTime(begin, end)
   }
 
   getFrames(offset, length) {
     return internal(this).sess.getFrames(offset, length)
   }
 
+  getStreamThreadStatus() {
+    return internal(this).sess.getStreamThreadStatus()
+  }
+
   analyze(frames) {
     return internal(this).sess.analyze(frames)
   }
@@ -118,7 +136,12 @@ class Session extends EventEmitter {
       internal(this).transforms,
       internal(this).attributes)
     const body = ast.body.length ? (filterScript + escodegen.generate(ast)) : ''
-    return internal(this).sess.setDisplayFilter(name, body)
+    const program = ast.body.length ? JSON.stringify(ast) : ''
+    return internal(this).sess.setDisplayFilter(name, body, program)
+  }
+
+  setFilterLimit(name, limit = 0) {
+    return internal(this).sess.setFilterLimit(name, limit)
   }
 }
 
@@ -172,6 +195,7 @@ class SessionFactory extends kit.SessionFactory {
 }
 
 module.exports = {
+  bpf,
   Layer: kit.Layer,
   Pcap: kit.Pcap,
   SessionFactory,
@@ -33,4 +33,8 @@ Object.defineProperty(Token, 'string', {
   }
 })
 
+Object.defineProperty(Token, 'keywordCount', {
+  value: nativeToken.keywordCount
+})
+
 exports.Token = Token
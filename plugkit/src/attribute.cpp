@@ -1,12 +1,20 @@
 #include "attribute.hpp"
 #include "wrapper/attribute.hpp"
+#include <algorithm>
 #include <iostream>
 
 namespace plugkit {
 
+namespace {
+const size_t indexThreshold = 8;
+}
+
 Attr::Attr(Token id, const Variant &value, Token type)
     : mId(id), mValue(value), mType(type) {}
 
+Attr::Attr(Token id, Variant &&value, Token type)
+    : mId(id), mValue(std::move(value)), mType(type) {}
+
 Attr::~Attr() {}
 
 Token Attr::id() const { return mId; }
@@ -15,7 +23,7 @@ Range Attr::range() const { return mRange; }
 
 void Attr::setRange(const Range &range) { mRange = range; }
 
-Variant Attr::value() const { return mValue; }
+const Variant &Attr::value() const { return mValue; }
 
 const Variant *Attr::valueRef() const { return &mValue; }
 
@@ -23,10 +31,44 @@ Variant *Attr::valueRef() { return &mValue; }
 
 void Attr::setValue(const Variant &value) { mValue = value; }
 
+void Attr::setValue(Variant &&value) { mValue = std::move(value); }
+
 Token Attr::type() const { return mType; }
 
 void Attr::setType(Token type) { mType = type; }
 
+void AttrIndex::build(const std::vector<const Attr *> &attrs) {
+  mEntries.clear();
+  if (attrs.size() < indexThreshold)
+    return;
+  mEntries.reserve(attrs.size());
+  for (const Attr *attr : attrs) {
+    mEntries.emplace_back(attr->id(), attr);
+  }
+  // Keeps the first attribute of each id in front, as a linear scan would.
+  std::stable_sort(mEntries.begin(), mEntries.end(),
+                   [](const std::pair<Token, const Attr *> &a,
+                      const std::pair<Token, const Attr *> &b) {
+                     return a.first < b.first;
+                   });
+}
+
+void AttrIndex::clear() { mEntries.clear(); }
+
+bool AttrIndex::empty() const { return mEntries.empty(); }
+
+const Attr *AttrIndex::find(Token id) const {
+  auto it = std::lower_bound(
+      mEntries.begin(), mEntries.end(), id,
+      [](const std::pair<Token, const Attr *> &entry, Token id) {
+        return entry.first < id;
+      });
+  if (it != mEntries.end() && it->first == id) {
+    return it->second;
+  }
+  return nullptr;
+}
+
 Token Attr_id(const Attr *prop) {
   if (!prop)
     return Token_null();
@@ -56,7 +98,7 @@ Variant *Attr_valueRef(Attr *prop) { return prop->valueRef(); }
 bool Attr_bool(const Attr *prop) {
   if (!prop)
     return false;
-  return prop->value().boolValue();
+  return Variant_bool(prop->valueRef());
 }
 
 void Attr_setBool(Attr *prop, bool value) { prop->setValue(value); }
@@ -64,7 +106,7 @@ void Attr_setBool(Attr *prop, bool value) { prop->setValue(value); }
 int32_t Attr_int32(const Attr *prop) {
   if (!prop)
     return 0ll;
-  return prop->value().int32Value();
+  return Variant_int32(prop->valueRef());
 }
 
 void Attr_setInt32(Attr *prop, int32_t value) { prop->setValue(value); }
@@ -72,7 +114,7 @@ void Attr_setInt32(Attr *prop, int32_t value) { prop->setValue(value); }
 int64_t Attr_int64(const Attr *prop) {
   if (!prop)
     return 0ll;
-  return prop->value().int64Value();
+  return Variant_int64(prop->valueRef());
 }
 
 void Attr_setInt64(Attr *prop, int64_t value) { prop->setValue(value); }
@@ -80,7 +122,7 @@ void Attr_setInt64(Attr *prop, int64_t value) { prop->setValue(value); }
 uint32_t Attr_uint32(const Attr *prop) {
   if (!prop)
     return 0ull;
-  return prop->value().uint32Value();
+  return Variant_uint32(prop->valueRef());
 }
 
 void Attr_setUint32(Attr *prop, uint32_t value) { prop->setValue(value); }
@@ -88,7 +130,7 @@ void Attr_setUint32(Attr *prop, uint32_t value) { prop->setValue(value); }
 uint64_t Attr_uint64(const Attr *prop) {
   if (!prop)
     return 0ull;
-  return prop->value().uint64Value();
+  return Variant_uint64(prop->valueRef());
 }
 
 void Attr_setUint64(Attr *prop, uint64_t value) { prop->setValue(value); }
@@ -96,7 +138,7 @@ void Attr_setUint64(Attr *prop, uint64_t value) { prop->setValue(value); }
 double Attr_double(const Attr *prop) {
   if (!prop)
     return 0.0;
-  return prop->value().doubleValue();
+  return Variant_double(prop->valueRef());
 }
 
 void Attr_setDouble(Attr *prop, double value) { prop->setValue(value); }
@@ -104,15 +146,17 @@ void Attr_setDouble(Attr *prop, double value) { prop->setValue(value); }
 const char *Attr_string(const Attr *prop) {
   if (!prop)
     return "";
-  return prop->value().string().c_str();
+  return Variant_string(prop->valueRef());
 }
 
-void Attr_setString(Attr *prop, const char *str) { prop->setValue(str); }
+void Attr_setString(Attr *prop, const char *str) {
+  prop->setValue(std::string(str));
+}
 
 Slice Attr_slice(const Attr *prop) {
   if (!prop)
     return Slice{nullptr, nullptr};
-  return prop->value().slice();
+  return Variant_slice(prop->valueRef());
 }
 
 void Attr_setSlice(Attr *prop, Slice slice) { prop->setValue(slice); }
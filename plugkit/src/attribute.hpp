@@ -5,21 +5,25 @@
 #include "token.h"
 #include "variant.hpp"
 #include <memory>
+#include <utility>
+#include <vector>
 
 namespace plugkit {
 
 struct Attr final {
 public:
   Attr(Token id, const Variant &value = Variant(), Token type = Token());
+  Attr(Token id, Variant &&value, Token type = Token());
   ~Attr();
 
   Token id() const;
   Range range() const;
   void setRange(const Range &range);
-  Variant value() const;
+  const Variant &value() const;
   const Variant *valueRef() const;
   Variant *valueRef();
   void setValue(const Variant &value);
+  void setValue(Variant &&value);
   Token type() const;
   void setType(Token type);
 
@@ -33,6 +37,19 @@ private:
   Range mRange = {0, 0};
   Token mType = 0;
 };
+
+// Attributes sorted by id. Lists shorter than the threshold are left empty
+// since a linear scan is faster for them.
+class AttrIndex final {
+public:
+  void build(const std::vector<const Attr *> &attrs);
+  void clear();
+  bool empty() const;
+  const Attr *find(Token id) const;
+
+private:
+  std::vector<std::pair<Token, const Attr *>> mEntries;
+};
 } // namespace plugkit
 
 #endif
@@ -0,0 +1,185 @@
+#include "attribute_index.hpp"
+#include "attribute.hpp"
+#include "bitmap.hpp"
+#include "frame.hpp"
+#include "layer.hpp"
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+#include <uv.h>
+
+namespace plugkit {
+
+namespace {
+const char *const defaultAttributes[] = {
+    "tcp.streamId", "eth.src",  "eth.dst", "ipv4.src", "ipv4.dst", "ipv6.src",
+    "ipv6.dst",     "tcp.src",  "tcp.dst", "udp.src",  "udp.dst"};
+
+template <class T> void appendBytes(std::string *key, T value) {
+  key->append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+// Numbers are keyed by their integer value regardless of their type, so that
+// a port stored as uint32 is found with a number from the script.
+bool appendValue(std::string *key, const Variant &value) {
+  switch (value.type()) {
+  case Variant::TYPE_BOOL:
+  case Variant::TYPE_INT32:
+  case Variant::TYPE_UINT32:
+  case Variant::TYPE_INT64:
+  case Variant::TYPE_UINT64:
+    key->push_back('i');
+    appendBytes(key, value.int64Value());
+    return true;
+  case Variant::TYPE_DOUBLE: {
+    double number = value.doubleValue();
+    if (number == static_cast<double>(static_cast<int64_t>(number))) {
+      key->push_back('i');
+      appendBytes(key, static_cast<int64_t>(number));
+    } else {
+      key->push_back('d');
+      appendBytes(key, number);
+    }
+    return true;
+  }
+  case Variant::TYPE_STRING:
+    key->push_back('b');
+    key->append(value.string());
+    return true;
+  case Variant::TYPE_SLICE: {
+    const Slice &slice = value.slice();
+    key->push_back('b');
+    key->append(slice.begin, Slice_length(slice));
+    return true;
+  }
+  case Variant::TYPE_ARRAY:
+    key->push_back('b');
+    for (const Variant &byte : value.array()) {
+      key->push_back(static_cast<char>(byte.uint32Value()));
+    }
+    return true;
+  default:
+    return false;
+  }
+}
+} // namespace
+
+class AttributeIndex::Private {
+public:
+  Private(const Variant &options);
+  ~Private();
+  const std::string *path(const Layer *layer, const Attr *attr);
+  void insert(const Layer *layer, uint32_t index);
+
+public:
+  std::unordered_set<std::string> attributes;
+  std::unordered_map<uint64_t, std::string> paths;
+  std::unordered_map<std::string, Bitmap> index;
+  std::string key;
+  uv_rwlock_t rwlock;
+};
+
+AttributeIndex::Private::Private(const Variant &options) {
+  uv_rwlock_init(&rwlock);
+  const Variant &list = options["_"]["indexedAttributes"];
+  if (list.isArray()) {
+    for (const Variant &name : list.array()) {
+      attributes.insert(name.string());
+    }
+  } else {
+    attributes.insert(std::begin(defaultAttributes),
+                      std::end(defaultAttributes));
+  }
+}
+
+AttributeIndex::Private::~Private() { uv_rwlock_destroy(&rwlock); }
+
+const std::string *AttributeIndex::Private::path(const Layer *layer,
+                                                 const Attr *attr) {
+  // Attributes starting with a dot are named after their layer, like the
+  // field paths of the display filter.
+  uint64_t id = (static_cast<uint64_t>(layer->id()) << 32) | attr->id();
+  auto it = paths.find(id);
+  if (it == paths.end()) {
+    const char *name = Token_string(attr->id());
+    std::string path =
+        (name[0] == '.') ? (Token_string(layer->id()) + std::string(name))
+                         : std::string(name);
+    if (attributes.count(path) == 0) {
+      path.clear();
+    }
+    it = paths.insert(std::make_pair(id, path)).first;
+  }
+  return it->second.empty() ? nullptr : &it->second;
+}
+
+void AttributeIndex::Private::insert(const Layer *layer, uint32_t index) {
+  key.assign(Token_string(layer->id()));
+  key.push_back('\0');
+  this->index[key].add(index);
+
+  for (const Attr *attr : layer->attrs()) {
+    if (const std::string *name = path(layer, attr)) {
+      key.assign(*name);
+      key.push_back('\0');
+      if (appendValue(&key, attr->value())) {
+        this->index[key].add(index);
+      }
+    }
+  }
+  for (const Layer *child : layer->layers()) {
+    insert(child, index);
+  }
+}
+
+AttributeIndex::AttributeIndex(const Variant &options)
+    : d(new Private(options)) {}
+
+AttributeIndex::~AttributeIndex() {}
+
+void AttributeIndex::insert(const Frame **begin, size_t size) {
+  uv_rwlock_wrlock(&d->rwlock);
+  for (size_t i = 0; i < size; ++i) {
+    if (const Layer *root = begin[i]->rootLayer()) {
+      d->insert(root, begin[i]->index());
+    }
+  }
+  uv_rwlock_wrunlock(&d->rwlock);
+}
+
+std::vector<uint32_t> AttributeIndex::find(const std::string &name,
+                                           const Variant &value,
+                                           uint32_t offset,
+                                           uint32_t length) const {
+  std::string key = name;
+  key.push_back('\0');
+  if (!value.isNil() && !appendValue(&key, value))
+    return std::vector<uint32_t>();
+
+  std::vector<uint32_t> frames;
+  uv_rwlock_rdlock(&d->rwlock);
+  auto it = d->index.find(key);
+  if (it != d->index.end()) {
+    frames = it->second.values(offset, length);
+  }
+  uv_rwlock_rdunlock(&d->rwlock);
+  return frames;
+}
+
+uint32_t AttributeIndex::size(const std::string &name,
+                              const Variant &value) const {
+  std::string key = name;
+  key.push_back('\0');
+  if (!value.isNil() && !appendValue(&key, value))
+    return 0;
+
+  uint32_t size = 0;
+  uv_rwlock_rdlock(&d->rwlock);
+  auto it = d->index.find(key);
+  if (it != d->index.end()) {
+    size = it->second.size();
+  }
+  uv_rwlock_rdunlock(&d->rwlock);
+  return size;
+}
+} // namespace plugkit
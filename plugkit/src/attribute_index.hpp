@@ -0,0 +1,40 @@
+#ifndef PLUGKIT_ATTRIBUTE_INDEX_HPP
+#define PLUGKIT_ATTRIBUTE_INDEX_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace plugkit {
+
+class Frame;
+struct Variant;
+
+class AttributeIndex final {
+public:
+  /// Indexes the attributes listed in `_.indexedAttributes`, or the stream
+  /// ids, addresses and ports if it is not set.
+  AttributeIndex(const Variant &options);
+  ~AttributeIndex();
+
+  /// Adds the layers and the indexed attributes of dissected frames.
+  void insert(const Frame **begin, size_t size);
+
+  /// Returns a range of the frames which contain the layer `name`, or the
+  /// attribute `name` equal to `value` if `value` is not nil.
+  std::vector<uint32_t> find(const std::string &name, const Variant &value,
+                             uint32_t offset, uint32_t length) const;
+  uint32_t size(const std::string &name, const Variant &value) const;
+
+private:
+  AttributeIndex(const AttributeIndex &) = delete;
+  AttributeIndex &operator=(const AttributeIndex &) = delete;
+
+private:
+  class Private;
+  std::unique_ptr<Private> d;
+};
+} // namespace plugkit
+
+#endif
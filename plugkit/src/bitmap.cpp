@@ -0,0 +1,342 @@
+#include "bitmap.hpp"
+#include <algorithm>
+#include <iterator>
+
+namespace plugkit {
+
+namespace {
+const size_t maxArraySize = 4096;
+const size_t bitmapWords = 65536 / 64;
+
+int popcount(uint64_t word) {
+  word = word - ((word >> 1) & 0x5555555555555555ull);
+  word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+  word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0full;
+  return static_cast<int>((word * 0x0101010101010101ull) >> 56);
+}
+
+int lowestBit(uint64_t word) { return popcount((word & (~word + 1)) - 1); }
+
+std::vector<uint64_t> toBits(const std::vector<uint16_t> &array) {
+  std::vector<uint64_t> bits(bitmapWords);
+  for (uint16_t low : array) {
+    bits[low / 64] |= 1ull << (low % 64);
+  }
+  return bits;
+}
+
+std::vector<uint16_t> toArray(const std::vector<uint64_t> &bits) {
+  std::vector<uint16_t> array;
+  for (size_t i = 0; i < bits.size(); ++i) {
+    for (uint64_t word = bits[i]; word; word &= word - 1) {
+      array.push_back(static_cast<uint16_t>(i * 64 + lowestBit(word)));
+    }
+  }
+  return array;
+}
+} // namespace
+
+Bitmap::Bitmap() {}
+
+size_t Bitmap::find(uint16_t key) const {
+  auto it = std::lower_bound(
+      containers.begin(), containers.end(), key,
+      [](const Container &container, uint16_t key) {
+        return container.key < key;
+      });
+  return std::distance(containers.begin(), it);
+}
+
+void Bitmap::append(Container &&container) {
+  if (container.size == 0)
+    return;
+  if (container.bits.empty() && container.size > maxArraySize) {
+    container.bits = toBits(container.array);
+    container.array = std::vector<uint16_t>();
+  } else if (!container.bits.empty() && container.size <= maxArraySize) {
+    container.array = toArray(container.bits);
+    container.bits = std::vector<uint64_t>();
+  }
+  ranks.push_back(count);
+  count += container.size;
+  containers.push_back(std::move(container));
+}
+
+void Bitmap::add(uint32_t value) {
+  uint16_t key = value >> 16;
+  uint16_t low = value & 0xffff;
+
+  // Frame indices arrive in ascending order, so the last container is the
+  // usual target.
+  size_t index = (!containers.empty() && containers.back().key == key)
+                     ? containers.size() - 1
+                     : find(key);
+  if (index == containers.size() || containers[index].key != key) {
+    containers.insert(containers.begin() + index, Container{key, 0, {}, {}});
+    ranks.insert(ranks.begin() + index,
+                 index < ranks.size() ? ranks[index] : count);
+  }
+
+  Container &container = containers[index];
+  if (container.bits.empty()) {
+    auto it =
+        std::lower_bound(container.array.begin(), container.array.end(), low);
+    if (it != container.array.end() && *it == low)
+      return;
+    container.array.insert(it, low);
+    if (container.array.size() > maxArraySize) {
+      container.bits = toBits(container.array);
+      container.array = std::vector<uint16_t>();
+    }
+  } else {
+    uint64_t &word = container.bits[low / 64];
+    uint64_t bit = 1ull << (low % 64);
+    if (word & bit)
+      return;
+    word |= bit;
+  }
+  ++container.size;
+  ++count;
+  for (size_t i = index + 1; i < ranks.size(); ++i) {
+    ++ranks[i];
+  }
+}
+
+bool Bitmap::contains(uint32_t value) const {
+  uint16_t key = value >> 16;
+  uint16_t low = value & 0xffff;
+  size_t index = find(key);
+  if (index == containers.size() || containers[index].key != key)
+    return false;
+  const Container &container = containers[index];
+  if (container.bits.empty()) {
+    return std::binary_search(container.array.begin(), container.array.end(),
+                              low);
+  }
+  return container.bits[low / 64] & (1ull << (low % 64));
+}
+
+size_t Bitmap::size() const { return count; }
+
+bool Bitmap::empty() const { return count == 0; }
+
+void Bitmap::clear() {
+  containers.clear();
+  ranks.clear();
+  count = 0;
+}
+
+size_t Bitmap::rank(uint32_t value) const {
+  uint16_t key = value >> 16;
+  uint16_t low = value & 0xffff;
+  size_t index = find(key);
+  if (index == containers.size())
+    return count;
+  const Container &container = containers[index];
+  if (container.key != key)
+    return ranks[index];
+
+  size_t rank = ranks[index];
+  if (container.bits.empty()) {
+    rank += std::distance(container.array.begin(),
+                          std::lower_bound(container.array.begin(),
+                                           container.array.end(), low));
+  } else {
+    for (size_t i = 0; i < low / 64; ++i) {
+      rank += popcount(container.bits[i]);
+    }
+    rank += popcount(container.bits[low / 64] & ((1ull << (low % 64)) - 1));
+  }
+  return rank;
+}
+
+uint32_t Bitmap::select(size_t index) const {
+  size_t i = std::distance(ranks.begin(),
+                           std::upper_bound(ranks.begin(), ranks.end(), index)) -
+             1;
+  const Container &container = containers[i];
+  uint32_t base = static_cast<uint32_t>(container.key) << 16;
+  size_t local = index - ranks[i];
+  if (container.bits.empty()) {
+    return base | container.array[local];
+  }
+  for (size_t w = 0; w < container.bits.size(); ++w) {
+    uint64_t word = container.bits[w];
+    size_t bits = popcount(word);
+    if (local < bits) {
+      for (; local > 0; --local) {
+        word &= word - 1;
+      }
+      return base | static_cast<uint32_t>(w * 64 + lowestBit(word));
+    }
+    local -= bits;
+  }
+  return base;
+}
+
+bool Bitmap::lowerBound(uint32_t value, uint32_t *dst) const {
+  uint16_t key = value >> 16;
+  uint16_t low = value & 0xffff;
+  size_t index = find(key);
+  if (index < containers.size() && containers[index].key == key) {
+    const Container &container = containers[index];
+    uint32_t base = static_cast<uint32_t>(key) << 16;
+    if (container.bits.empty()) {
+      auto it = std::lower_bound(container.array.begin(),
+                                 container.array.end(), low);
+      if (it != container.array.end()) {
+        *dst = base | *it;
+        return true;
+      }
+    } else {
+      uint64_t word = container.bits[low / 64] & (~0ull << (low % 64));
+      for (size_t w = low / 64; w < container.bits.size();) {
+        if (word) {
+          *dst = base | static_cast<uint32_t>(w * 64 + lowestBit(word));
+          return true;
+        }
+        if (++w < container.bits.size()) {
+          word = container.bits[w];
+        }
+      }
+    }
+    ++index;
+  }
+  if (index == containers.size())
+    return false;
+  *dst = select(ranks[index]);
+  return true;
+}
+
+std::vector<uint32_t> Bitmap::values(size_t offset, size_t length) const {
+  std::vector<uint32_t> values;
+  if (offset >= count)
+    return values;
+  length = std::min(length, count - offset);
+  values.reserve(length);
+
+  size_t i = std::distance(
+                 ranks.begin(),
+                 std::upper_bound(ranks.begin(), ranks.end(), offset)) -
+             1;
+  size_t local = offset - ranks[i];
+  for (; i < containers.size() && values.size() < length; ++i, local = 0) {
+    const Container &container = containers[i];
+    uint32_t base = static_cast<uint32_t>(container.key) << 16;
+    if (container.bits.empty()) {
+      for (size_t j = local;
+           j < container.array.size() && values.size() < length; ++j) {
+        values.push_back(base | container.array[j]);
+      }
+    } else {
+      for (size_t w = 0; w < container.bits.size() && values.size() < length;
+           ++w) {
+        uint64_t word = container.bits[w];
+        size_t bits = popcount(word);
+        if (local >= bits) {
+          local -= bits;
+          continue;
+        }
+        for (; word && values.size() < length; word &= word - 1) {
+          if (local > 0) {
+            --local;
+            continue;
+          }
+          values.push_back(base |
+                           static_cast<uint32_t>(w * 64 + lowestBit(word)));
+        }
+      }
+    }
+  }
+  return values;
+}
+
+size_t Bitmap::bytes() const {
+  size_t bytes = sizeof(Bitmap) + containers.capacity() * sizeof(Container) +
+                 ranks.capacity() * sizeof(size_t);
+  for (const Container &container : containers) {
+    bytes += container.array.capacity() * sizeof(uint16_t) +
+             container.bits.capacity() * sizeof(uint64_t);
+  }
+  return bytes;
+}
+
+Bitmap Bitmap::operator&(const Bitmap &other) const {
+  Bitmap bitmap;
+  auto a = containers.begin();
+  auto b = other.containers.begin();
+  while (a != containers.end() && b != other.containers.end()) {
+    if (a->key < b->key) {
+      ++a;
+      continue;
+    }
+    if (b->key < a->key) {
+      ++b;
+      continue;
+    }
+
+    Container container{a->key, 0, {}, {}};
+    if (!a->bits.empty() && !b->bits.empty()) {
+      container.bits.resize(bitmapWords);
+      for (size_t i = 0; i < bitmapWords; ++i) {
+        container.bits[i] = a->bits[i] & b->bits[i];
+        container.size += popcount(container.bits[i]);
+      }
+    } else if (a->bits.empty() && b->bits.empty()) {
+      std::set_intersection(a->array.begin(), a->array.end(),
+                            b->array.begin(), b->array.end(),
+                            std::back_inserter(container.array));
+      container.size = container.array.size();
+    } else {
+      const Container &array = a->bits.empty() ? *a : *b;
+      const Container &bits = a->bits.empty() ? *b : *a;
+      for (uint16_t low : array.array) {
+        if (bits.bits[low / 64] & (1ull << (low % 64))) {
+          container.array.push_back(low);
+        }
+      }
+      container.size = container.array.size();
+    }
+    bitmap.append(std::move(container));
+    ++a;
+    ++b;
+  }
+  return bitmap;
+}
+
+Bitmap Bitmap::operator|(const Bitmap &other) const {
+  Bitmap bitmap;
+  auto a = containers.begin();
+  auto b = other.containers.begin();
+  while (a != containers.end() || b != other.containers.end()) {
+    if (b == other.containers.end() ||
+        (a != containers.end() && a->key < b->key)) {
+      bitmap.append(Container(*a++));
+      continue;
+    }
+    if (a == containers.end() || b->key < a->key) {
+      bitmap.append(Container(*b++));
+      continue;
+    }
+
+    Container container{a->key, 0, {}, {}};
+    if (a->bits.empty() && b->bits.empty()) {
+      std::set_union(a->array.begin(), a->array.end(), b->array.begin(),
+                     b->array.end(), std::back_inserter(container.array));
+      container.size = container.array.size();
+    } else {
+      container.bits = a->bits.empty() ? toBits(a->array) : a->bits;
+      const std::vector<uint64_t> &bits =
+          b->bits.empty() ? toBits(b->array) : b->bits;
+      for (size_t i = 0; i < bitmapWords; ++i) {
+        container.bits[i] |= bits[i];
+        container.size += popcount(container.bits[i]);
+      }
+    }
+    bitmap.append(std::move(container));
+    ++a;
+    ++b;
+  }
+  return bitmap;
+}
+} // namespace plugkit
@@ -0,0 +1,61 @@
+#ifndef PLUGKIT_BITMAP_HPP
+#define PLUGKIT_BITMAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace plugkit {
+
+/// Compressed set of 32-bit integers.
+///
+/// Values are grouped by their upper 16 bits. Each group is stored as a
+/// sorted array while it is sparse and as a 65536-bit bitmap once it holds
+/// more than 4096 values, so that a set of frame indices takes at most about
+/// 2 bytes per value and 1 bit per frame when dense.
+class Bitmap final {
+public:
+  Bitmap();
+  void add(uint32_t value);
+  bool contains(uint32_t value) const;
+  size_t size() const;
+  bool empty() const;
+  void clear();
+
+  /// Returns the number of values less than `value`.
+  size_t rank(uint32_t value) const;
+
+  /// Returns the `index`-th smallest value. `index` must be less than size().
+  uint32_t select(size_t index) const;
+
+  /// Finds the smallest value not less than `value`.
+  bool lowerBound(uint32_t value, uint32_t *dst) const;
+
+  /// Returns up to `length` values starting from the `offset`-th smallest.
+  std::vector<uint32_t> values(size_t offset, size_t length) const;
+
+  /// Returns the approximate memory usage in bytes.
+  size_t bytes() const;
+
+  Bitmap operator&(const Bitmap &other) const;
+  Bitmap operator|(const Bitmap &other) const;
+
+private:
+  struct Container {
+    uint16_t key;
+    uint32_t size;
+    std::vector<uint16_t> array;
+    std::vector<uint64_t> bits;
+  };
+
+  size_t find(uint16_t key) const;
+  void append(Container &&container);
+
+private:
+  std::vector<Container> containers;
+  std::vector<size_t> ranks;
+  size_t count = 0;
+};
+} // namespace plugkit
+
+#endif
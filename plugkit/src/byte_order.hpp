@@ -0,0 +1,70 @@
+#ifndef PLUGKIT_BYTE_ORDER_HPP
+#define PLUGKIT_BYTE_ORDER_HPP
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(PLUGKIT_OS_WIN)
+#include <stdlib.h>
+#endif
+
+namespace plugkit {
+
+inline uint8_t byteSwap(uint8_t value) { return value; }
+
+inline uint16_t byteSwap(uint16_t value) {
+#if defined(PLUGKIT_OS_WIN)
+  return _byteswap_ushort(value);
+#else
+  return __builtin_bswap16(value);
+#endif
+}
+
+inline uint32_t byteSwap(uint32_t value) {
+#if defined(PLUGKIT_OS_WIN)
+  return _byteswap_ulong(value);
+#else
+  return __builtin_bswap32(value);
+#endif
+}
+
+inline uint64_t byteSwap(uint64_t value) {
+#if defined(PLUGKIT_OS_WIN)
+  return _byteswap_uint64(value);
+#else
+  return __builtin_bswap64(value);
+#endif
+}
+
+template <class T> struct UnsignedOf;
+template <> struct UnsignedOf<uint8_t> { using type = uint8_t; };
+template <> struct UnsignedOf<int8_t> { using type = uint8_t; };
+template <> struct UnsignedOf<uint16_t> { using type = uint16_t; };
+template <> struct UnsignedOf<int16_t> { using type = uint16_t; };
+template <> struct UnsignedOf<uint32_t> { using type = uint32_t; };
+template <> struct UnsignedOf<int32_t> { using type = uint32_t; };
+template <> struct UnsignedOf<float> { using type = uint32_t; };
+template <> struct UnsignedOf<uint64_t> { using type = uint64_t; };
+template <> struct UnsignedOf<int64_t> { using type = uint64_t; };
+template <> struct UnsignedOf<double> { using type = uint64_t; };
+
+// Loads a little-endian value from unaligned memory.
+template <class T> T loadLE(const char *data) {
+  T value;
+  std::memcpy(&value, data, sizeof(T));
+  return value;
+}
+
+// Loads a big-endian value from unaligned memory. Compilers turn the
+// memcpy and the swap into a single movbe where available.
+template <class T> T loadBE(const char *data) {
+  typename UnsignedOf<T>::type bits;
+  std::memcpy(&bits, data, sizeof(T));
+  bits = byteSwap(bits);
+  T value;
+  std::memcpy(&value, &bits, sizeof(T));
+  return value;
+}
+} // namespace plugkit
+
+#endif
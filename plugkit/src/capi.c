@@ -3,6 +3,9 @@
 #include <context.h>
 #include <dissector.h>
 #include <export.h>
+#include <fixed_layer.h>
+#include <flow.h>
+#include <flow_table.h>
 #include <layer.h>
 #include <logger.h>
 #include <payload.h>
@@ -15,6 +15,10 @@ void Context_dealloc(Context *ctx, void *ptr) {
 
 const Variant *Context_options(Context *ctx) { return &ctx->options; }
 
+void Context_setWorkerMemory(Context *ctx, size_t bytes) {
+  ctx->workerMemory = bytes;
+}
+
 namespace {
 void Log(Context *ctx, const char *file, int line, Logger::Level level,
          const char *message) {
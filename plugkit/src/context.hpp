@@ -7,6 +7,7 @@ namespace plugkit {
 struct Context final {
 public:
   Variant options;
+  size_t workerMemory = 0;
   LoggerPtr logger = std::make_shared<StreamLogger>();
 };
 } // namespace plugkit
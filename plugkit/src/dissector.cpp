@@ -1,8 +1,40 @@
-#include "dissector.h"
+#include "dissector.hpp"
+#include <cstddef>
 #include <cstring>
+#include <mutex>
+#include <unordered_set>
 
 namespace plugkit {
-void Dissector_reset(Dissector *diss) {
+
+namespace {
+// The size of Dissector before analyzeBatch was appended.
+const size_t originalSize = offsetof(Dissector, analyzeBatch);
+
+struct Registry {
+  std::mutex mutex;
+  std::unordered_set<const Dissector *> initialized;
+};
+
+Registry &registry() {
+  static Registry registry;
+  return registry;
+}
+} // namespace
+
+void Dissector_reset(Dissector *diss) { std::memset(diss, 0, originalSize); }
+
+void Dissector_init(Dissector *diss) {
   std::memset(diss, 0, sizeof(Dissector));
+  Registry &reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mutex);
+  reg.initialized.insert(diss);
+}
+
+void Dissector_copy(Dissector *dst, const Dissector *src) {
+  std::memset(dst, 0, sizeof(Dissector));
+  Registry &reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mutex);
+  bool current = reg.initialized.count(src) > 0;
+  std::memcpy(dst, src, current ? sizeof(Dissector) : originalSize);
 }
 } // namespace plugkit
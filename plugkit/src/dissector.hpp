@@ -0,0 +1,14 @@
+#ifndef PLUGKIT_DISSECTOR_HPP
+#define PLUGKIT_DISSECTOR_HPP
+
+#include "dissector.h"
+
+namespace plugkit {
+
+/// Copies a dissector exported by a native module. The fields appended
+/// after `data` are zeroed unless `src` was set up by Dissector_init().
+void Dissector_copy(Dissector *dst, const Dissector *src);
+
+} // namespace plugkit
+
+#endif
@@ -19,6 +19,12 @@ struct WorkerData {
   TagFilter filter;
   Worker worker;
 };
+
+struct LeafLayer {
+  Layer *layer;
+  size_t frame;
+  bool analyzed;
+};
 } // namespace
 
 class DissectorThread::Private {
@@ -30,6 +36,7 @@ public:
 public:
   std::vector<Dissector> dissectors;
   std::vector<WorkerData> workers;
+  std::vector<std::vector<Layer *>> groups;
   double confidenceThreshold;
 
   Context ctx;
@@ -88,6 +95,7 @@ void DissectorThread::enter() {
     }
     d->workers.push_back(data);
   }
+  d->groups.resize(d->workers.size());
 }
 
 bool DissectorThread::loop() {
@@ -96,43 +104,58 @@ bool DissectorThread::loop() {
   if (size == 0)
     return false;
 
+  // The layers of all frames in the batch are dissected level by level, so
+  // that each worker receives its layers at once.
+  std::vector<std::unordered_set<Token>> dissectedIds(size);
+  std::vector<LeafLayer> leafLayers;
   for (size_t i = 0; i < size; ++i) {
-    std::unordered_set<Token> dissectedIds;
+    if (Layer *rootLayer = frames[i]->rootLayer()) {
+      leafLayers.push_back(LeafLayer{rootLayer, i, false});
+    }
+  }
 
-    Frame *frame = frames[i];
-    const auto &rootLayer = frame->rootLayer();
-    if (!rootLayer)
-      continue;
+  while (!leafLayers.empty()) {
+    for (LeafLayer &leaf : leafLayers) {
+      dissectedIds[leaf.frame].insert(leaf.layer->id());
+      for (size_t i = 0; i < d->workers.size(); ++i) {
+        if (d->workers[i].filter.match(leaf.layer->tags())) {
+          d->groups[i].push_back(leaf.layer);
+          leaf.analyzed = true;
+        }
+      }
+    }
 
-    std::vector<const WorkerData *> workers;
-    std::vector<Layer *> leafLayers = {rootLayer};
-    while (!leafLayers.empty()) {
-      std::vector<Layer *> nextlayers;
-      for (const auto &layer : leafLayers) {
-        dissectedIds.insert(layer->id());
-
-        workers.clear();
-        for (const auto &data : d->workers) {
-          if (data.filter.match(layer->tags())) {
-            workers.push_back(&data);
-          }
+    for (size_t i = 0; i < d->workers.size(); ++i) {
+      std::vector<Layer *> &layers = d->groups[i];
+      if (layers.empty())
+        continue;
+      const WorkerData &data = d->workers[i];
+      if (data.dissector->analyzeBatch) {
+        data.dissector->analyzeBatch(&d->ctx, data.dissector, data.worker,
+                                     layers.data(), layers.size());
+      } else {
+        for (Layer *layer : layers) {
+          data.dissector->analyze(&d->ctx, data.dissector, data.worker,
+                                  layer);
         }
+      }
+      layers.clear();
+    }
 
-        for (const WorkerData *data : workers) {
-          data->dissector->analyze(&d->ctx, data->dissector, data->worker,
-                                   layer);
-          for (Layer *childLayer : layer->layers()) {
-            if (childLayer->confidence() >= d->confidenceThreshold) {
-              auto it = dissectedIds.find(childLayer->id());
-              if (it == dissectedIds.end()) {
-                nextlayers.push_back(childLayer);
-              }
-            }
+    std::vector<LeafLayer> nextLayers;
+    for (const LeafLayer &leaf : leafLayers) {
+      if (leaf.analyzed) {
+        const auto &ids = dissectedIds[leaf.frame];
+        for (Layer *childLayer : leaf.layer->layers()) {
+          if (childLayer->confidence() >= d->confidenceThreshold &&
+              ids.find(childLayer->id()) == ids.end()) {
+            nextLayers.push_back(LeafLayer{childLayer, leaf.frame, false});
           }
         }
       }
-      leafLayers.swap(nextlayers);
+      leaf.layer->seal();
     }
+    leafLayers.swap(nextLayers);
   }
 
   if (d->callback) {
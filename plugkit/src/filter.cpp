@@ -1,5 +1,6 @@
 #include "filter.hpp"
 #include "attribute.hpp"
+#include "filter_program.hpp"
 #include "frame.hpp"
 #include "frame_view.hpp"
 #include "layer.hpp"
@@ -7,6 +8,7 @@
 #include "wrapper/frame.hpp"
 #include "wrapper/layer.hpp"
 #include <functional>
+#include <vector>
 #include <json11.hpp>
 
 namespace plugkit {
@@ -14,11 +16,22 @@ namespace plugkit {
 using namespace v8;
 
 class Filter::Private {
+public:
+  Private(const std::string &program, bool specialize, bool jit);
+
 public:
   v8::UniquePersistent<v8::Function> func;
+  FilterProgram program;
+  std::vector<uint64_t> unsupported;
 };
 
-Filter::Filter(const std::string &body) : d(new Private()) {
+Filter::Private::Private(const std::string &program, bool specialize,
+                         bool jit)
+    : program(program, specialize, jit) {}
+
+Filter::Filter(const std::string &body, const std::string &program,
+               bool specialize, bool jit)
+    : d(new Private(program, specialize, jit)) {
   auto script = Nan::CompileScript(Nan::New(body).ToLocalChecked());
   if (!script.IsEmpty()) {
     auto result = Nan::RunScript(script.ToLocalChecked());
@@ -33,16 +46,23 @@ Filter::Filter(const std::string &body) : d(new Private()) {
 
 Filter::~Filter() {}
 
-void Filter::test(char *results, const FrameView **begin, size_t size) const {
+void Filter::test(uint64_t *results, const FrameView **begin,
+                  size_t size) const {
+  std::vector<uint64_t> &unsupported = d->unsupported;
+  unsupported.assign((size + 63) / 64, 0);
+  d->program.test(results, unsupported.data(), begin, size);
+
   v8::Isolate *isolate = v8::Isolate::GetCurrent();
   auto global = isolate->GetCurrentContext()->Global();
   auto func = v8::Local<v8::Function>::New(isolate, d->func);
   if (!func.IsEmpty()) {
     for (size_t i = 0; i < size; ++i) {
+      if (!(unsupported[i / 64] & (1ull << (i % 64))))
+        continue;
       v8::Local<v8::Value> args[1] = {FrameWrapper::wrap(begin[i])};
       auto value = func->Call(global, 1, args);
-      if (!value.IsEmpty()) {
-        results[i] = value->BooleanValue();
+      if (!value.IsEmpty() && value->BooleanValue()) {
+        results[i / 64] |= (1ull << (i % 64));
       }
     }
   }
@@ -1,6 +1,7 @@
 #ifndef PLUGKIT_FILTER_HPP
 #define PLUGKIT_FILTER_HPP
 
+#include <cstdint>
 #include <string>
 #include <v8.h>
 
@@ -10,9 +11,14 @@ class FrameView;
 
 class Filter final {
 public:
-  Filter(const std::string &body);
+  /// Frames are tested with the native FilterProgram compiled from
+  /// `program` where possible, and with the script `body` otherwise.
+  Filter(const std::string &body, const std::string &program,
+         bool specialize = true, bool jit = false);
   ~Filter();
-  void test(char *results, const FrameView **begin, size_t size) const;
+  /// Sets the bit of each matching frame in `results`, which must have
+  /// (size + 63) / 64 words cleared to zero.
+  void test(uint64_t *results, const FrameView **begin, size_t size) const;
 
 private:
   class Private;
@@ -0,0 +1,267 @@
+#include "filter_jit.hpp"
+#include <cstring>
+#include <initializer_list>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define PLUGKIT_FILTER_JIT_X64
+#endif
+
+#if defined(PLUGKIT_FILTER_JIT_X64)
+#if defined(PLUGKIT_OS_WIN)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+#endif
+
+namespace plugkit {
+
+namespace {
+using Function = void (*)(const double *const *, size_t, uint8_t *);
+
+#if defined(PLUGKIT_FILTER_JIT_X64)
+
+// The results of the instructions are kept in r8d to r11d.
+const size_t maxDepth = 4;
+
+class Assembler {
+public:
+  void emit(std::initializer_list<uint8_t> bytes) {
+    code.insert(code.end(), bytes.begin(), bytes.end());
+  }
+  void emit32(uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+      code.push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+  }
+  void emit64(uint64_t value) {
+    emit32(static_cast<uint32_t>(value));
+    emit32(static_cast<uint32_t>(value >> 32));
+  }
+
+  // Emits a 32-bit relative jump and returns the offset to patch.
+  size_t jump(uint8_t condition) {
+    emit({0x0f, condition});
+    emit32(0);
+    return code.size();
+  }
+  void patch(size_t from, size_t to) {
+    uint32_t rel = static_cast<uint32_t>(to - from);
+    std::memcpy(&code[from - 4], &rel, sizeof(rel));
+  }
+
+  // Sets xmm2 to all ones if `xmm<first> <predicate> xmm<second>` holds and
+  // to zero otherwise.
+  void compare(uint8_t first, uint8_t second, uint8_t predicate) {
+    emit({0x66, 0x0f, 0x28, static_cast<uint8_t>(0xd0 | first)});
+    emit({0xf2, 0x0f, 0xc2, static_cast<uint8_t>(0xd0 | second), predicate});
+  }
+
+  std::vector<uint8_t> code;
+};
+
+const uint8_t CMP_EQ = 0;
+const uint8_t CMP_LT = 1;
+const uint8_t CMP_LE = 2;
+const uint8_t CMP_NEQ = 4;
+const uint8_t CMP_ORD = 7;
+
+const uint8_t JB = 0x82;
+const uint8_t JZ = 0x84;
+
+// Generates `void (const double **columns, size_t size, uint8_t *results)`.
+// Arguments are moved to rdi, rsi and rdx on Windows, and rcx is the index
+// of the current row.
+bool assemble(const std::vector<FilterJit::Instruction> &code,
+              std::vector<uint8_t> *dst) {
+  Assembler a;
+#if defined(PLUGKIT_OS_WIN)
+  a.emit({0x56, 0x57});             // push rsi; push rdi
+  a.emit({0x48, 0x89, 0xcf});       // mov rdi, rcx
+  a.emit({0x48, 0x89, 0xd6});       // mov rsi, rdx
+  a.emit({0x4c, 0x89, 0xc2});       // mov rdx, r8
+#endif
+  a.emit({0x31, 0xc9});             // xor ecx, ecx
+  a.emit({0x48, 0x85, 0xf6});       // test rsi, rsi
+  size_t exit = a.jump(JZ);
+  size_t loop = a.code.size();
+
+  size_t depth = 0;
+  for (const FilterJit::Instruction &inst : code) {
+    switch (inst.opcode) {
+    case FilterJit::OPCODE_TEST: {
+      if (depth >= maxDepth || inst.column > 0x0fffffff)
+        return false;
+
+      // mov rax, [rdi + column * 8]; movsd xmm0, [rax + rcx * 8]
+      a.emit({0x48, 0x8b, 0x87});
+      a.emit32(inst.column * 8);
+      a.emit({0xf2, 0x0f, 0x10, 0x04, 0xc8});
+      if (inst.masked) {
+        a.emit({0xf2, 0x48, 0x0f, 0x2c, 0xc0}); // cvttsd2si rax, xmm0
+        a.emit({0x25});                         // and eax, mask
+        a.emit32(static_cast<uint32_t>(inst.mask));
+        a.emit({0x48, 0x63, 0xc0});             // movsxd rax, eax
+        a.emit({0xf2, 0x48, 0x0f, 0x2a, 0xc0}); // cvtsi2sd xmm0, rax
+      }
+
+      if (inst.compare == FilterJit::COMPARE_TRUTHY) {
+        a.emit({0x66, 0x0f, 0x57, 0xc9}); // xorpd xmm1, xmm1
+        a.compare(0, 1, CMP_NEQ);
+        a.emit({0x66, 0x0f, 0x28, 0xd8});       // movapd xmm3, xmm0
+        a.emit({0xf2, 0x0f, 0xc2, 0xd8, CMP_ORD}); // cmpordsd xmm3, xmm0
+        a.emit({0x66, 0x0f, 0x54, 0xd3});       // andpd xmm2, xmm3
+      } else {
+        uint64_t bits;
+        std::memcpy(&bits, &inst.constant, sizeof(bits));
+        a.emit({0x48, 0xb8}); // mov rax, constant
+        a.emit64(bits);
+        a.emit({0x66, 0x48, 0x0f, 0x6e, 0xc8}); // movq xmm1, rax
+
+        // Ordered predicates are false and NEQ is true for NaN, as in
+        // JavaScript.
+        uint8_t x = inst.reversed ? 1 : 0;
+        uint8_t y = inst.reversed ? 0 : 1;
+        switch (inst.compare) {
+        case FilterJit::COMPARE_EQ:
+          a.compare(x, y, CMP_EQ);
+          break;
+        case FilterJit::COMPARE_NE:
+          a.compare(x, y, CMP_NEQ);
+          break;
+        case FilterJit::COMPARE_LT:
+          a.compare(x, y, CMP_LT);
+          break;
+        case FilterJit::COMPARE_GT:
+          a.compare(y, x, CMP_LT);
+          break;
+        case FilterJit::COMPARE_LE:
+          a.compare(x, y, CMP_LE);
+          break;
+        case FilterJit::COMPARE_GE:
+          a.compare(y, x, CMP_LE);
+          break;
+        default:
+          return false;
+        }
+      }
+
+      // movq rax, xmm2; and eax, 1; mov r8d + depth, eax
+      a.emit({0x66, 0x48, 0x0f, 0x7e, 0xd0});
+      a.emit({0x83, 0xe0, 0x01});
+      a.emit({0x41, 0x89, static_cast<uint8_t>(0xc0 | depth)});
+      ++depth;
+    } break;
+    case FilterJit::OPCODE_AND:
+    case FilterJit::OPCODE_OR: {
+      if (depth < 2)
+        return false;
+      uint8_t opcode = (inst.opcode == FilterJit::OPCODE_AND) ? 0x21 : 0x09;
+      uint8_t src = static_cast<uint8_t>(depth - 1);
+      uint8_t dst = static_cast<uint8_t>(depth - 2);
+      a.emit({0x45, opcode, static_cast<uint8_t>(0xc0 | (src << 3) | dst)});
+      --depth;
+    } break;
+    case FilterJit::OPCODE_NOT:
+      if (depth < 1)
+        return false;
+      // xor r8d + depth - 1, 1
+      a.emit({0x41, 0x83, static_cast<uint8_t>(0xf0 | (depth - 1)), 0x01});
+      break;
+    }
+  }
+  if (depth != 1)
+    return false;
+
+  a.emit({0x44, 0x88, 0x04, 0x0a}); // mov [rdx + rcx], r8b
+  a.emit({0x48, 0xff, 0xc1});       // inc rcx
+  a.emit({0x48, 0x39, 0xf1});       // cmp rcx, rsi
+  a.patch(a.jump(JB), loop);
+  a.patch(exit, a.code.size());
+#if defined(PLUGKIT_OS_WIN)
+  a.emit({0x5f, 0x5e}); // pop rdi; pop rsi
+#endif
+  a.emit({0xc3}); // ret
+  *dst = std::move(a.code);
+  return true;
+}
+
+// Maps the code as read-only and executable. Returns nullptr if the process
+// is not allowed to, and the filter is interpreted then.
+void *mapCode(const std::vector<uint8_t> &code) {
+#if defined(PLUGKIT_OS_WIN)
+  void *mem = VirtualAlloc(nullptr, code.size(), MEM_COMMIT | MEM_RESERVE,
+                           PAGE_READWRITE);
+  if (!mem)
+    return nullptr;
+  std::memcpy(mem, code.data(), code.size());
+  DWORD old;
+  if (!VirtualProtect(mem, code.size(), PAGE_EXECUTE_READ, &old)) {
+    VirtualFree(mem, 0, MEM_RELEASE);
+    return nullptr;
+  }
+  FlushInstructionCache(GetCurrentProcess(), mem, code.size());
+  return mem;
+#else
+  int flags = MAP_PRIVATE | MAP_ANON;
+#if defined(MAP_JIT)
+  flags |= MAP_JIT;
+#endif
+  void *mem = mmap(nullptr, code.size(), PROT_READ | PROT_WRITE, flags, -1, 0);
+  if (mem == MAP_FAILED)
+    return nullptr;
+  std::memcpy(mem, code.data(), code.size());
+  if (mprotect(mem, code.size(), PROT_READ | PROT_EXEC) != 0) {
+    munmap(mem, code.size());
+    return nullptr;
+  }
+  return mem;
+#endif
+}
+
+void unmapCode(void *mem, size_t size) {
+#if defined(PLUGKIT_OS_WIN)
+  VirtualFree(mem, 0, MEM_RELEASE);
+#else
+  munmap(mem, size);
+#endif
+}
+
+#endif
+} // namespace
+
+class FilterJit::Private {
+public:
+  void *mem = nullptr;
+  size_t size = 0;
+  Function func = nullptr;
+};
+
+FilterJit::FilterJit(const std::vector<Instruction> &code) : d(new Private()) {
+#if defined(PLUGKIT_FILTER_JIT_X64)
+  std::vector<uint8_t> bytes;
+  if (!assemble(code, &bytes))
+    return;
+  d->mem = mapCode(bytes);
+  if (d->mem) {
+    d->size = bytes.size();
+    d->func = reinterpret_cast<Function>(d->mem);
+  }
+#endif
+}
+
+FilterJit::~FilterJit() {
+#if defined(PLUGKIT_FILTER_JIT_X64)
+  if (d->mem) {
+    unmapCode(d->mem, d->size);
+  }
+#endif
+}
+
+bool FilterJit::valid() const { return d->func != nullptr; }
+
+void FilterJit::run(const double *const *columns, size_t size,
+                    uint8_t *results) const {
+  d->func(columns, size, results);
+}
+} // namespace plugkit
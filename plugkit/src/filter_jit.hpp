@@ -0,0 +1,66 @@
+#ifndef PLUGKIT_FILTER_JIT_HPP
+#define PLUGKIT_FILTER_JIT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace plugkit {
+
+/// Compiles the boolean part of a native filter into machine code.
+///
+/// The code is a postfix program over columns of attribute values loaded
+/// by FilterProgram. Each OPCODE_TEST compares a column with a constant
+/// without branches and the results are combined with AND, OR and NOT.
+/// Only x86-64 is supported so far; valid() returns false elsewhere and
+/// FilterProgram keeps interpreting the filter.
+class FilterJit final {
+public:
+  enum Opcode { OPCODE_TEST, OPCODE_AND, OPCODE_OR, OPCODE_NOT };
+
+  /// COMPARE_TRUTHY tests if the value is neither 0 nor NaN.
+  enum Compare {
+    COMPARE_TRUTHY,
+    COMPARE_EQ,
+    COMPARE_NE,
+    COMPARE_LT,
+    COMPARE_GT,
+    COMPARE_LE,
+    COMPARE_GE
+  };
+
+  struct Instruction {
+    Opcode opcode = OPCODE_TEST;
+
+    // Operands of OPCODE_TEST. If `masked` is set, the value is converted
+    // with ToInt32 and ANDed with `mask` before the comparison, so the
+    // column must hold integers of less than 2^63 in magnitude.
+    uint32_t column = 0;
+    bool masked = false;
+    int32_t mask = 0;
+    Compare compare = COMPARE_TRUTHY;
+    bool reversed = false;
+    double constant = 0.0;
+  };
+
+public:
+  explicit FilterJit(const std::vector<Instruction> &code);
+  ~FilterJit();
+  bool valid() const;
+
+  /// Sets results[i] to 1 if the program is true for the i-th value of the
+  /// columns and 0 otherwise.
+  void run(const double *const *columns, size_t size, uint8_t *results) const;
+
+private:
+  FilterJit(const FilterJit &) = delete;
+  FilterJit &operator=(const FilterJit &) = delete;
+
+private:
+  class Private;
+  std::unique_ptr<Private> d;
+};
+} // namespace plugkit
+
+#endif
@@ -0,0 +1,1678 @@
+#include "filter_program.hpp"
+#include "attribute.hpp"
+#include "filter_jit.hpp"
+#include "frame_view.hpp"
+#include "layer.hpp"
+#include "variant.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <json11.hpp>
+#include <limits>
+#include <vector>
+
+namespace plugkit {
+
+namespace {
+
+struct Node;
+using NodePtr = std::unique_ptr<Node>;
+struct Lowering;
+
+// Mirrors the JavaScript values seen by $_op() in filter.js.
+// TYPE_ERROR means that the script throws, and TYPE_UNSUPPORTED means that
+// the result cannot be determined without running the script.
+struct Value {
+  enum Type {
+    TYPE_ERROR,
+    TYPE_UNSUPPORTED,
+    TYPE_UNDEFINED,
+    TYPE_NULL,
+    TYPE_BOOL,
+    TYPE_NUMBER,
+    TYPE_STRING,
+    TYPE_BUFFER,
+    TYPE_ARRAY,
+    TYPE_LAYER,
+    TYPE_ATTR
+  };
+
+  Value(Type type = TYPE_UNDEFINED) : type(type) {}
+
+  Type type;
+  double number = 0.0;
+  Slice slice = {nullptr, nullptr};
+  const Layer *layer = nullptr;
+  const Attr *attr = nullptr;
+  const std::vector<NodePtr> *elements = nullptr;
+};
+
+struct Node {
+  virtual ~Node() {}
+  virtual Value eval(const FrameView *view) const = 0;
+
+  // Evaluates the node for each frame of the batch.
+  virtual void evalBatch(const FrameView **views, size_t size,
+                         Value *values) const {
+    for (size_t i = 0; i < size; ++i) {
+      values[i] = eval(views[i]);
+    }
+  }
+
+  // Shapes recognized by specializeCompare().
+  virtual bool constantNumber(double *) const { return false; }
+  virtual bool frameLayer(Token *) const { return false; }
+
+  // `layer` is 0 for `$_frame.attr()`.
+  virtual bool attrPath(Token *, Token *) const { return false; }
+
+  // `attr & mask` or `mask & attr`.
+  virtual bool maskedAttr(Token *, Token *, int32_t *, bool *) const {
+    return false;
+  }
+
+  // Appends the postfix code of the node for FilterJit. Returns false if the
+  // node has no boolean form.
+  virtual bool lower(Lowering *) const { return false; }
+};
+
+// Scratch columns are reused between batches. A program is only used by the
+// thread which owns it.
+template <class T> T *column(std::vector<T> *buffer, size_t size) {
+  if (buffer->size() < size) {
+    buffer->resize(size);
+  }
+  return buffer->data();
+}
+
+const double NaN = std::numeric_limits<double>::quiet_NaN();
+
+Value makeBool(bool value) {
+  Value result(Value::TYPE_BOOL);
+  result.number = value;
+  return result;
+}
+
+Value makeNumber(double value) {
+  Value result(Value::TYPE_NUMBER);
+  result.number = value;
+  return result;
+}
+
+Value makeSlice(Value::Type type, const Slice &slice) {
+  Value result(type);
+  result.slice = slice;
+  return result;
+}
+
+size_t sliceLength(const Slice &slice) { return slice.end - slice.begin; }
+
+bool isAbrupt(const Value &value) {
+  return value.type == Value::TYPE_ERROR ||
+         value.type == Value::TYPE_UNSUPPORTED;
+}
+
+bool isNullish(const Value &value) {
+  return value.type == Value::TYPE_UNDEFINED ||
+         value.type == Value::TYPE_NULL;
+}
+
+bool isObject(const Value &value) {
+  return value.type == Value::TYPE_BUFFER || value.type == Value::TYPE_ARRAY ||
+         value.type == Value::TYPE_LAYER || value.type == Value::TYPE_ATTR;
+}
+
+bool isIterable(const Value &value) {
+  return value.type == Value::TYPE_BUFFER || value.type == Value::TYPE_ARRAY;
+}
+
+bool isAscii(const Slice &slice) {
+  for (const char *c = slice.begin; c < slice.end; ++c) {
+    if (static_cast<unsigned char>(*c) >= 0x80)
+      return false;
+  }
+  return true;
+}
+
+Slice stringSlice(const Variant &var) {
+  // Short strings are stored in place.
+  if (var.tag() > 0) {
+    return Slice{var.d.chars, var.d.chars + var.tag()};
+  }
+  if (var.d.str) {
+    const std::string &str = **var.d.str;
+    return Slice{str.data(), str.data() + str.size()};
+  }
+  return Slice{nullptr, nullptr};
+}
+
+// Follows Variant::getValue().
+Value fromVariant(const Variant &var) {
+  switch (var.type()) {
+  case Variant::TYPE_NIL:
+    return Value(Value::TYPE_NULL);
+  case Variant::TYPE_BOOL:
+    return makeBool(var.boolValue());
+  case Variant::TYPE_INT32:
+    return makeNumber(var.int32Value());
+  case Variant::TYPE_UINT32:
+    return makeNumber(var.uint32Value());
+  case Variant::TYPE_DOUBLE:
+    return makeNumber(var.doubleValue());
+  case Variant::TYPE_STRING:
+    return makeSlice(Value::TYPE_STRING, stringSlice(var));
+  case Variant::TYPE_SLICE:
+    return makeSlice(Value::TYPE_BUFFER, var.slice());
+  default:
+    // 64-bit integers are exposed as strings and timestamps, arrays and
+    // maps as objects.
+    return Value(Value::TYPE_UNSUPPORTED);
+  }
+}
+
+bool truthy(const Value &value) {
+  switch (value.type) {
+  case Value::TYPE_BOOL:
+    return value.number != 0.0;
+  case Value::TYPE_NUMBER:
+    return value.number != 0.0 && !std::isnan(value.number);
+  case Value::TYPE_STRING:
+    return value.slice.begin != value.slice.end;
+  default:
+    return isObject(value);
+  }
+}
+
+// $_value() in filter.js
+Value unwrap(const Value &value) {
+  if (value.type == Value::TYPE_ATTR) {
+    return fromVariant(*value.attr->valueRef());
+  }
+  return value;
+}
+
+bool unwrappedTruthy(const Value &value) {
+  if (value.type == Value::TYPE_ATTR) {
+    const Variant &var = *value.attr->valueRef();
+    switch (var.type()) {
+    case Variant::TYPE_INT64:
+    case Variant::TYPE_UINT64:
+    case Variant::TYPE_TIMESTAMP:
+    case Variant::TYPE_ARRAY:
+    case Variant::TYPE_MAP:
+      return true;
+    default:
+      break;
+    }
+  }
+  return truthy(unwrap(value));
+}
+
+bool stringToNumber(const Slice &slice, double *number) {
+  const char *begin = slice.begin;
+  const char *end = slice.end;
+  if (!isAscii(slice))
+    return false;
+  while (begin < end && std::isspace(static_cast<unsigned char>(*begin)))
+    ++begin;
+  while (end > begin && std::isspace(static_cast<unsigned char>(end[-1])))
+    --end;
+
+  char buf[64];
+  size_t length = end - begin;
+  if (length == 0) {
+    *number = 0.0;
+    return true;
+  }
+  if (length >= sizeof(buf))
+    return false;
+  std::memcpy(buf, begin, length);
+  buf[length] = '\0';
+
+  if (length > 2 && buf[0] == '0') {
+    int base = 0;
+    switch (buf[1]) {
+    case 'x':
+    case 'X':
+      base = 16;
+      break;
+    case 'o':
+    case 'O':
+      base = 8;
+      break;
+    case 'b':
+    case 'B':
+      base = 2;
+      break;
+    }
+    if (base > 0) {
+      double value = 0.0;
+      for (size_t i = 2; i < length; ++i) {
+        int digit = std::isdigit(static_cast<unsigned char>(buf[i]))
+                        ? buf[i] - '0'
+                        : std::isalpha(static_cast<unsigned char>(buf[i]))
+                              ? std::tolower(buf[i]) - 'a' + 10
+                              : base;
+        if (digit >= base) {
+          *number = NaN;
+          return true;
+        }
+        value = value * base + digit;
+      }
+      *number = value;
+      return true;
+    }
+  }
+
+  size_t i = 0;
+  double sign = 1.0;
+  if (buf[i] == '+' || buf[i] == '-') {
+    sign = (buf[i] == '-') ? -1.0 : 1.0;
+    ++i;
+  }
+  if (std::strcmp(buf + i, "Infinity") == 0) {
+    *number = sign * std::numeric_limits<double>::infinity();
+    return true;
+  }
+  size_t digits = 0;
+  for (; std::isdigit(static_cast<unsigned char>(buf[i])); ++i, ++digits)
+    ;
+  if (buf[i] == '.') {
+    for (++i; std::isdigit(static_cast<unsigned char>(buf[i])); ++i, ++digits)
+      ;
+  }
+  if (digits > 0 && (buf[i] == 'e' || buf[i] == 'E')) {
+    ++i;
+    if (buf[i] == '+' || buf[i] == '-')
+      ++i;
+    size_t expDigits = 0;
+    for (; std::isdigit(static_cast<unsigned char>(buf[i])); ++i, ++expDigits)
+      ;
+    if (expDigits == 0)
+      digits = 0;
+  }
+  *number = (digits > 0 && i == length) ? std::strtod(buf, nullptr) : NaN;
+  return true;
+}
+
+// Returns false if the conversion requires ToPrimitive() on an object.
+bool toNumber(const Value &value, double *number) {
+  switch (value.type) {
+  case Value::TYPE_UNDEFINED:
+    *number = NaN;
+    return true;
+  case Value::TYPE_NULL:
+    *number = 0.0;
+    return true;
+  case Value::TYPE_BOOL:
+  case Value::TYPE_NUMBER:
+    *number = value.number;
+    return true;
+  case Value::TYPE_STRING:
+    return stringToNumber(value.slice, number);
+  default:
+    return false;
+  }
+}
+
+int32_t toInt32(double number) {
+  if (!std::isfinite(number))
+    return 0;
+  double value = std::fmod(std::trunc(number), 4294967296.0);
+  if (value < 0)
+    value += 4294967296.0;
+  return static_cast<int32_t>(static_cast<uint32_t>(value));
+}
+
+int compareSlices(const Slice &a, const Slice &b) {
+  size_t lengthA = sliceLength(a);
+  size_t lengthB = sliceLength(b);
+  int result = (lengthA && lengthB)
+                   ? std::memcmp(a.begin, b.begin, std::min(lengthA, lengthB))
+                   : 0;
+  if (result != 0)
+    return result;
+  return (lengthA < lengthB) ? -1 : (lengthA > lengthB) ? 1 : 0;
+}
+
+Value strictEquals(const Value &a, const Value &b) {
+  if (isObject(a) && isObject(b)) {
+    // Wrappers are created on each access, so the identity is unknown.
+    return (a.type == b.type) ? Value(Value::TYPE_UNSUPPORTED)
+                              : makeBool(false);
+  }
+  if (a.type != b.type)
+    return makeBool(false);
+  switch (a.type) {
+  case Value::TYPE_BOOL:
+  case Value::TYPE_NUMBER:
+    return makeBool(a.number == b.number);
+  case Value::TYPE_STRING:
+    return makeBool(compareSlices(a.slice, b.slice) == 0);
+  default:
+    return makeBool(true);
+  }
+}
+
+Value looseEquals(const Value &a, const Value &b) {
+  if (a.type == b.type || (isObject(a) && isObject(b)))
+    return strictEquals(a, b);
+  if (isNullish(a) || isNullish(b))
+    return makeBool(isNullish(a) && isNullish(b));
+  if (isObject(a) || isObject(b))
+    return Value(Value::TYPE_UNSUPPORTED);
+  double numA;
+  double numB;
+  if (!toNumber(a, &numA) || !toNumber(b, &numB))
+    return Value(Value::TYPE_UNSUPPORTED);
+  return makeBool(numA == numB);
+}
+
+enum Order { ORDER_LESS, ORDER_EQUAL, ORDER_GREATER, ORDER_NONE };
+
+// Abstract relational comparison. Returns false if it cannot be determined.
+bool compare(const Value &a, const Value &b, Order *order) {
+  if (a.type == Value::TYPE_STRING && b.type == Value::TYPE_STRING) {
+    // UTF-8 and UTF-16 code unit orders differ outside the ASCII range.
+    if (!isAscii(a.slice) || !isAscii(b.slice))
+      return false;
+    int result = compareSlices(a.slice, b.slice);
+    *order = (result < 0) ? ORDER_LESS
+                          : (result > 0) ? ORDER_GREATER : ORDER_EQUAL;
+    return true;
+  }
+  double numA;
+  double numB;
+  if (!toNumber(a, &numA) || !toNumber(b, &numB))
+    return false;
+  if (std::isnan(numA) || std::isnan(numB)) {
+    *order = ORDER_NONE;
+  } else {
+    *order = (numA < numB) ? ORDER_LESS
+                           : (numA > numB) ? ORDER_GREATER : ORDER_EQUAL;
+  }
+  return true;
+}
+
+enum Opcode {
+  OP_ADD,
+  OP_SUB,
+  OP_MUL,
+  OP_DIV,
+  OP_MOD,
+  OP_EXP,
+  OP_BIT_OR,
+  OP_BIT_XOR,
+  OP_BIT_AND,
+  OP_BIT_NOT,
+  OP_SHL,
+  OP_SAR,
+  OP_SHR,
+  OP_EQ,
+  OP_NE,
+  OP_STRICT_EQ,
+  OP_STRICT_NE,
+  OP_LT,
+  OP_GT,
+  OP_LE,
+  OP_GE,
+  OP_OR,
+  OP_AND,
+  OP_NOT
+};
+
+bool findOpcode(const std::string &name, Opcode *opcode) {
+  static const struct {
+    const char *name;
+    Opcode opcode;
+  } opcodes[] = {{"+", OP_ADD},       {"-", OP_SUB},        {"*", OP_MUL},
+                 {"/", OP_DIV},       {"%", OP_MOD},        {"**", OP_EXP},
+                 {"|", OP_BIT_OR},    {"^", OP_BIT_XOR},    {"&", OP_BIT_AND},
+                 {"~", OP_BIT_NOT},   {"<<", OP_SHL},       {">>", OP_SAR},
+                 {">>>", OP_SHR},     {"==", OP_EQ},        {"!=", OP_NE},
+                 {"===", OP_STRICT_EQ}, {"!==", OP_STRICT_NE}, {"<", OP_LT},
+                 {">", OP_GT},        {"<=", OP_LE},        {">=", OP_GE},
+                 {"||", OP_OR},       {"&&", OP_AND},       {"!", OP_NOT}};
+  for (const auto &op : opcodes) {
+    if (name == op.name) {
+      *opcode = op.opcode;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool element(const Value &iterable, size_t index, const FrameView *view,
+             Value *value) {
+  if (iterable.type == Value::TYPE_BUFFER) {
+    if (index >= sliceLength(iterable.slice))
+      return false;
+    *value =
+        makeNumber(static_cast<unsigned char>(iterable.slice.begin[index]));
+    return true;
+  }
+  if (index >= iterable.elements->size())
+    return false;
+  *value = (*iterable.elements)[index]->eval(view);
+  return true;
+}
+
+// Element-wise comparison of two iterables in $_op().
+Value compareIterables(Opcode opcode, const Value &left, const Value &right,
+                       const FrameView *view) {
+  for (size_t i = 0;; ++i) {
+    Value leftValue;
+    Value rightValue;
+    bool leftDone = !element(left, i, view, &leftValue);
+    bool rightDone = !element(right, i, view, &rightValue);
+    if (isAbrupt(leftValue))
+      return leftValue;
+    if (isAbrupt(rightValue))
+      return rightValue;
+
+    switch (opcode) {
+    case OP_EQ:
+    case OP_STRICT_EQ:
+    case OP_NE:
+    case OP_STRICT_NE: {
+      bool equal = (opcode == OP_EQ || opcode == OP_STRICT_EQ);
+      Value same = strictEquals(leftValue, rightValue);
+      if (isAbrupt(same))
+        return same;
+      if (!truthy(same) || leftDone != rightDone)
+        return makeBool(!equal);
+      if (leftDone && rightDone)
+        return makeBool(equal);
+    } break;
+    default: {
+      Order order;
+      if (!compare(leftValue, rightValue, &order))
+        return Value(Value::TYPE_UNSUPPORTED);
+      bool greater = (opcode == OP_GT || opcode == OP_GE);
+      if (order == (greater ? ORDER_GREATER : ORDER_LESS))
+        return makeBool(true);
+      if (order == (greater ? ORDER_LESS : ORDER_GREATER))
+        return makeBool(false);
+      if (leftDone || rightDone)
+        return makeBool(opcode == OP_LE || opcode == OP_GE);
+    }
+    }
+  }
+}
+
+// Plain loops over dense arrays, which the compiler can vectorize.
+void compareNumbers(Opcode opcode, const double *x, const double *y,
+                    size_t size, char *results) {
+  switch (opcode) {
+  case OP_EQ:
+  case OP_STRICT_EQ:
+    for (size_t i = 0; i < size; ++i)
+      results[i] = x[i] == y[i];
+    break;
+  case OP_NE:
+  case OP_STRICT_NE:
+    for (size_t i = 0; i < size; ++i)
+      results[i] = x[i] != y[i];
+    break;
+  case OP_LT:
+    for (size_t i = 0; i < size; ++i)
+      results[i] = x[i] < y[i];
+    break;
+  case OP_GT:
+    for (size_t i = 0; i < size; ++i)
+      results[i] = x[i] > y[i];
+    break;
+  case OP_LE:
+    for (size_t i = 0; i < size; ++i)
+      results[i] = x[i] <= y[i];
+    break;
+  case OP_GE:
+    for (size_t i = 0; i < size; ++i)
+      results[i] = x[i] >= y[i];
+    break;
+  default:
+    break;
+  }
+}
+
+enum Load { LOAD_NUMBER, LOAD_ERROR, LOAD_GENERIC };
+
+// Loads the attribute `attr` of the layer `layer`, or of the frame if
+// `layer` is 0, as a number. Values other than 32-bit numbers and doubles
+// are left to the generic nodes.
+char loadNumber(const FrameView *view, Token layer, Token attr, bool reversed,
+                double *value) {
+  *value = 0.0;
+  const Attr *found = nullptr;
+  if (layer == 0) {
+    found = view->attr(attr);
+  } else if (const Layer *parent = view->layer(layer)) {
+    found = parent->attr(attr);
+  } else {
+    return LOAD_ERROR;
+  }
+
+  // A missing attribute is null, which only throws on the left side.
+  if (!found)
+    return reversed ? LOAD_GENERIC : LOAD_ERROR;
+  const Variant &var = *found->valueRef();
+  switch (var.type()) {
+  case Variant::TYPE_INT32:
+    *value = var.int32Value();
+    return LOAD_NUMBER;
+  case Variant::TYPE_UINT32:
+    *value = var.uint32Value();
+    return LOAD_NUMBER;
+  case Variant::TYPE_DOUBLE:
+    *value = var.doubleValue();
+    return LOAD_NUMBER;
+  default:
+    return LOAD_GENERIC;
+  }
+}
+
+bool lowerCompare(Opcode opcode, FilterJit::Compare *compare) {
+  switch (opcode) {
+  case OP_EQ:
+  case OP_STRICT_EQ:
+    *compare = FilterJit::COMPARE_EQ;
+    return true;
+  case OP_NE:
+  case OP_STRICT_NE:
+    *compare = FilterJit::COMPARE_NE;
+    return true;
+  case OP_LT:
+    *compare = FilterJit::COMPARE_LT;
+    return true;
+  case OP_GT:
+    *compare = FilterJit::COMPARE_GT;
+    return true;
+  case OP_LE:
+    *compare = FilterJit::COMPARE_LE;
+    return true;
+  case OP_GE:
+    *compare = FilterJit::COMPARE_GE;
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Attribute columns and postfix code of a filter lowered for FilterJit.
+//
+// The code only sees numbers, so a frame is left to the nodes if any of its
+// columns is not loaded as a number. A column which fails to load with
+// LOAD_ERROR makes the whole filter throw, since the operators lowered
+// evaluate all of their operands.
+struct Lowering {
+  struct Column {
+    Token layer;
+    Token attr;
+    bool reversed;
+    bool integral;
+  };
+
+  void test(Token layer, Token attr, bool reversed,
+            FilterJit::Instruction inst) {
+    const Column column = {layer, attr, reversed, inst.masked};
+    uint32_t index = 0;
+    for (; index < columns.size(); ++index) {
+      const Column &other = columns[index];
+      if (other.layer == layer && other.attr == attr &&
+          other.reversed == reversed && other.integral == column.integral)
+        break;
+    }
+    if (index == columns.size()) {
+      columns.push_back(column);
+    }
+    inst.opcode = FilterJit::OPCODE_TEST;
+    inst.column = index;
+    code.push_back(inst);
+  }
+
+  void push(FilterJit::Opcode opcode) {
+    FilterJit::Instruction inst;
+    inst.opcode = opcode;
+    code.push_back(inst);
+  }
+
+  static char load(const FrameView *view, const Column &column,
+                   double *value) {
+    char load =
+        loadNumber(view, column.layer, column.attr, column.reversed, value);
+
+    // The native ToInt32 truncates the number to 64 bits first.
+    if (load == LOAD_NUMBER && column.integral &&
+        !(std::fabs(*value) < 9223372036854775808.0))
+      return LOAD_GENERIC;
+    return load;
+  }
+
+  std::vector<Column> columns;
+  std::vector<FilterJit::Instruction> code;
+};
+
+struct ConstantNode final : public Node {
+  ConstantNode(const Value &value, const std::string &str = std::string())
+      : value(value), str(str) {
+    if (value.type == Value::TYPE_STRING) {
+      this->value.slice =
+          Slice{this->str.data(), this->str.data() + this->str.size()};
+    }
+  }
+  Value eval(const FrameView *) const override { return value; }
+  bool constantNumber(double *number) const override {
+    *number = value.number;
+    return value.type == Value::TYPE_NUMBER;
+  }
+
+  Value value;
+  const std::string str;
+};
+
+struct ArrayNode final : public Node {
+  Value eval(const FrameView *view) const override {
+    // Elements are evaluated again on iteration, but errors must be raised
+    // on creation as the script does.
+    for (const NodePtr &element : elements) {
+      Value value = element->eval(view);
+      if (isAbrupt(value))
+        return value;
+    }
+    Value value(Value::TYPE_ARRAY);
+    value.elements = &elements;
+    return value;
+  }
+
+  std::vector<NodePtr> elements;
+};
+
+struct FrameLayerNode final : public Node {
+  FrameLayerNode(Token id) : id(id) {}
+  bool frameLayer(Token *layer) const override {
+    *layer = id;
+    return true;
+  }
+  Value eval(const FrameView *view) const override {
+    Value value(Value::TYPE_NULL);
+    if (const Layer *layer = view->layer(id)) {
+      value.type = Value::TYPE_LAYER;
+      value.layer = layer;
+    }
+    return value;
+  }
+
+  const Token id;
+};
+
+struct FrameAttrNode final : public Node {
+  FrameAttrNode(Token id) : id(id) {}
+  bool attrPath(Token *layer, Token *attr) const override {
+    *layer = 0;
+    *attr = id;
+    return true;
+  }
+  Value eval(const FrameView *view) const override {
+    Value value(Value::TYPE_NULL);
+    if (const Attr *attr = view->attr(id)) {
+      value.type = Value::TYPE_ATTR;
+      value.attr = attr;
+    }
+    return value;
+  }
+
+  const Token id;
+};
+
+struct LayerAttrNode final : public Node {
+  LayerAttrNode(NodePtr object, Token id) : object(std::move(object)), id(id) {}
+  bool attrPath(Token *layer, Token *attr) const override {
+    *attr = id;
+    return object->frameLayer(layer);
+  }
+  Value eval(const FrameView *view) const override {
+    return apply(object->eval(view));
+  }
+  void evalBatch(const FrameView **views, size_t size,
+                 Value *values) const override {
+    Value *layers = column(&layerColumn, size);
+    object->evalBatch(views, size, layers);
+    for (size_t i = 0; i < size; ++i) {
+      values[i] = apply(layers[i]);
+    }
+  }
+  Value apply(const Value &layer) const {
+    if (isAbrupt(layer))
+      return layer;
+    if (layer.type != Value::TYPE_LAYER)
+      return Value(Value::TYPE_ERROR);
+    Value value(Value::TYPE_NULL);
+    if (const Attr *attr = layer.layer->attr(id)) {
+      value.type = Value::TYPE_ATTR;
+      value.attr = attr;
+    }
+    return value;
+  }
+
+  const NodePtr object;
+  const Token id;
+  mutable std::vector<Value> layerColumn;
+};
+
+struct PropertyNode final : public Node {
+  enum Property { PROPERTY_VALUE, PROPERTY_LENGTH };
+
+  PropertyNode(NodePtr object, Property property)
+      : object(std::move(object)), property(property) {}
+  bool attrPath(Token *layer, Token *attr) const override {
+    return property == PROPERTY_VALUE && object->attrPath(layer, attr);
+  }
+  Value eval(const FrameView *view) const override {
+    return apply(object->eval(view));
+  }
+  void evalBatch(const FrameView **views, size_t size,
+                 Value *values) const override {
+    Value *objects = column(&objectColumn, size);
+    object->evalBatch(views, size, objects);
+    for (size_t i = 0; i < size; ++i) {
+      values[i] = apply(objects[i]);
+    }
+  }
+  Value apply(const Value &value) const {
+    if (isAbrupt(value))
+      return value;
+    if (isNullish(value))
+      return Value(Value::TYPE_ERROR);
+    if (property == PROPERTY_VALUE) {
+      return (value.type == Value::TYPE_ATTR) ? unwrap(value)
+                                              : Value(Value::TYPE_UNSUPPORTED);
+    }
+    switch (value.type) {
+    case Value::TYPE_STRING:
+      if (!isAscii(value.slice))
+        return Value(Value::TYPE_UNSUPPORTED);
+      return makeNumber(sliceLength(value.slice));
+    case Value::TYPE_BUFFER:
+      return makeNumber(sliceLength(value.slice));
+    case Value::TYPE_ARRAY:
+      return makeNumber(value.elements->size());
+    default:
+      return Value(Value::TYPE_UNSUPPORTED);
+    }
+  }
+
+  const NodePtr object;
+  const Property property;
+  mutable std::vector<Value> objectColumn;
+};
+
+struct IndexNode final : public Node {
+  IndexNode(NodePtr object, NodePtr index)
+      : object(std::move(object)), index(std::move(index)) {}
+  Value eval(const FrameView *view) const override {
+    Value value = object->eval(view);
+    if (isAbrupt(value))
+      return value;
+    Value key = index->eval(view);
+    if (isAbrupt(key))
+      return key;
+    if (isNullish(value))
+      return Value(Value::TYPE_ERROR);
+    if (key.type != Value::TYPE_NUMBER || key.number < 0 ||
+        key.number != std::floor(key.number))
+      return Value(Value::TYPE_UNSUPPORTED);
+
+    size_t i = static_cast<size_t>(key.number);
+    switch (value.type) {
+    case Value::TYPE_STRING:
+      if (!isAscii(value.slice))
+        return Value(Value::TYPE_UNSUPPORTED);
+      if (i >= sliceLength(value.slice))
+        return Value(Value::TYPE_UNDEFINED);
+      return makeSlice(Value::TYPE_STRING,
+                       Slice{value.slice.begin + i, value.slice.begin + i + 1});
+    case Value::TYPE_BUFFER:
+    case Value::TYPE_ARRAY: {
+      Value item;
+      return element(value, i, view, &item) ? item
+                                            : Value(Value::TYPE_UNDEFINED);
+    }
+    default:
+      return Value(Value::TYPE_UNSUPPORTED);
+    }
+  }
+
+  const NodePtr object;
+  const NodePtr index;
+};
+
+// Native `!` operator, which does not unwrap attributes.
+struct NotNode final : public Node {
+  NotNode(NodePtr argument) : argument(std::move(argument)) {}
+  Value eval(const FrameView *view) const override {
+    return apply(argument->eval(view));
+  }
+  void evalBatch(const FrameView **views, size_t size,
+                 Value *values) const override {
+    argument->evalBatch(views, size, values);
+    for (size_t i = 0; i < size; ++i) {
+      values[i] = apply(values[i]);
+    }
+  }
+  Value apply(const Value &value) const {
+    return isAbrupt(value) ? value : makeBool(!truthy(value));
+  }
+  bool lower(Lowering *lowering) const override {
+    if (!argument->lower(lowering))
+      return false;
+    lowering->push(FilterJit::OPCODE_NOT);
+    return true;
+  }
+
+  const NodePtr argument;
+};
+
+struct ConditionalNode final : public Node {
+  ConditionalNode(NodePtr test, NodePtr consequent, NodePtr alternate)
+      : test(std::move(test)), consequent(std::move(consequent)),
+        alternate(std::move(alternate)) {}
+  Value eval(const FrameView *view) const override {
+    Value value = test->eval(view);
+    if (isAbrupt(value))
+      return value;
+    return truthy(value) ? consequent->eval(view) : alternate->eval(view);
+  }
+
+  const NodePtr test;
+  const NodePtr consequent;
+  const NodePtr alternate;
+};
+
+struct UnaryOpNode final : public Node {
+  UnaryOpNode(Opcode opcode, NodePtr argument)
+      : opcode(opcode), argument(std::move(argument)) {}
+  Value eval(const FrameView *view) const override {
+    return apply(argument->eval(view));
+  }
+  void evalBatch(const FrameView **views, size_t size,
+                 Value *values) const override {
+    argument->evalBatch(views, size, values);
+    for (size_t i = 0; i < size; ++i) {
+      values[i] = apply(values[i]);
+    }
+  }
+  Value apply(const Value &raw) const {
+    if (isAbrupt(raw))
+      return raw;
+    if (opcode == OP_NOT)
+      return makeBool(!unwrappedTruthy(raw));
+
+    Value value = unwrap(raw);
+    double number;
+    if (isAbrupt(value) || !toNumber(value, &number))
+      return Value(Value::TYPE_UNSUPPORTED);
+    switch (opcode) {
+    case OP_ADD:
+      return makeNumber(number);
+    case OP_SUB:
+      return makeNumber(-number);
+    default:
+      return makeNumber(~toInt32(number));
+    }
+  }
+
+  bool lower(Lowering *lowering) const override {
+    if (opcode != OP_NOT || !argument->lower(lowering))
+      return false;
+    lowering->push(FilterJit::OPCODE_NOT);
+    return true;
+  }
+
+  const Opcode opcode;
+  const NodePtr argument;
+};
+
+struct BinaryOpNode final : public Node {
+  BinaryOpNode(Opcode opcode, NodePtr left, NodePtr right)
+      : opcode(opcode), left(std::move(left)), right(std::move(right)) {}
+  Value eval(const FrameView *view) const override {
+    Value rawLeft = left->eval(view);
+    if (isAbrupt(rawLeft))
+      return rawLeft;
+    return apply(rawLeft, right->eval(view), view);
+  }
+  void evalBatch(const FrameView **views, size_t size,
+                 Value *values) const override {
+    Value *lefts = column(&leftColumn, size);
+    Value *rights = column(&rightColumn, size);
+    left->evalBatch(views, size, lefts);
+    right->evalBatch(views, size, rights);
+    if (opcode >= OP_EQ && opcode <= OP_GE) {
+      // Gather the operands into dense columns of numbers.
+      double *x = column(&leftNumbers, size);
+      double *y = column(&rightNumbers, size);
+      bool numeric = true;
+      for (size_t i = 0; i < size && numeric; ++i) {
+        const Value &a = unwrap(lefts[i]);
+        const Value &b = unwrap(rights[i]);
+        numeric = (a.type == Value::TYPE_NUMBER && b.type == Value::TYPE_NUMBER);
+        x[i] = a.number;
+        y[i] = b.number;
+      }
+      if (numeric) {
+        char *results = column(&resultColumn, size);
+        compareNumbers(opcode, x, y, size, results);
+        for (size_t i = 0; i < size; ++i) {
+          values[i] = makeBool(results[i]);
+        }
+        return;
+      }
+    }
+    for (size_t i = 0; i < size; ++i) {
+      values[i] = apply(lefts[i], rights[i], views[i]);
+    }
+  }
+  Value apply(const Value &rawLeft, const Value &rawRight,
+              const FrameView *view) const {
+    if (isAbrupt(rawLeft))
+      return rawLeft;
+    if (isAbrupt(rawRight))
+      return rawRight;
+    Value a = unwrap(rawLeft);
+    if (isAbrupt(a))
+      return a;
+    Value b = unwrap(rawRight);
+    if (isAbrupt(b))
+      return b;
+
+    // `Symbol.iterator in null` throws before any operator is applied.
+    if (a.type == Value::TYPE_NULL ||
+        (isIterable(a) && b.type == Value::TYPE_NULL))
+      return Value(Value::TYPE_ERROR);
+
+    // The result is the raw operand, not the unwrapped value.
+    if (opcode == OP_OR)
+      return truthy(a) ? rawLeft : rawRight;
+    if (opcode == OP_AND)
+      return truthy(a) ? rawRight : rawLeft;
+    if (isIterable(a) && isIterable(b)) {
+      switch (opcode) {
+      case OP_EQ:
+      case OP_NE:
+      case OP_STRICT_EQ:
+      case OP_STRICT_NE:
+      case OP_LT:
+      case OP_GT:
+      case OP_LE:
+      case OP_GE:
+        return compareIterables(opcode, a, b, view);
+      default:
+        break;
+      }
+    }
+
+    switch (opcode) {
+    case OP_EQ:
+    case OP_NE: {
+      Value equal = looseEquals(a, b);
+      return (isAbrupt(equal) || opcode == OP_EQ) ? equal
+                                                  : makeBool(!truthy(equal));
+    }
+    case OP_STRICT_EQ:
+    case OP_STRICT_NE: {
+      Value equal = strictEquals(a, b);
+      return (isAbrupt(equal) || opcode == OP_STRICT_EQ)
+                 ? equal
+                 : makeBool(!truthy(equal));
+    }
+    case OP_LT:
+    case OP_GT:
+    case OP_LE:
+    case OP_GE: {
+      Order order;
+      if (isObject(a) || isObject(b) || !compare(a, b, &order))
+        return Value(Value::TYPE_UNSUPPORTED);
+      switch (opcode) {
+      case OP_LT:
+        return makeBool(order == ORDER_LESS);
+      case OP_GT:
+        return makeBool(order == ORDER_GREATER);
+      case OP_LE:
+        return makeBool(order == ORDER_LESS || order == ORDER_EQUAL);
+      default:
+        return makeBool(order == ORDER_GREATER || order == ORDER_EQUAL);
+      }
+    }
+    default:
+      break;
+    }
+
+    // Concatenation needs a new string, so it is left to the script.
+    double x;
+    double y;
+    if (a.type == Value::TYPE_STRING || b.type == Value::TYPE_STRING ||
+        !toNumber(a, &x) || !toNumber(b, &y))
+      return Value(Value::TYPE_UNSUPPORTED);
+    switch (opcode) {
+    case OP_ADD:
+      return makeNumber(x + y);
+    case OP_SUB:
+      return makeNumber(x - y);
+    case OP_MUL:
+      return makeNumber(x * y);
+    case OP_DIV:
+      return makeNumber(x / y);
+    case OP_MOD:
+      return makeNumber(std::fmod(x, y));
+    case OP_EXP:
+      if (std::isnan(y) || (std::fabs(x) == 1.0 && std::isinf(y)))
+        return makeNumber(NaN);
+      return makeNumber(std::pow(x, y));
+    case OP_BIT_OR:
+      return makeNumber(toInt32(x) | toInt32(y));
+    case OP_BIT_XOR:
+      return makeNumber(toInt32(x) ^ toInt32(y));
+    case OP_BIT_AND:
+      return makeNumber(toInt32(x) & toInt32(y));
+    case OP_SHL:
+      return makeNumber(static_cast<int32_t>(static_cast<uint32_t>(toInt32(x))
+                                             << (toInt32(y) & 0x1f)));
+    case OP_SAR:
+      return makeNumber(toInt32(x) >> (toInt32(y) & 0x1f));
+    case OP_SHR:
+      return makeNumber(static_cast<uint32_t>(toInt32(x)) >>
+                        (toInt32(y) & 0x1f));
+    default:
+      return Value(Value::TYPE_UNSUPPORTED);
+    }
+  }
+
+  bool maskedAttr(Token *layer, Token *attr, int32_t *mask,
+                  bool *reversed) const override {
+    double number;
+    if (opcode != OP_BIT_AND)
+      return false;
+    if (left->attrPath(layer, attr) && right->constantNumber(&number)) {
+      *reversed = false;
+    } else if (left->constantNumber(&number) &&
+               right->attrPath(layer, attr)) {
+      *reversed = true;
+    } else {
+      return false;
+    }
+    *mask = toInt32(number);
+    return true;
+  }
+  bool lower(Lowering *lowering) const override {
+    Token layer;
+    Token attr;
+    bool reversed;
+    FilterJit::Instruction inst;
+    switch (opcode) {
+    case OP_AND:
+    case OP_OR:
+      if (!left->lower(lowering) || !right->lower(lowering))
+        return false;
+      lowering->push((opcode == OP_AND) ? FilterJit::OPCODE_AND
+                                        : FilterJit::OPCODE_OR);
+      return true;
+    case OP_BIT_AND:
+      // The truthiness of `attr & mask`.
+      if (!maskedAttr(&layer, &attr, &inst.mask, &reversed))
+        return false;
+      inst.masked = true;
+      lowering->test(layer, attr, reversed, inst);
+      return true;
+    default:
+      break;
+    }
+
+    // `value <op> number` or `number <op> value`, where the value is an
+    // attribute or a masked attribute.
+    const Node *value;
+    if (!lowerCompare(opcode, &inst.compare))
+      return false;
+    if (right->constantNumber(&inst.constant)) {
+      value = left.get();
+    } else if (left->constantNumber(&inst.constant)) {
+      value = right.get();
+      inst.reversed = true;
+    } else {
+      return false;
+    }
+    if (value->attrPath(&layer, &attr)) {
+      reversed = inst.reversed;
+    } else if (value->maskedAttr(&layer, &attr, &inst.mask, &reversed)) {
+      inst.masked = true;
+    } else {
+      return false;
+    }
+    lowering->test(layer, attr, reversed, inst);
+    return true;
+  }
+
+  const Opcode opcode;
+  const NodePtr left;
+  const NodePtr right;
+  mutable std::vector<Value> leftColumn;
+  mutable std::vector<Value> rightColumn;
+  mutable std::vector<double> leftNumbers;
+  mutable std::vector<double> rightNumbers;
+  mutable std::vector<char> resultColumn;
+};
+
+// Comparison of an attribute with a number, which most filters consist of.
+//
+// The attribute is loaded straight from the frame without boxing the
+// intermediate layer and attribute values, and the column is compared in a
+// single branch-free loop. Frames whose attribute is not a number fall back
+// to the generic node.
+struct AttrCompareNode final : public Node {
+  AttrCompareNode(Opcode opcode, bool reversed, Token layer, Token attr,
+                  double number, NodePtr generic)
+      : opcode(opcode), reversed(reversed), layer(layer), attr(attr),
+        number(number), generic(std::move(generic)) {}
+  Value eval(const FrameView *view) const override {
+    double x;
+    switch (load(view, &x)) {
+    case LOAD_NUMBER: {
+      char result;
+      if (reversed) {
+        compareNumbers(opcode, &number, &x, 1, &result);
+      } else {
+        compareNumbers(opcode, &x, &number, 1, &result);
+      }
+      return makeBool(result);
+    }
+    case LOAD_ERROR:
+      return Value(Value::TYPE_ERROR);
+    default:
+      return generic->eval(view);
+    }
+  }
+  void evalBatch(const FrameView **views, size_t size,
+                 Value *values) const override {
+    double *x = column(&numberColumn, size);
+    char *loads = column(&loadColumn, size);
+    for (size_t i = 0; i < size; ++i) {
+      loads[i] = load(views[i], &x[i]);
+    }
+    if (constantColumn.size() < size) {
+      constantColumn.resize(size, number);
+    }
+    const double *y = constantColumn.data();
+    char *results = column(&resultColumn, size);
+    if (reversed) {
+      compareNumbers(opcode, y, x, size, results);
+    } else {
+      compareNumbers(opcode, x, y, size, results);
+    }
+    for (size_t i = 0; i < size; ++i) {
+      switch (loads[i]) {
+      case LOAD_NUMBER:
+        values[i] = makeBool(results[i]);
+        break;
+      case LOAD_ERROR:
+        values[i] = Value(Value::TYPE_ERROR);
+        break;
+      default:
+        values[i] = generic->eval(views[i]);
+      }
+    }
+  }
+  char load(const FrameView *view, double *value) const {
+    return loadNumber(view, layer, attr, reversed, value);
+  }
+  bool lower(Lowering *lowering) const override {
+    return generic->lower(lowering);
+  }
+
+  const Opcode opcode;
+  const bool reversed;
+  const Token layer;
+  const Token attr;
+  const double number;
+  const NodePtr generic;
+  mutable std::vector<double> numberColumn;
+  mutable std::vector<double> constantColumn;
+  mutable std::vector<char> loadColumn;
+  mutable std::vector<char> resultColumn;
+};
+
+// Replaces the generic node of `attr <op> number` and `number <op> attr`
+// with AttrCompareNode.
+NodePtr specializeCompare(std::unique_ptr<BinaryOpNode> node) {
+  if (node->opcode < OP_EQ || node->opcode > OP_GE)
+    return std::move(node);
+  Token layer;
+  Token attr;
+  double number;
+  bool reversed = false;
+  if (node->left->attrPath(&layer, &attr) &&
+      node->right->constantNumber(&number)) {
+    reversed = false;
+  } else if (node->left->constantNumber(&number) &&
+             node->right->attrPath(&layer, &attr)) {
+    reversed = true;
+  } else {
+    return std::move(node);
+  }
+  Opcode opcode = node->opcode;
+  return NodePtr(new AttrCompareNode(opcode, reversed, layer, attr, number,
+                                     std::move(node)));
+}
+
+bool isIdentifier(const json11::Json &node, const char *name) {
+  return node["type"].string_value() == "Identifier" &&
+         node["name"].string_value() == name;
+}
+
+bool compileToken(const json11::Json &node, Token *token) {
+  if (node["type"].string_value() != "Literal")
+    return false;
+  const json11::Json &value = node["value"];
+  if (value.is_number()) {
+    *token = static_cast<Token>(value.number_value());
+    return true;
+  }
+  if (value.is_string()) {
+    *token = Token_get(value.string_value().c_str());
+    return true;
+  }
+  return false;
+}
+
+NodePtr compile(const json11::Json &node, bool specialize);
+
+NodePtr compileCall(const json11::Json &node, bool specialize) {
+  const json11::Json &callee = node["callee"];
+  const auto &args = node["arguments"].array_items();
+
+  if (isIdentifier(callee, "$_op")) {
+    Opcode opcode;
+    if (args.empty() || !args[0]["value"].is_string() ||
+        !findOpcode(args[0]["value"].string_value(), &opcode))
+      return nullptr;
+    if (args.size() == 2) {
+      switch (opcode) {
+      case OP_ADD:
+      case OP_SUB:
+      case OP_BIT_NOT:
+      case OP_NOT:
+        if (NodePtr argument = compile(args[1], specialize))
+          return NodePtr(new UnaryOpNode(opcode, std::move(argument)));
+      default:
+        return nullptr;
+      }
+    }
+    if (args.size() == 3 && opcode != OP_BIT_NOT && opcode != OP_NOT) {
+      NodePtr left = compile(args[1], specialize);
+      NodePtr right = compile(args[2], specialize);
+      if (left && right) {
+        std::unique_ptr<BinaryOpNode> node(
+            new BinaryOpNode(opcode, std::move(left), std::move(right)));
+        if (specialize)
+          return specializeCompare(std::move(node));
+        return std::move(node);
+      }
+    }
+    return nullptr;
+  }
+
+  Token token;
+  if (callee["type"].string_value() != "MemberExpression" ||
+      callee["computed"].bool_value() || args.size() != 1 ||
+      !compileToken(args[0], &token))
+    return nullptr;
+  const std::string &method = callee["property"]["name"].string_value();
+  const json11::Json &object = callee["object"];
+  if (isIdentifier(object, "$_frame")) {
+    if (method == "layer")
+      return NodePtr(new FrameLayerNode(token));
+    if (method == "attr")
+      return NodePtr(new FrameAttrNode(token));
+  } else if (method == "attr") {
+    if (NodePtr layer = compile(object, specialize))
+      return NodePtr(new LayerAttrNode(std::move(layer), token));
+  }
+  return nullptr;
+}
+
+NodePtr compileMember(const json11::Json &node, bool specialize) {
+  NodePtr object = compile(node["object"], specialize);
+  if (!object)
+    return nullptr;
+  if (node["computed"].bool_value()) {
+    if (NodePtr index = compile(node["property"], specialize))
+      return NodePtr(new IndexNode(std::move(object), std::move(index)));
+    return nullptr;
+  }
+  const std::string &name = node["property"]["name"].string_value();
+  if (name == "value")
+    return NodePtr(
+        new PropertyNode(std::move(object), PropertyNode::PROPERTY_VALUE));
+  if (name == "length")
+    return NodePtr(
+        new PropertyNode(std::move(object), PropertyNode::PROPERTY_LENGTH));
+  return nullptr;
+}
+
+NodePtr compile(const json11::Json &node, bool specialize) {
+  const std::string &type = node["type"].string_value();
+  if (type == "Literal") {
+    const json11::Json &value = node["value"];
+    if (!node["regex"].is_null())
+      return nullptr;
+    if (value.is_null())
+      return NodePtr(new ConstantNode(Value(Value::TYPE_NULL)));
+    if (value.is_bool())
+      return NodePtr(new ConstantNode(makeBool(value.bool_value())));
+    if (value.is_number())
+      return NodePtr(new ConstantNode(makeNumber(value.number_value())));
+    if (value.is_string())
+      return NodePtr(new ConstantNode(Value(Value::TYPE_STRING),
+                                      value.string_value()));
+  } else if (type == "Identifier") {
+    if (node["name"].string_value() == "undefined")
+      return NodePtr(new ConstantNode(Value(Value::TYPE_UNDEFINED)));
+  } else if (type == "ArrayExpression") {
+    std::unique_ptr<ArrayNode> array(new ArrayNode());
+    for (const json11::Json &item : node["elements"].array_items()) {
+      NodePtr element = compile(item, specialize);
+      if (!element)
+        return nullptr;
+      array->elements.push_back(std::move(element));
+    }
+    return std::move(array);
+  } else if (type == "UnaryExpression") {
+    if (node["operator"].string_value() == "!") {
+      if (NodePtr argument = compile(node["argument"], specialize))
+        return NodePtr(new NotNode(std::move(argument)));
+    }
+  } else if (type == "ConditionalExpression") {
+    NodePtr test = compile(node["test"], specialize);
+    NodePtr consequent = compile(node["consequent"], specialize);
+    NodePtr alternate = compile(node["alternate"], specialize);
+    if (test && consequent && alternate)
+      return NodePtr(new ConditionalNode(std::move(test), std::move(consequent),
+                                         std::move(alternate)));
+  } else if (type == "CallExpression") {
+    return compileCall(node, specialize);
+  } else if (type == "MemberExpression") {
+    return compileMember(node, specialize);
+  }
+  return nullptr;
+}
+
+// function($_frame){ return ARGUMENT }
+const json11::Json &returnArgument(const json11::Json &program) {
+  static const json11::Json null;
+  const auto &body = program["body"].array_items();
+  if (body.size() != 1 ||
+      body[0]["type"].string_value() != "ExpressionStatement")
+    return null;
+  const json11::Json &func = body[0]["expression"];
+  const auto &params = func["params"].array_items();
+  if (func["type"].string_value() != "FunctionExpression" ||
+      params.size() != 1 || !isIdentifier(params[0], "$_frame"))
+    return null;
+  const auto &statements = func["body"]["body"].array_items();
+  if (statements.size() != 1 ||
+      statements[0]["type"].string_value() != "ReturnStatement")
+    return null;
+  return statements[0]["argument"];
+}
+
+bool isOp(const json11::Json &node, const char *opcode, size_t args) {
+  const auto &arguments = node["arguments"].array_items();
+  return node["type"].string_value() == "CallExpression" &&
+         isIdentifier(node["callee"], "$_op") && arguments.size() == args + 1 &&
+         arguments[0]["value"].string_value() == opcode;
+}
+
+// function($_frame){ return !$_op('!', EXPR) }
+const json11::Json &filterExpression(const json11::Json &program) {
+  static const json11::Json null;
+  const json11::Json &argument = returnArgument(program);
+  if (argument["type"].string_value() != "UnaryExpression" ||
+      argument["operator"].string_value() != "!" ||
+      !isOp(argument["argument"], "!", 1))
+    return null;
+  return argument["argument"]["arguments"][1];
+}
+// $_frame.timestamp
+bool isTimestamp(const json11::Json &node) {
+  return node["type"].string_value() == "MemberExpression" &&
+         !node["computed"].bool_value() &&
+         isIdentifier(node["object"], "$_frame") &&
+         isIdentifier(node["property"], "timestamp");
+}
+
+// Both operands of `&&` have to be truthy, so each comparison in a
+// conjunction bounds the timestamps of the matching frames.
+bool boundTime(const json11::Json &expr, FilterProgram::TimeRange *range) {
+  if (isOp(expr, "&&", 2)) {
+    bool left = boundTime(expr["arguments"][1], range);
+    bool right = boundTime(expr["arguments"][2], range);
+    return left || right;
+  }
+
+  static const struct {
+    const char *opcode;
+    const char *reversed;
+  } comparisons[] = {{"<", ">"}, {"<=", ">="}, {">", "<"}, {">=", "<="}};
+  for (const auto &comparison : comparisons) {
+    if (!isOp(expr, comparison.opcode, 2))
+      continue;
+    const json11::Json &left = expr["arguments"][1];
+    const json11::Json &right = expr["arguments"][2];
+    std::string opcode;
+    double value;
+    if (isTimestamp(left) && right["type"].string_value() == "Literal" &&
+        right["value"].is_number()) {
+      opcode = comparison.opcode;
+      value = right["value"].number_value();
+    } else if (isTimestamp(right) &&
+               left["type"].string_value() == "Literal" &&
+               left["value"].is_number()) {
+      opcode = comparison.reversed;
+      value = left["value"].number_value();
+    } else {
+      return false;
+    }
+
+    bool inclusive = (opcode.size() == 2);
+    if (opcode[0] == '<') {
+      if (value < range->end || (value == range->end && !inclusive)) {
+        range->end = value;
+        range->endInclusive = inclusive;
+      }
+    } else {
+      if (value > range->begin || (value == range->begin && !inclusive)) {
+        range->begin = value;
+        range->beginInclusive = inclusive;
+      }
+    }
+    return true;
+  }
+  return false;
+}
+} // namespace
+
+FilterProgram::TimeRange::TimeRange()
+    : begin(-std::numeric_limits<double>::infinity()),
+      end(std::numeric_limits<double>::infinity()) {}
+
+bool FilterProgram::TimeRange::overlaps(double min, double max) const {
+  if (max < begin || (max == begin && !beginInclusive))
+    return false;
+  if (min > end || (min == end && !endInclusive))
+    return false;
+  return true;
+}
+
+class FilterProgram::Private {
+public:
+  void lower();
+  void testNative(uint64_t *results, uint64_t *unsupported,
+                  const FrameView **begin, size_t size) const;
+
+public:
+  NodePtr root;
+  std::unique_ptr<FilterJit> jit;
+  std::vector<Lowering::Column> columns;
+  mutable std::vector<Value> values;
+  mutable std::vector<double> numbers;
+  mutable std::vector<const double *> pointers;
+  mutable std::vector<char> loads;
+  mutable std::vector<uint8_t> matches;
+};
+
+void FilterProgram::Private::lower() {
+  Lowering lowering;
+  if (!root->lower(&lowering))
+    return;
+  jit.reset(new FilterJit(lowering.code));
+  if (!jit->valid()) {
+    jit.reset();
+    return;
+  }
+  columns = std::move(lowering.columns);
+}
+
+void FilterProgram::Private::testNative(uint64_t *results,
+                                        uint64_t *unsupported,
+                                        const FrameView **begin,
+                                        size_t size) const {
+  // Loads the columns, then runs the native code over all frames and
+  // evaluates the frames with other values by the nodes.
+  double *columnData = column(&numbers, columns.size() * size);
+  const double **columnPointers = column(&pointers, columns.size());
+  char *frameLoads = column(&loads, size);
+  std::fill(frameLoads, frameLoads + size, LOAD_NUMBER);
+  for (size_t c = 0; c < columns.size(); ++c) {
+    double *data = columnData + c * size;
+    columnPointers[c] = data;
+    for (size_t i = 0; i < size; ++i) {
+      frameLoads[i] = std::max(frameLoads[i],
+                               Lowering::load(begin[i], columns[c], &data[i]));
+    }
+  }
+  uint8_t *frameMatches = column(&matches, size);
+  jit->run(columnPointers, size, frameMatches);
+
+  for (size_t i = 0; i < size; ++i) {
+    uint64_t bit = (1ull << (i % 64));
+    switch (frameLoads[i]) {
+    case LOAD_NUMBER:
+      if (frameMatches[i]) {
+        results[i / 64] |= bit;
+      }
+      break;
+    case LOAD_ERROR:
+      break;
+    default: {
+      Value value = root->eval(begin[i]);
+      if (value.type == Value::TYPE_UNSUPPORTED) {
+        unsupported[i / 64] |= bit;
+      } else if (value.type != Value::TYPE_ERROR && truthy(value)) {
+        results[i / 64] |= bit;
+      }
+    }
+    }
+  }
+}
+
+FilterProgram::FilterProgram(const std::string &ast, bool specialize,
+                             bool jit)
+    : d(new Private()) {
+  std::string err;
+  const json11::Json &program = json11::Json::parse(ast, err);
+  if (!err.empty())
+    return;
+  const json11::Json &argument = returnArgument(program);
+  if (!argument.is_null()) {
+    d->root = compile(argument, specialize);
+  }
+  if (d->root && jit) {
+    d->lower();
+  }
+}
+
+FilterProgram::~FilterProgram() {}
+
+bool FilterProgram::valid() const { return static_cast<bool>(d->root); }
+
+bool FilterProgram::native() const { return static_cast<bool>(d->jit); }
+
+FilterProgram::Result FilterProgram::test(const FrameView *view) const {
+  if (!d->root)
+    return RESULT_UNSUPPORTED;
+  Value value = d->root->eval(view);
+  switch (value.type) {
+  case Value::TYPE_ERROR:
+    return RESULT_FALSE;
+  case Value::TYPE_UNSUPPORTED:
+    return RESULT_UNSUPPORTED;
+  default:
+    return truthy(value) ? RESULT_TRUE : RESULT_FALSE;
+  }
+}
+
+bool FilterProgram::refines(const std::string &ast, const std::string &base) {
+  std::string err;
+  const json11::Json &program = json11::Json::parse(ast, err);
+  const json11::Json &baseProgram = json11::Json::parse(base, err);
+  if (!err.empty())
+    return false;
+  const json11::Json &baseExpr = filterExpression(baseProgram);
+  if (baseExpr.is_null())
+    return false;
+
+  // `a && b && c` is parsed as `(a && b) && c`.
+  for (const json11::Json *expr = &filterExpression(program);
+       !expr->is_null(); expr = &(*expr)["arguments"][1]) {
+    if (*expr == baseExpr)
+      return true;
+    if (!isOp(*expr, "&&", 2))
+      break;
+  }
+  return false;
+}
+
+bool FilterProgram::timeRange(const std::string &ast, TimeRange *range) {
+  std::string err;
+  const json11::Json &program = json11::Json::parse(ast, err);
+  if (!err.empty())
+    return false;
+  *range = TimeRange();
+  return boundTime(filterExpression(program), range);
+}
+
+void FilterProgram::test(uint64_t *results, uint64_t *unsupported,
+                         const FrameView **begin, size_t size) const {
+  if (!d->root) {
+    for (size_t i = 0; i < size; ++i) {
+      unsupported[i / 64] |= (1ull << (i % 64));
+    }
+    return;
+  }
+  if (d->jit) {
+    d->testNative(results, unsupported, begin, size);
+    return;
+  }
+  Value *values = column(&d->values, size);
+  d->root->evalBatch(begin, size, values);
+  for (size_t i = 0; i < size; ++i) {
+    const Value &value = values[i];
+    uint64_t bit = (1ull << (i % 64));
+    if (value.type == Value::TYPE_UNSUPPORTED) {
+      unsupported[i / 64] |= bit;
+    } else if (value.type != Value::TYPE_ERROR && truthy(value)) {
+      results[i / 64] |= bit;
+    }
+  }
+}
+} // namespace plugkit
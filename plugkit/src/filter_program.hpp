@@ -0,0 +1,76 @@
+#ifndef PLUGKIT_FILTER_PROGRAM_HPP
+#define PLUGKIT_FILTER_PROGRAM_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace plugkit {
+
+class FrameView;
+
+class FilterProgram final {
+public:
+  enum Result { RESULT_FALSE = 0, RESULT_TRUE = 1, RESULT_UNSUPPORTED = 2 };
+
+  /// Range of frame timestamps in milliseconds since the epoch.
+  struct TimeRange {
+    double begin;
+    double end;
+    bool beginInclusive = true;
+    bool endInclusive = true;
+    TimeRange();
+    bool overlaps(double min, double max) const;
+  };
+
+public:
+  /// Compiles the transformed filter AST in the ESTree JSON format.
+  ///
+  /// If the AST contains an unsupported construct, valid() returns false.
+  /// Unless `specialize` is false, common forms such as comparisons of an
+  /// attribute with a number are compiled into dedicated nodes which skip
+  /// the generic evaluation.
+  ///
+  /// If `jit` is true, filters made of such comparisons joined by `&&`, `||`
+  /// and `!` are compiled into machine code by FilterJit, where the platform
+  /// supports it.
+  FilterProgram(const std::string &ast, bool specialize = true,
+                bool jit = false);
+  ~FilterProgram();
+  bool valid() const;
+
+  /// Returns true if batches are tested by machine code.
+  bool native() const;
+
+  /// Returns RESULT_UNSUPPORTED if the frame has to be tested by the script.
+  Result test(const FrameView *view) const;
+
+  /// Tests a batch of frames at once.
+  ///
+  /// Sets the bit of each matching frame in `results` and of each frame which
+  /// has to be tested by the script in `unsupported`. Both bitmaps must have
+  /// (size + 63) / 64 words cleared to zero.
+  void test(uint64_t *results, uint64_t *unsupported, const FrameView **begin,
+            size_t size) const;
+
+  /// Returns true if the filter of `ast` is `base` or a conjunction of `base`
+  /// and other expressions, so it only matches frames matched by `base`.
+  static bool refines(const std::string &ast, const std::string &base);
+
+  /// Finds the range of timestamps out of which the filter never matches,
+  /// from comparisons of `$_frame.timestamp` with numbers joined by `&&`.
+  ///
+  /// Returns false if the filter does not bound the timestamp.
+  static bool timeRange(const std::string &ast, TimeRange *range);
+
+private:
+  FilterProgram(const FilterProgram &) = delete;
+  FilterProgram &operator=(const FilterProgram &) = delete;
+
+private:
+  class Private;
+  std::unique_ptr<Private> d;
+};
+} // namespace plugkit
+
+#endif
@@ -0,0 +1,101 @@
+#include "filter_scan.hpp"
+#include <algorithm>
+#include <iterator>
+
+namespace plugkit {
+
+void FilterScan::reset(uint32_t next) {
+  next_ = next;
+  focused_ = false;
+  claimed.clear();
+}
+
+uint32_t FilterScan::next() const { return next_; }
+
+void FilterScan::stepOver() {
+  while (!claimed.empty() && claimed.begin()->first <= next_) {
+    next_ = std::max(next_, claimed.begin()->second);
+    claimed.erase(claimed.begin());
+  }
+}
+
+size_t FilterScan::fit(uint32_t start, size_t size) const {
+  if (next_ > start) {
+    return std::min(size, static_cast<size_t>(next_ - start));
+  } else if (!claimed.empty()) {
+    return std::min(size, static_cast<size_t>(claimed.begin()->first - start));
+  }
+  return size;
+}
+
+void FilterScan::advance(size_t size) { next_ += size; }
+
+bool FilterScan::setFocus(uint32_t focus, uint32_t length) {
+  if (focused_ && this->focus == focus && focusLength == length)
+    return false;
+  focused_ = true;
+  this->focus = focus;
+  focusLength = length;
+  ahead = focus;
+  behind = focus;
+  return true;
+}
+
+bool FilterScan::focused() const { return focused_; }
+
+bool FilterScan::claimFocus(uint32_t completed, size_t batchSize,
+                            const Counter &count, uint32_t *begin,
+                            uint32_t *end, bool *waiting) {
+  // Extends [behind, ahead) over the ranges claimed since.
+  ahead = std::max(ahead, next_);
+  while (true) {
+    auto it = claimed.upper_bound(ahead);
+    if (it == claimed.begin() || std::prev(it)->second <= ahead)
+      break;
+    ahead = std::prev(it)->second;
+  }
+  while (behind > next_) {
+    auto it = claimed.upper_bound(behind - 1);
+    if (it == claimed.begin() || std::prev(it)->second < behind)
+      break;
+    behind = std::prev(it)->first;
+  }
+
+  bool aheadDone = count(focus, ahead) >= focusLength;
+  bool behindDone = behind <= next_ || count(behind, focus) >= focusLength;
+  if (!aheadDone && ahead >= completed) {
+    *waiting = true;
+    aheadDone = true;
+  }
+  if (!behindDone && behind > completed) {
+    *waiting = true;
+    behindDone = true;
+  }
+  if (aheadDone && behindDone)
+    return false;
+
+  backward = !backward;
+  if (behindDone || (!aheadDone && !backward)) {
+    *begin = ahead;
+    *end = static_cast<uint32_t>(
+        std::min<size_t>(static_cast<size_t>(ahead) + batchSize, completed));
+    auto it = claimed.upper_bound(*begin);
+    if (it != claimed.end()) {
+      *end = std::min(*end, it->first);
+    }
+    ahead = *end;
+  } else {
+    *end = behind;
+    *begin = std::max<uint32_t>(
+        *end - std::min<uint32_t>(*end, static_cast<uint32_t>(batchSize)),
+        next_);
+    auto it = claimed.lower_bound(*end);
+    if (it != claimed.begin()) {
+      *begin = std::max(*begin, std::prev(it)->second);
+    }
+    behind = *begin;
+  }
+  claimed[*begin] = *end;
+  return true;
+}
+} // namespace plugkit
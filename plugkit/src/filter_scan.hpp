@@ -0,0 +1,65 @@
+#ifndef PLUGKIT_FILTER_SCAN_HPP
+#define PLUGKIT_FILTER_SCAN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+
+namespace plugkit {
+
+/// Tracks which frame offsets of a filter have been claimed for testing.
+///
+/// The shared scan claims the offsets in order from next(). Around a
+/// viewport, claimFocus() claims ranges ahead of and behind the focus
+/// before the shared scan reaches them, and the shared scan steps over
+/// these ranges, so that every offset is claimed exactly once.
+class FilterScan final {
+public:
+  /// Returns the number of matches known in the offsets [begin, end).
+  using Counter = std::function<uint32_t(uint32_t begin, uint32_t end)>;
+
+public:
+  /// Restarts the shared scan from `next` and clears the focus.
+  void reset(uint32_t next);
+  uint32_t next() const;
+
+  /// Steps the shared scan over the claimed ranges starting at next().
+  void stepOver();
+
+  /// Returns the size of a batch of the shared scan starting at `start`,
+  /// up to `size`, which does not reach into the ranges claimed for the
+  /// focus. `start` must not be greater than next().
+  size_t fit(uint32_t start, size_t size) const;
+
+  /// Claims the offsets [next(), next() + size).
+  void advance(size_t size);
+
+  /// Moves the focus to the offset `focus`. Returns false if it is
+  /// unchanged.
+  bool setFocus(uint32_t focus, uint32_t length);
+  bool focused() const;
+
+  /// Claims the next range around the focus, alternately ahead of and
+  /// behind it, until `count` reports `length` matches on each side.
+  /// Returns false if no more range is needed; `waiting` is then set if
+  /// the matches ahead wait for frames beyond `completed`.
+  bool claimFocus(uint32_t completed, size_t batchSize, const Counter &count,
+                  uint32_t *begin, uint32_t *end, bool *waiting);
+
+private:
+  uint32_t next_ = 0;
+
+  // The frames in [behind, ahead) have been claimed around the offset
+  // `focus`, and `claimed` holds the ranges taken ahead of `next_`.
+  bool focused_ = false;
+  uint32_t focus = 0;
+  uint32_t focusLength = 0;
+  uint32_t ahead = 0;
+  uint32_t behind = 0;
+  bool backward = false;
+  std::map<uint32_t, uint32_t> claimed;
+};
+} // namespace plugkit
+
+#endif
@@ -1,54 +1,80 @@
 #include "filter_thread.hpp"
 #include "filter.hpp"
-#include "frame.hpp"
 #include "frame_store.hpp"
-#include "frame_view.hpp"
 #include "null_logger.hpp"
-#include <array>
+#include <unordered_map>
 
 namespace plugkit {
 
 class FilterThread::Private {
+public:
+  const Filter *filter(const FilterSourcePtr &source);
+
 public:
   FrameStorePtr store;
+  Fetch fetch;
   Callback callback;
-  std::string body;
-  std::unique_ptr<Filter> filter;
-  size_t offset = 0;
+  Batch batch;
+  std::vector<uint64_t> results;
+  std::unordered_map<uint32_t, std::pair<std::weak_ptr<const FilterSource>,
+                                         std::unique_ptr<Filter>>>
+      filters;
 };
 
-FilterThread::FilterThread(const std::string &body, const FrameStorePtr &store,
+const Filter *FilterThread::Private::filter(const FilterSourcePtr &source) {
+  auto &entry = filters[source->id];
+  if (!entry.second) {
+    entry.first = source;
+    entry.second.reset(
+        new Filter(source->body, source->program, source->specialize,
+                   source->jit));
+  }
+  return entry.second.get();
+}
+
+FilterThread::FilterThread(const FrameStorePtr &store, const Fetch &fetch,
                            const Callback &callback)
     : d(new Private()) {
   d->store = store;
+  d->fetch = fetch;
   d->callback = callback;
-  d->body = body;
 }
 
 FilterThread::~FilterThread() {}
 
-void FilterThread::enter() { d->filter.reset(new Filter(d->body)); }
+void FilterThread::enter() {}
 
-void FilterThread::exit() { d->filter.reset(); }
+void FilterThread::exit() { d->filters.clear(); }
 
 bool FilterThread::loop() {
-  std::thread::id id = std::this_thread::get_id();
-  std::array<const FrameView *, 128> views;
-  size_t size = d->store->dequeue(d->offset, views.size(), &views[0], id);
-  if (size == 0)
+  Batch &batch = d->batch;
+  batch.views.clear();
+  batch.filters.clear();
+  if (!d->fetch(std::this_thread::get_id(), &batch))
     return false;
 
-  uint32_t begin = views[0]->frame()->index();
-  std::vector<char> results;
-  results.resize(size);
-  d->filter->test(&results[0], &views[0], size);
+  // Filters are compiled on first use and dropped with their source.
+  for (auto it = d->filters.begin(); it != d->filters.end();) {
+    if (it->second.first.expired()) {
+      it = d->filters.erase(it);
+    } else {
+      ++it;
+    }
+  }
 
-  d->callback(begin, results);
-  d->offset += size;
+  size_t size = batch.views.size();
+  if (size == 0)
+    return true;
+  for (const FilterSourcePtr &source : batch.filters) {
+    std::vector<uint64_t> &results = d->results;
+    results.assign((size + 63) / 64, 0);
+    d->filter(source)->test(results.data(), batch.views.data(), size);
+    d->callback(source->id, batch.views.data(), size, results);
+  }
   return true;
 }
 
-void FilterThread::close() {
+void FilterThread::interrupt() {
   std::thread::id id = thread.get_id();
   if (id != std::thread::id()) {
     d->store->close(id);
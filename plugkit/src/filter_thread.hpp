@@ -2,26 +2,51 @@
 #define PLUGKIT_FILTER_THREAD_H
 
 #include "worker_thread.hpp"
+#include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace plugkit {
 
 class FrameStore;
 using FrameStorePtr = std::shared_ptr<FrameStore>;
 
+class FrameView;
+
+struct FilterSource {
+  uint32_t id;
+  std::string body;
+  std::string program;
+  bool specialize;
+  bool jit;
+};
+using FilterSourcePtr = std::shared_ptr<const FilterSource>;
+
 class FilterThread final : public WorkerThread {
 public:
+  /// Frames to be tested with each of the filters.
+  struct Batch {
+    std::vector<const FrameView *> views;
+    std::vector<FilterSourcePtr> filters;
+  };
+
+  /// Fills the next batch. Returns false if the thread should exit.
+  using Fetch = std::function<bool(std::thread::id id, Batch *batch)>;
   using Callback =
-      std::function<void(uint32_t begin, const std::vector<char> &)>;
+      std::function<void(uint32_t filter, const FrameView **views, size_t size,
+                         const std::vector<uint64_t> &results)>;
 
 public:
-  FilterThread(const std::string &body, const FrameStorePtr &store,
+  FilterThread(const FrameStorePtr &store, const Fetch &fetch,
                const Callback &callback);
   ~FilterThread() override;
   void enter() override;
   bool loop() override;
   void exit() override;
-  void close();
+
+  /// Interrupts the wait for new frames in FrameStore::dequeue().
+  void interrupt();
 
 private:
   class Private;
@@ -1,121 +1,574 @@
 #include "filter_thread_pool.hpp"
+#include "bitmap.hpp"
+#include "filter_program.hpp"
+#include "filter_scan.hpp"
 #include "filter_thread.hpp"
+#include "frame.hpp"
+#include "frame_store.hpp"
+#include "frame_view.hpp"
 #include "variant.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <list>
 #include <map>
+#include <mutex>
 #include <uv.h>
 
 namespace plugkit {
 
+namespace {
+const size_t batchSize = 128;
+
+struct FilterState {
+  FilterSourcePtr source;
+  FilterProgram::TimeRange range;
+  bool bounded = false;
+
+  // Results, guarded by the rwlock.
+  std::map<uint32_t, bool> sequence;
+  Bitmap frames;
+  Bitmap candidates;
+  std::map<uint32_t, uint32_t> skipped;
+  uint32_t refinedSeq = 0;
+  uint32_t maxSeq = 0;
+
+  // Claims, guarded by the mutex.
+  FilterScan scan;
+  std::vector<uint32_t> pending;
+  size_t pendingOffset = 0;
+  bool active = false;
+  uint32_t limit = 0;
+};
+
+using FilterStatePtr = std::shared_ptr<FilterState>;
+} // namespace
+
 class FilterThreadPool::Private {
 public:
-  Private(const std::string &body, const Variant &options,
-          const FrameStorePtr &store, const Callback &callback);
+  Private(const Variant &options, const FrameStorePtr &store,
+          const Callback &callback);
   ~Private();
+  bool fetch(std::thread::id id, FilterThread::Batch *batch);
+  void receive(uint32_t filter, const FrameView **views, size_t size,
+               const std::vector<uint64_t> &results);
+  bool advance(FilterState *state);
+  bool focus(FilterState *state, size_t completed, FilterThread::Batch *batch,
+             bool *updated, bool *waiting);
+  uint32_t count(const FilterState *state, uint32_t begin,
+                 uint32_t end) const;
+  bool skip(FilterState *state, uint32_t offset, uint32_t size,
+            bool *updated);
+  FilterStatePtr find(const std::string &body) const;
+  void activate(const FilterStatePtr &state);
+  void deactivate(const FilterStatePtr &state);
+  void start();
 
 public:
   std::vector<std::unique_ptr<FilterThread>> threads;
-  std::map<uint32_t, bool> sequence;
-  std::vector<uint32_t> frames;
-  uint32_t maxSeq = 0;
-  LoggerPtr logger = std::make_shared<StreamLogger>();
+  std::unordered_map<uint32_t, FilterStatePtr> states;
+  std::unordered_map<std::string, uint32_t> names;
+  std::list<uint32_t> cache;
+  uint32_t lastId = 0;
+  bool closed = false;
+  std::mutex mutex;
+  std::condition_variable cond;
   uv_rwlock_t rwlock;
-  const std::string body;
+  LoggerPtr logger = std::make_shared<StreamLogger>();
   const Variant options;
   const FrameStorePtr store;
   const Callback callback;
 };
 
-FilterThreadPool::Private::Private(const std::string &body,
-                                   const Variant &options,
+FilterThreadPool::Private::Private(const Variant &options,
                                    const FrameStorePtr &store,
                                    const Callback &callback)
-    : body(body), options(options), store(store), callback(callback) {
+    : options(options), store(store), callback(callback) {
   uv_rwlock_init(&rwlock);
 }
 
 FilterThreadPool::Private::~Private() { uv_rwlock_destroy(&rwlock); }
 
-FilterThreadPool::FilterThreadPool(const std::string &body,
-                                   const Variant &options,
-                                   const FrameStorePtr &store,
-                                   const Callback &callback)
-    : d(new Private(body, options, store, callback)) {}
+bool FilterThreadPool::Private::fetch(std::thread::id id,
+                                      FilterThread::Batch *batch) {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (!closed) {
+    std::vector<FilterState *> active;
+    for (const auto &pair : states) {
+      if (pair.second->active) {
+        active.push_back(pair.second.get());
+      }
+    }
 
-FilterThreadPool::~FilterThreadPool() {
-  for (const auto &thread : d->threads) {
-    thread->close();
+    // The candidates of a refined filter are scattered, so they are tested
+    // apart from the shared scan.
+    for (FilterState *state : active) {
+      size_t offset = state->pendingOffset;
+      if (offset < state->pending.size()) {
+        size_t size = std::min(batchSize, state->pending.size() - offset);
+        state->pendingOffset += size;
+        batch->views.resize(size);
+        batch->views.resize(store->get(&state->pending[offset], size,
+                                       batch->views.data()));
+        batch->filters.push_back(state->source);
+        return true;
+      }
+    }
+
+    // The frames around the viewport are tested before the shared scan.
+    size_t completed = store->completedSize();
+    bool updated = false;
+    bool waiting = false;
+    bool focused = false;
+    for (FilterState *state : active) {
+      if (state->scan.focused() &&
+          focus(state, completed, batch, &updated, &waiting)) {
+        focused = true;
+        break;
+      }
+    }
+    if (updated) {
+      callback();
+    }
+    if (focused) {
+      if (batch->filters.empty())
+        continue;
+      return true;
+    }
+
+    // Steps over the ranges claimed for the viewport, and leaves out the
+    // filters which have reached their limit.
+    std::vector<FilterState *> scanning;
+    uv_rwlock_rdlock(&rwlock);
+    for (FilterState *state : active) {
+      state->scan.stepOver();
+      if (state->limit == 0 || state->frames.size() < state->limit) {
+        scanning.push_back(state);
+      }
+    }
+    uv_rwlock_rdunlock(&rwlock);
+
+    if (scanning.empty() && !waiting) {
+      cond.wait(lock);
+      continue;
+    }
+
+    uint32_t start = completed;
+    for (FilterState *state : scanning) {
+      start = std::min(start, state->scan.next());
+    }
+    if (completed <= start) {
+      lock.unlock();
+      const FrameView *view;
+      store->dequeue(start, 1, &view, id);
+      lock.lock();
+      continue;
+    }
+
+    // A filter behind the others is tested alone until it catches up,
+    // then the filters share each batch.
+    size_t size = std::min(batchSize, completed - start);
+    for (FilterState *state : scanning) {
+      size = state->scan.fit(start, size);
+    }
+    for (FilterState *state : scanning) {
+      if (state->scan.next() == start) {
+        state->scan.advance(size);
+        if (!skip(state, start, size, &updated)) {
+          batch->filters.push_back(state->source);
+        }
+      }
+    }
+    if (updated) {
+      callback();
+    }
+    if (batch->filters.empty())
+      continue;
+    batch->views = store->get(start, size);
+    return true;
   }
-  for (const auto &thread : d->threads) {
-    thread->join();
+  return false;
+}
+
+void FilterThreadPool::Private::receive(uint32_t filter,
+                                        const FrameView **views, size_t size,
+                                        const std::vector<uint64_t> &results) {
+  uv_rwlock_wrlock(&rwlock);
+  bool updated = false;
+  auto it = states.find(filter);
+  if (it != states.end()) {
+    FilterState *state = it->second.get();
+    for (size_t i = 0; i < size; ++i) {
+      bool match = results[i / 64] & (1ull << (i % 64));
+      state->sequence.insert(std::make_pair(views[i]->frame()->index(), match));
+      updated = updated || match;
+    }
+
+    // Matches ahead of the contiguous results are reported as well, since
+    // they may be near the viewport.
+    updated = advance(state) || updated;
+  }
+  uv_rwlock_wrunlock(&rwlock);
+  if (updated) {
+    callback();
   }
 }
 
-void FilterThreadPool::start() {
-  auto threadCallback = [this](uint32_t begin,
-                               const std::vector<char> &results) {
-    uv_rwlock_wrlock(&d->rwlock);
-    for (const auto &match : results) {
-      d->sequence.insert(std::make_pair(begin, static_cast<bool>(match)));
-      begin++;
-    }
-    uint32_t maxSeq = d->maxSeq;
-    auto end = d->sequence.begin();
-    for (auto it = d->sequence.find(maxSeq + 1); it != d->sequence.end();
-         end = it, it = d->sequence.find(++maxSeq + 1)) {
+bool FilterThreadPool::Private::advance(FilterState *state) {
+  uint32_t seq = state->maxSeq;
+  while (true) {
+    auto it = state->sequence.find(seq + 1);
+    if (it != state->sequence.end()) {
       if (it->second) {
-        d->frames.push_back(it->first);
+        state->frames.add(it->first);
       }
+      state->sequence.erase(it);
+      ++seq;
+    } else if (!state->skipped.empty() &&
+               state->skipped.begin()->first <= seq + 1) {
+      // Frames out of the time range of the filter do not match.
+      auto range = state->skipped.begin();
+      state->sequence.erase(state->sequence.lower_bound(range->first),
+                            state->sequence.upper_bound(range->second));
+      seq = std::max(seq, range->second);
+      state->skipped.erase(range);
+    } else if (seq < state->refinedSeq) {
+      // Frames up to refinedSeq which are not candidates did not match the
+      // base filter, so they do not match either.
+      uint32_t next;
+      if (!state->candidates.lowerBound(seq + 1, &next)) {
+        seq = state->refinedSeq;
+      } else if (next == seq + 1) {
+        break;
+      } else {
+        seq = next - 1;
+      }
+    } else {
+      break;
     }
-    if (d->maxSeq < maxSeq) {
-      d->maxSeq = maxSeq;
-      d->sequence.erase(d->sequence.begin(), end);
-      d->callback();
-    }
-    uv_rwlock_wrunlock(&d->rwlock);
-  };
+  }
+  if (seq == state->maxSeq)
+    return false;
+  state->maxSeq = seq;
+  return true;
+}
+
+bool FilterThreadPool::Private::skip(FilterState *state, uint32_t offset,
+                                     uint32_t size, bool *updated) {
+  if (!state->bounded)
+    return false;
+  Timestamp min;
+  Timestamp max;
+  if (!store->timeRange(offset, size, &min, &max))
+    return false;
+
+  // Compares the timestamps in milliseconds as the script does with Date.
+  using std::chrono::duration_cast;
+  using std::chrono::milliseconds;
+  double minMs = duration_cast<milliseconds>(min.time_since_epoch()).count();
+  double maxMs = duration_cast<milliseconds>(max.time_since_epoch()).count();
+  if (state->range.overlaps(minMs, maxMs))
+    return false;
+
+  uv_rwlock_wrlock(&rwlock);
+  state->skipped[offset + 1] = offset + size;
+  if (advance(state)) {
+    *updated = true;
+  }
+  uv_rwlock_wrunlock(&rwlock);
+  return true;
+}
+
+bool FilterThreadPool::Private::focus(FilterState *state, size_t completed,
+                                      FilterThread::Batch *batch,
+                                      bool *updated, bool *waiting) {
+  uint32_t begin;
+  uint32_t end;
+  uv_rwlock_rdlock(&rwlock);
+  bool claimed = state->scan.claimFocus(
+      completed, batchSize,
+      [this, state](uint32_t begin, uint32_t end) {
+        return count(state, begin, end);
+      },
+      &begin, &end, waiting);
+  uv_rwlock_rdunlock(&rwlock);
+  if (!claimed)
+    return false;
+
+  if (skip(state, begin, end - begin, updated))
+    return true;
+  batch->views = store->get(begin, end - begin);
+  batch->filters.push_back(state->source);
+  return true;
+}
 
-  int concurrency = d->options["_"]["concurrency"].uint64Value(0);
+uint32_t FilterThreadPool::Private::count(const FilterState *state,
+                                          uint32_t begin, uint32_t end) const {
+  // Offsets are 0-based while the results hold frame indices.
+  uint32_t count = state->frames.rank(end + 1) - state->frames.rank(begin + 1);
+  auto last = state->sequence.lower_bound(end + 1);
+  for (auto it = state->sequence.lower_bound(begin + 1); it != last; ++it) {
+    count += it->second;
+  }
+  return count;
+}
+
+FilterStatePtr
+FilterThreadPool::Private::find(const std::string &body) const {
+  for (const auto &pair : states) {
+    if (pair.second->source->body == body)
+      return pair.second;
+  }
+  return nullptr;
+}
+
+void FilterThreadPool::Private::activate(const FilterStatePtr &state) {
+  cache.remove(state->source->id);
+  if (state->active)
+    return;
+
+  // Resumes from the last contiguous result. Candidates of a refined filter
+  // are tested first, then the frames after the results of the base filter.
+  state->active = true;
+  state->scan.reset(std::max(state->maxSeq, state->refinedSeq));
+  state->pending.clear();
+  state->pendingOffset = 0;
+  if (state->maxSeq < state->refinedSeq) {
+    const Bitmap &candidates = state->candidates;
+    state->pending = candidates.values(candidates.rank(state->maxSeq + 1),
+                                       candidates.size());
+  }
+}
+
+void FilterThreadPool::Private::deactivate(const FilterStatePtr &state) {
+  for (const auto &pair : names) {
+    if (pair.second == state->source->id)
+      return;
+  }
+
+  // The results are kept, so that switching back to the filter only tests
+  // the frames added since.
+  state->active = false;
+  cache.push_back(state->source->id);
+  size_t limit = options["_"]["filterCacheSize"].uint64Value(8);
+  while (cache.size() > limit) {
+    states.erase(cache.front());
+    cache.pop_front();
+  }
+}
+
+void FilterThreadPool::Private::start() {
+  if (!threads.empty())
+    return;
+
+  int concurrency = options["_"]["concurrency"].uint64Value(0);
   if (concurrency == 0)
     concurrency = std::thread::hardware_concurrency();
   if (concurrency == 0)
     concurrency = 1;
 
   for (int i = 0; i < concurrency; ++i) {
-    auto thread = new FilterThread(d->body, d->store, threadCallback);
-    thread->setLogger(d->logger);
-    d->threads.emplace_back(thread);
+    auto thread = new FilterThread(
+        store,
+        [this](std::thread::id id, FilterThread::Batch *batch) {
+          return fetch(id, batch);
+        },
+        [this](uint32_t filter, const FrameView **views, size_t size,
+               const std::vector<uint64_t> &results) {
+          receive(filter, views, size, results);
+        });
+    thread->setLogger(logger);
+    threads.emplace_back(thread);
   }
-  for (const auto &thread : d->threads) {
+  for (const auto &thread : threads) {
     thread->start();
   }
 }
 
+FilterThreadPool::FilterThreadPool(const Variant &options,
+                                   const FrameStorePtr &store,
+                                   const Callback &callback)
+    : d(new Private(options, store, callback)) {}
+
+FilterThreadPool::~FilterThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(d->mutex);
+    d->closed = true;
+  }
+  d->cond.notify_all();
+  for (const auto &thread : d->threads) {
+    thread->interrupt();
+  }
+  for (const auto &thread : d->threads) {
+    thread->join();
+  }
+}
+
 void FilterThreadPool::setLogger(const LoggerPtr &logger) {
   d->logger = logger;
 }
 
-std::vector<uint32_t> FilterThreadPool::get(uint32_t offset,
+void FilterThreadPool::setFilter(const std::string &name,
+                                 const std::string &body,
+                                 const std::string &program) {
+  {
+    std::lock_guard<std::mutex> lock(d->mutex);
+    uv_rwlock_wrlock(&d->rwlock);
+
+    FilterStatePtr prev;
+    auto it = d->names.find(name);
+    if (it != d->names.end()) {
+      prev = d->states[it->second];
+      d->names.erase(it);
+    }
+
+    FilterStatePtr state;
+    if (!body.empty()) {
+      state = d->find(body);
+      if (!state) {
+        state = std::make_shared<FilterState>();
+        state->source = std::make_shared<FilterSource>(FilterSource{
+            ++d->lastId, body, program,
+            d->options["_"]["filterSpecialization"].boolValue(true),
+            d->options["_"]["filterJit"].boolValue(false)});
+        state->bounded = FilterProgram::timeRange(program, &state->range);
+        if (prev && FilterProgram::refines(program, prev->source->program)) {
+          state->candidates = prev->frames;
+          state->refinedSeq = prev->maxSeq;
+        }
+        d->states[state->source->id] = state;
+      }
+      d->names[name] = state->source->id;
+      d->activate(state);
+    }
+    if (prev && prev != state) {
+      d->deactivate(prev);
+    }
+
+    uv_rwlock_wrunlock(&d->rwlock);
+    d->start();
+  }
+
+  // Wakes the threads waiting for new frames, since the new filter may have
+  // frames to catch up on.
+  d->cond.notify_all();
+  for (const auto &thread : d->threads) {
+    thread->interrupt();
+  }
+}
+
+std::vector<uint32_t> FilterThreadPool::get(const std::string &name,
+                                            uint32_t offset,
                                             uint32_t length) const {
   std::vector<uint32_t> list;
   uv_rwlock_rdlock(&d->rwlock);
-  for (size_t i = offset; i < offset + length && i < d->frames.size(); ++i) {
-    list.push_back(d->frames[i]);
+  auto it = d->names.find(name);
+  if (it != d->names.end()) {
+    list = d->states.at(it->second)->frames.values(offset, length);
   }
   uv_rwlock_rdunlock(&d->rwlock);
   return list;
 }
 
-uint32_t FilterThreadPool::size() const {
+void FilterThreadPool::setLimit(const std::string &name, uint32_t limit) {
+  {
+    std::lock_guard<std::mutex> lock(d->mutex);
+    auto it = d->names.find(name);
+    if (it == d->names.end())
+      return;
+    d->states.at(it->second)->limit = limit;
+  }
+  d->cond.notify_all();
+}
+
+std::vector<uint32_t> FilterThreadPool::nearest(const std::string &name,
+                                                uint32_t index,
+                                                uint32_t length) {
+  std::vector<uint32_t> list;
+  bool changed = false;
+  {
+    std::lock_guard<std::mutex> lock(d->mutex);
+    auto it = d->names.find(name);
+    if (it == d->names.end())
+      return list;
+    FilterState *state = d->states.at(it->second).get();
+    changed = state->scan.setFocus((index > 0) ? index - 1 : 0, length);
+
+    uv_rwlock_rdlock(&d->rwlock);
+    const Bitmap &frames = state->frames;
+    size_t rank = frames.rank(index);
+    size_t offset = rank - std::min<size_t>(rank, length);
+    list = frames.values(offset, rank - offset + length);
+    const auto &sequence = state->sequence;
+    auto lower = sequence.lower_bound(index);
+    size_t found = 0;
+    for (auto seq = lower; seq != sequence.end() && found < length; ++seq) {
+      if (seq->second) {
+        list.push_back(seq->first);
+        ++found;
+      }
+    }
+    found = 0;
+    for (auto seq = lower; seq != sequence.begin() && found < length;) {
+      if ((--seq)->second) {
+        list.push_back(seq->first);
+        ++found;
+      }
+    }
+    uv_rwlock_rdunlock(&d->rwlock);
+  }
+
+  auto distance = [index](uint32_t value) {
+    return (value > index) ? value - index : index - value;
+  };
+  std::sort(list.begin(), list.end(), [&](uint32_t a, uint32_t b) {
+    return distance(a) < distance(b) || (distance(a) == distance(b) && a < b);
+  });
+  list.resize(std::min<size_t>(list.size(), length));
+  std::sort(list.begin(), list.end());
+
+  if (changed) {
+    d->cond.notify_all();
+    for (const auto &thread : d->threads) {
+      thread->interrupt();
+    }
+  }
+  return list;
+}
+
+std::unordered_map<std::string, uint32_t> FilterThreadPool::sizes() const {
+  std::unordered_map<std::string, uint32_t> sizes;
   uv_rwlock_rdlock(&d->rwlock);
-  uint32_t size = d->frames.size();
+  for (const auto &pair : d->names) {
+    sizes[pair.first] = d->states.at(pair.second)->frames.size();
+  }
   uv_rwlock_rdunlock(&d->rwlock);
-  return size;
+  return sizes;
 }
 
-uint32_t FilterThreadPool::maxSeq() const {
+std::vector<uint32_t>
+FilterThreadPool::get(const std::vector<std::string> &names, Operator op,
+                      uint32_t offset, uint32_t length) const {
+  Bitmap frames;
   uv_rwlock_rdlock(&d->rwlock);
-  uint32_t maxSeq = d->maxSeq;
+  for (size_t i = 0; i < names.size(); ++i) {
+    auto it = d->names.find(names[i]);
+    if (it == d->names.end()) {
+      if (op == OPERATOR_AND) {
+        frames.clear();
+        break;
+      }
+      continue;
+    }
+    const Bitmap &bitmap = d->states.at(it->second)->frames;
+    if (i == 0) {
+      frames = bitmap;
+    } else if (op == OPERATOR_AND) {
+      frames = frames & bitmap;
+    } else {
+      frames = frames | bitmap;
+    }
+  }
   uv_rwlock_rdunlock(&d->rwlock);
-  return maxSeq;
+  return frames.values(offset, length);
 }
 } // namespace plugkit
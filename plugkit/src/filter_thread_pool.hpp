@@ -3,6 +3,7 @@
 
 #include <functional>
 #include <memory>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -19,17 +20,46 @@ struct Variant;
 class FilterThreadPool final {
 public:
   using Callback = std::function<void()>;
+  enum Operator { OPERATOR_AND, OPERATOR_OR };
 
 public:
-  FilterThreadPool(const std::string &body, const Variant &options,
-                   const FrameStorePtr &store, const Callback &callback);
+  FilterThreadPool(const Variant &options, const FrameStorePtr &store,
+                   const Callback &callback);
   ~FilterThreadPool();
-  void start();
   void setLogger(const LoggerPtr &logger);
 
-  std::vector<uint32_t> get(uint32_t offset, uint32_t length) const;
-  uint32_t size() const;
-  uint32_t maxSeq() const;
+  /// Sets the filter with the given name. An empty body removes it.
+  ///
+  /// All filters are tested in a single pass over each batch of frames.
+  /// A new filter catches up on its own and joins the pass. The results of
+  /// replaced filters are cached, so switching back to one of them resumes
+  /// from its last result.
+  void setFilter(const std::string &name, const std::string &body,
+                 const std::string &program);
+
+  std::vector<uint32_t> get(const std::string &name, uint32_t offset,
+                            uint32_t length) const;
+
+  /// Stops the scan of the filter once it has matched `limit` frames, so
+  /// that the first matches are available without testing the rest of the
+  /// capture. Raising the limit resumes the scan; 0 removes it.
+  void setLimit(const std::string &name, uint32_t limit);
+
+  /// Returns up to `length` matches nearest to the frame `index` known so
+  /// far, in ascending order.
+  ///
+  /// The frames around `index` are tested ahead of the rest of the capture
+  /// until `length` matches are found on each side of it, and the callback
+  /// is called as their results arrive.
+  std::vector<uint32_t> nearest(const std::string &name, uint32_t index,
+                                uint32_t length);
+
+  /// Combines the results of the filters and returns a range of the frames
+  /// matched by all (OPERATOR_AND) or any (OPERATOR_OR) of them.
+  std::vector<uint32_t> get(const std::vector<std::string> &names,
+                            Operator op, uint32_t offset,
+                            uint32_t length) const;
+  std::unordered_map<std::string, uint32_t> sizes() const;
 
 private:
   FilterThreadPool(const FilterThreadPool &) = delete;
@@ -0,0 +1,142 @@
+#ifndef PLUGKIT_FLAT_MAP_HPP
+#define PLUGKIT_FLAT_MAP_HPP
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace plugkit {
+
+// A map which keeps its entries sorted in a single vector.
+// Lookups take a pointer and a length so that callers need not build a
+// std::string for the key.
+template <class T> class FlatMap final {
+public:
+  using value_type = std::pair<std::string, T>;
+  using iterator = typename std::vector<value_type>::iterator;
+  using const_iterator = typename std::vector<value_type>::const_iterator;
+
+public:
+  iterator begin();
+  iterator end();
+  const_iterator begin() const;
+  const_iterator end() const;
+  size_t size() const;
+  bool empty() const;
+  void reserve(size_t size);
+
+  iterator find(const char *key, size_t length);
+  const_iterator find(const char *key, size_t length) const;
+  iterator find(const std::string &key);
+  const_iterator find(const std::string &key) const;
+  std::pair<iterator, bool> emplace(std::string key, T value);
+  T &get(const char *key, size_t length);
+  T &operator[](const std::string &key);
+
+private:
+  size_t lowerBound(const char *key, size_t length) const;
+  bool matches(size_t index, const char *key, size_t length) const;
+
+private:
+  std::vector<value_type> entries;
+};
+
+template <class T> typename FlatMap<T>::iterator FlatMap<T>::begin() {
+  return entries.begin();
+}
+
+template <class T> typename FlatMap<T>::iterator FlatMap<T>::end() {
+  return entries.end();
+}
+
+template <class T>
+typename FlatMap<T>::const_iterator FlatMap<T>::begin() const {
+  return entries.begin();
+}
+
+template <class T> typename FlatMap<T>::const_iterator FlatMap<T>::end() const {
+  return entries.end();
+}
+
+template <class T> size_t FlatMap<T>::size() const { return entries.size(); }
+
+template <class T> bool FlatMap<T>::empty() const { return entries.empty(); }
+
+template <class T> void FlatMap<T>::reserve(size_t size) {
+  entries.reserve(size);
+}
+
+template <class T>
+size_t FlatMap<T>::lowerBound(const char *key, size_t length) const {
+  size_t begin = 0;
+  size_t end = entries.size();
+  while (begin < end) {
+    size_t mid = begin + (end - begin) / 2;
+    if (entries[mid].first.compare(0, std::string::npos, key, length) < 0) {
+      begin = mid + 1;
+    } else {
+      end = mid;
+    }
+  }
+  return begin;
+}
+
+template <class T>
+bool FlatMap<T>::matches(size_t index, const char *key, size_t length) const {
+  return index < entries.size() && entries[index].first.size() == length &&
+         std::memcmp(entries[index].first.data(), key, length) == 0;
+}
+
+template <class T>
+typename FlatMap<T>::iterator FlatMap<T>::find(const char *key,
+                                               size_t length) {
+  size_t index = lowerBound(key, length);
+  return matches(index, key, length) ? entries.begin() + index : end();
+}
+
+template <class T>
+typename FlatMap<T>::const_iterator FlatMap<T>::find(const char *key,
+                                                     size_t length) const {
+  size_t index = lowerBound(key, length);
+  return matches(index, key, length) ? entries.begin() + index : end();
+}
+
+template <class T>
+typename FlatMap<T>::iterator FlatMap<T>::find(const std::string &key) {
+  return find(key.data(), key.size());
+}
+
+template <class T>
+typename FlatMap<T>::const_iterator
+FlatMap<T>::find(const std::string &key) const {
+  return find(key.data(), key.size());
+}
+
+template <class T>
+std::pair<typename FlatMap<T>::iterator, bool>
+FlatMap<T>::emplace(std::string key, T value) {
+  size_t index = lowerBound(key.data(), key.size());
+  if (matches(index, key.data(), key.size())) {
+    return std::make_pair(entries.begin() + index, false);
+  }
+  auto it = entries.emplace(entries.begin() + index, std::move(key),
+                            std::move(value));
+  return std::make_pair(it, true);
+}
+
+template <class T> T &FlatMap<T>::get(const char *key, size_t length) {
+  size_t index = lowerBound(key, length);
+  if (!matches(index, key, length)) {
+    entries.emplace(entries.begin() + index, std::string(key, length), T());
+  }
+  return entries[index].second;
+}
+
+template <class T> T &FlatMap<T>::operator[](const std::string &key) {
+  return get(key.data(), key.size());
+}
+} // namespace plugkit
+
+#endif
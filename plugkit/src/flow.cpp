@@ -0,0 +1,100 @@
+#include "flow.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace plugkit {
+
+namespace {
+
+const size_t maxAddrLength = 16;
+const size_t maxInputLength = maxAddrLength * 2 + sizeof(uint16_t) * 2;
+
+// Default RSS key from the Microsoft RSS specification.
+const uint8_t toeplitzKey[maxInputLength + sizeof(uint32_t)] = {
+    0x6d, 0x5a, 0x56, 0xda, 0x25, 0x5b, 0x0e, 0xc2, 0x41, 0x67,
+    0x25, 0x3d, 0x43, 0xa3, 0x8f, 0xb0, 0xd0, 0xca, 0x2b, 0xcb,
+    0xae, 0x7b, 0x30, 0xb4, 0x77, 0xcb, 0x2d, 0xa3, 0x80, 0x30,
+    0xf2, 0x0c, 0x6a, 0x42, 0xb7, 0x3b, 0xbe, 0xac, 0x01, 0xfa};
+
+using ToeplitzTable = std::array<std::array<uint32_t, 256>, maxInputLength>;
+
+ToeplitzTable createTable() {
+  ToeplitzTable table;
+  for (size_t i = 0; i < maxInputLength; ++i) {
+    uint64_t window = 0;
+    for (size_t j = 0; j < 5; ++j) {
+      window = (window << 8) | toeplitzKey[i + j];
+    }
+    for (uint32_t byte = 0; byte < 256; ++byte) {
+      uint32_t value = 0;
+      for (int bit = 0; bit < 8; ++bit) {
+        if (byte & (0x80 >> bit)) {
+          value ^= static_cast<uint32_t>(window >> (8 - bit));
+        }
+      }
+      table[i][byte] = value;
+    }
+  }
+  return table;
+}
+
+uint32_t toeplitz(const uint8_t *data, size_t length) {
+  static const ToeplitzTable table = createTable();
+  uint32_t hash = 0;
+  for (size_t i = 0; i < length; ++i) {
+    hash ^= table[i][data[i]];
+  }
+  return hash;
+}
+} // namespace
+
+uint32_t Flow_hash(Slice src, Slice dst, uint16_t srcPort, uint16_t dstPort,
+                   uint8_t protocol) {
+  size_t srcLen = std::min(Slice_length(src), maxAddrLength);
+  size_t dstLen = std::min(Slice_length(dst), maxAddrLength);
+
+  // Order the endpoints so that both directions produce the same input.
+  size_t minLen = std::min(srcLen, dstLen);
+  int order = minLen ? std::memcmp(src.begin, dst.begin, minLen) : 0;
+  if (order > 0 || (order == 0 && srcLen > dstLen) ||
+      (order == 0 && srcLen == dstLen && srcPort > dstPort)) {
+    std::swap(src, dst);
+    std::swap(srcLen, dstLen);
+    std::swap(srcPort, dstPort);
+  }
+
+  uint8_t input[maxInputLength];
+  size_t length = 0;
+  if (srcLen > 0) {
+    std::memcpy(input + length, src.begin, srcLen);
+    length += srcLen;
+  }
+  if (dstLen > 0) {
+    std::memcpy(input + length, dst.begin, dstLen);
+    length += dstLen;
+  }
+  input[length++] = srcPort >> 8;
+  input[length++] = srcPort & 0xff;
+  input[length++] = dstPort >> 8;
+  input[length++] = dstPort & 0xff;
+
+  return toeplitz(input, length) ^ (protocol * 0x9e3779b1u);
+}
+
+void FlowKey_set(FlowKey *key, Slice src, Slice dst, uint16_t srcPort,
+                 uint16_t dstPort, uint8_t protocol) {
+  std::memset(key, 0, sizeof(FlowKey));
+  key->srcLength = std::min(Slice_length(src), maxAddrLength);
+  key->dstLength = std::min(Slice_length(dst), maxAddrLength);
+  if (key->srcLength > 0) {
+    std::memcpy(key->src, src.begin, key->srcLength);
+  }
+  if (key->dstLength > 0) {
+    std::memcpy(key->dst, dst.begin, key->dstLength);
+  }
+  key->srcPort = srcPort;
+  key->dstPort = dstPort;
+  key->protocol = protocol;
+}
+} // namespace plugkit
@@ -0,0 +1,240 @@
+#include "flow_table.h"
+#include <cstring>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+namespace plugkit {
+
+namespace {
+struct Entry {
+  std::string key;
+  void *value = nullptr;
+  size_t size = 0;
+  uint64_t time = 0;
+  bool closed = false;
+};
+
+struct Key {
+  const char *data;
+  size_t length;
+};
+
+struct KeyHash {
+  size_t operator()(const Key &key) const {
+    // Mixes 8 bytes at a time and finishes with the MurmurHash3 finalizer,
+    // so that keys differing in a single bit spread over all buckets.
+    const uint64_t multiplier = 0x9e3779b97f4a7c15ull;
+    uint64_t hash = key.length * multiplier;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= key.length; i += sizeof(uint64_t)) {
+      uint64_t word;
+      std::memcpy(&word, key.data + i, sizeof(word));
+      hash = (hash ^ word) * multiplier;
+      hash ^= hash >> 32;
+    }
+    if (i < key.length) {
+      uint64_t word = 0;
+      std::memcpy(&word, key.data + i, key.length - i);
+      hash = (hash ^ word) * multiplier;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ull;
+    hash ^= hash >> 33;
+    return static_cast<size_t>(hash);
+  }
+};
+
+struct KeyEqual {
+  bool operator()(const Key &a, const Key &b) const {
+    return a.length == b.length &&
+           (a.length == 0 || std::memcmp(a.data, b.data, a.length) == 0);
+  }
+};
+
+using EntryList = std::list<Entry>;
+} // namespace
+
+struct FlowTable {
+public:
+  size_t footprint(const Entry &entry) const;
+  bool find(const char *key, size_t length, EntryList::iterator *it);
+  void erase(EntryList::iterator it);
+  void expire(EntryList *list, uint64_t timeout, uint64_t time);
+  void evict();
+
+public:
+  FlowTableDestroyFunc *destroy = nullptr;
+  void *data = nullptr;
+  uint64_t idleTimeout = 0;
+  uint64_t closedTimeout = 0;
+  size_t memoryLimit = 0;
+  EntryList active;
+  EntryList closed;
+  std::unordered_map<Key, EntryList::iterator, KeyHash, KeyEqual> map;
+  FlowTableStats stats = FlowTableStats();
+};
+
+size_t FlowTable::footprint(const Entry &entry) const {
+  return sizeof(Entry) + entry.key.size() + entry.size +
+         sizeof(EntryList::iterator) + sizeof(Key) + 4 * sizeof(void *);
+}
+
+bool FlowTable::find(const char *key, size_t length,
+                     EntryList::iterator *it) {
+  auto found = map.find(Key{key, length});
+  if (found == map.end())
+    return false;
+  *it = found->second;
+  return true;
+}
+
+void FlowTable::erase(EntryList::iterator it) {
+  void *value = it->value;
+  map.erase(Key{it->key.data(), it->key.size()});
+  stats.bytes -= footprint(*it);
+  if (it->closed) {
+    closed.erase(it);
+  } else {
+    active.erase(it);
+  }
+  stats.flows = map.size();
+  if (destroy) {
+    destroy(value, data);
+  }
+}
+
+void FlowTable::expire(EntryList *list, uint64_t timeout, uint64_t time) {
+  // Entries are kept in the order of access, so the oldest is at the front.
+  while (!list->empty()) {
+    const Entry &entry = list->front();
+    if (time < entry.time || time - entry.time < timeout)
+      break;
+    erase(list->begin());
+    ++stats.expired;
+  }
+}
+
+void FlowTable::evict() {
+  if (memoryLimit == 0)
+    return;
+  while (stats.bytes > memoryLimit && map.size() > 1) {
+    erase(closed.empty() ? active.begin() : closed.begin());
+    ++stats.evicted;
+  }
+}
+
+FlowTable *FlowTable_create(FlowTableDestroyFunc *destroy, void *data) {
+  FlowTable *table = new FlowTable();
+  table->destroy = destroy;
+  table->data = data;
+  return table;
+}
+
+void FlowTable_destroy(FlowTable *table) {
+  if (!table)
+    return;
+  while (!table->closed.empty()) {
+    table->erase(table->closed.begin());
+  }
+  while (!table->active.empty()) {
+    table->erase(table->active.begin());
+  }
+  delete table;
+}
+
+void FlowTable_setIdleTimeout(FlowTable *table, uint64_t timeout) {
+  table->idleTimeout = timeout;
+}
+
+void FlowTable_setClosedTimeout(FlowTable *table, uint64_t timeout) {
+  table->closedTimeout = timeout;
+}
+
+void FlowTable_setMemoryLimit(FlowTable *table, size_t bytes) {
+  table->memoryLimit = bytes;
+  table->evict();
+}
+
+void *FlowTable_find(FlowTable *table, const char *key, size_t length,
+                     uint64_t time) {
+  FlowTable_expire(table, time);
+  ++table->stats.lookups;
+  EntryList::iterator it;
+  if (!table->find(key, length, &it)) {
+    return nullptr;
+  }
+  ++table->stats.hits;
+  if (time > it->time) {
+    it->time = time;
+  }
+  EntryList &list = it->closed ? table->closed : table->active;
+  list.splice(list.end(), list, it);
+  return it->value;
+}
+
+void FlowTable_insert(FlowTable *table, const char *key, size_t length,
+                      void *value, size_t size, uint64_t time) {
+  FlowTable_expire(table, time);
+  EntryList::iterator found;
+  if (table->find(key, length, &found)) {
+    table->erase(found);
+  }
+
+  Entry entry;
+  entry.key.assign(key, length);
+  entry.value = value;
+  entry.size = size;
+  entry.time = time;
+  auto it = table->active.insert(table->active.end(), std::move(entry));
+  table->map[Key{it->key.data(), it->key.size()}] = it;
+  table->stats.bytes += table->footprint(*it);
+  table->stats.flows = table->map.size();
+  ++table->stats.inserted;
+  table->evict();
+}
+
+void FlowTable_setSize(FlowTable *table, const char *key, size_t length,
+                       size_t size) {
+  EntryList::iterator it;
+  if (!table->find(key, length, &it))
+    return;
+  table->stats.bytes -= table->footprint(*it);
+  it->size = size;
+  table->stats.bytes += table->footprint(*it);
+  table->evict();
+}
+
+void FlowTable_close(FlowTable *table, const char *key, size_t length,
+                     uint64_t time) {
+  EntryList::iterator it;
+  if (!table->find(key, length, &it) || it->closed)
+    return;
+  it->closed = true;
+  if (time > it->time) {
+    it->time = time;
+  }
+  table->closed.splice(table->closed.end(), table->active, it);
+  ++table->stats.closed;
+}
+
+void FlowTable_remove(FlowTable *table, const char *key, size_t length) {
+  EntryList::iterator it;
+  if (table->find(key, length, &it)) {
+    table->erase(it);
+  }
+}
+
+void FlowTable_expire(FlowTable *table, uint64_t time) {
+  if (table->idleTimeout > 0) {
+    table->expire(&table->active, table->idleTimeout, time);
+  }
+  table->expire(&table->closed, table->closedTimeout, time);
+}
+
+size_t FlowTable_size(const FlowTable *table) { return table->map.size(); }
+
+FlowTableStats FlowTable_stats(const FlowTable *table) { return table->stats; }
+} // namespace plugkit
@@ -3,7 +3,9 @@
 
 namespace plugkit {
 
-Frame::Frame() {}
+Frame::Frame() {
+  std::atomic_init(&mView, static_cast<const FrameView *>(nullptr));
+}
 
 Frame::~Frame() {}
 
@@ -27,7 +29,19 @@ uint32_t Frame::sourceId() const { return mSourceId; }
 
 void Frame::setSourceId(uint32_t id) { mSourceId = id; }
 
-const FrameView *Frame::view() const { return mView; }
+const FrameView *Frame::view() const {
+  return mView.load(std::memory_order_acquire);
+}
 
-void Frame::setView(const FrameView *view) { mView = view; }
+void Frame::setView(const FrameView *view) {
+  mView.store(view, std::memory_order_release);
+}
+
+const std::vector<const Layer *> &Frame::streamLayers() const {
+  return mStreamLayers;
+}
+
+void Frame::setStreamLayers(const std::vector<const Layer *> &layers) {
+  mStreamLayers = layers;
+}
 } // namespace plugkit
@@ -2,7 +2,9 @@
 #define PLUGKIT_FRAME_H
 
 #include "types.hpp"
+#include <atomic>
 #include <memory>
+#include <vector>
 
 namespace plugkit {
 
@@ -22,6 +24,8 @@ public:
   void setRootLayer(Layer *layer);
   const FrameView *view() const;
   void setView(const FrameView *view);
+  const std::vector<const Layer *> &streamLayers() const;
+  void setStreamLayers(const std::vector<const Layer *> &layers);
 
   uint32_t sourceId() const;
   void setSourceId(uint32_t id);
@@ -35,7 +39,8 @@ private:
   size_t mLength = 0;
   uint32_t mSeq = 0;
   Layer *mLayer = nullptr;
-  const FrameView *mView = nullptr;
+  std::atomic<const FrameView *> mView;
+  std::vector<const Layer *> mStreamLayers;
   uint32_t mSourceId = 0;
 };
 } // namespace plugkit
@@ -1,6 +1,7 @@
 #include "frame_store.hpp"
 #include "frame.hpp"
 #include "frame_view.hpp"
+#include <algorithm>
 #include <condition_variable>
 #include <map>
 #include <mutex>
@@ -9,15 +10,22 @@
 
 namespace plugkit {
 
+namespace {
+const size_t timeChunkSize = 1024;
+}
+
 class FrameStore::Private {
 public:
   Private();
   ~Private();
+  void advance();
 
 public:
   std::map<uint32_t, Frame *> sequence;
-  std::vector<Frame *> frames;
-  std::vector<const FrameView *> views;
+  std::vector<FrameView *> views;
+  std::vector<std::pair<Timestamp, Timestamp>> timeChunks;
+  std::unordered_set<const Frame *> completed;
+  size_t completedSize = 0;
   uint32_t maxSeq = 0;
   std::mutex mutex;
   std::condition_variable cond;
@@ -30,6 +38,12 @@ FrameStore::Private::Private() {}
 
 FrameStore::Private::~Private() {}
 
+void FrameStore::Private::advance() {
+  while (completedSize < views.size() && views[completedSize]->complete()) {
+    ++completedSize;
+  }
+}
+
 FrameStore::FrameStore(const Callback &callback) : d(new Private()) {
   d->callback = callback;
 }
@@ -45,43 +59,41 @@ void FrameStore::insert(Frame **begin, size_t size) {
   auto end = d->sequence.begin();
   for (auto it = d->sequence.find(maxSeq + 1); it != d->sequence.end();
        end = it, it = d->sequence.find(++maxSeq + 1)) {
-    d->frames.push_back(it->second);
+    FrameView *view = new FrameView(it->second);
+    if (d->completed.erase(it->second) > 0) {
+      view->setComplete();
+    }
+    // Keeps the earliest and the latest timestamp of each chunk of frames,
+    // which are not always in order.
+    const Timestamp &ts = it->second->timestamp();
+    if (d->views.size() % timeChunkSize == 0) {
+      d->timeChunks.push_back(std::make_pair(ts, ts));
+    } else {
+      auto &chunk = d->timeChunks.back();
+      chunk.first = std::min(chunk.first, ts);
+      chunk.second = std::max(chunk.second, ts);
+    }
+    d->views.push_back(view);
   }
   if (d->maxSeq < maxSeq) {
     d->callback();
     d->maxSeq = maxSeq;
     d->sequence.erase(d->sequence.begin(), end);
+    d->advance();
     d->cond.notify_all();
   }
 }
 
-size_t FrameStore::dequeue(size_t offset, size_t max, const Frame **dst) const {
-  std::unique_lock<std::mutex> lock(d->mutex);
-  size_t read = 0;
-  uint32_t size = d->frames.size();
-  if (size <= offset) {
-    d->cond.wait(lock, [this, offset, &size]() -> bool {
-      return d->closed || ((size = d->frames.size()) > offset);
-    });
-  }
-  if (d->closed)
-    return 0;
-  for (size_t i = 0; i + offset < size && i < max; ++i, ++read) {
-    dst[i] = d->frames[i + offset];
-  }
-  return read;
-}
-
 size_t FrameStore::dequeue(size_t offset, size_t max, const FrameView **dst,
                            std::thread::id id) const {
   std::unique_lock<std::mutex> lock(d->mutex);
   size_t read = 0;
-  uint32_t size = d->views.size();
+  uint32_t size = d->completedSize;
   if (size <= offset) {
     d->cond.wait(lock, [this, offset, id, &size]() -> bool {
       bool closed =
           ((id != std::thread::id()) && d->closedThreads.count(id) > 0);
-      return d->closed || closed || ((size = d->views.size()) > offset);
+      return d->closed || closed || ((size = d->completedSize) > offset);
     });
   }
   if (id != std::thread::id() && d->closedThreads.count(id) > 0) {
@@ -106,19 +118,81 @@ std::vector<const FrameView *> FrameStore::get(uint32_t offset,
   return views;
 }
 
+size_t FrameStore::get(const uint32_t *indices, size_t size,
+                       const FrameView **dst) const {
+  std::unique_lock<std::mutex> lock(d->mutex);
+  size_t read = 0;
+  for (size_t i = 0; i < size; ++i) {
+    uint32_t index = indices[i];
+    if (index > 0 && index <= d->views.size()) {
+      dst[read++] = d->views[index - 1];
+    }
+  }
+  return read;
+}
+
+std::vector<uint32_t> FrameStore::findByTime(const Timestamp &begin,
+                                             const Timestamp &end) const {
+  std::vector<uint32_t> indices;
+  std::unique_lock<std::mutex> lock(d->mutex);
+  for (size_t i = 0; i < d->timeChunks.size(); ++i) {
+    const auto &chunk = d->timeChunks[i];
+    if (chunk.second < begin || chunk.first >= end)
+      continue;
+    size_t last = std::min((i + 1) * timeChunkSize, d->views.size());
+    for (size_t j = i * timeChunkSize; j < last; ++j) {
+      const Timestamp &ts = d->views[j]->frame()->timestamp();
+      if (ts >= begin && ts < end) {
+        indices.push_back(j + 1);
+      }
+    }
+  }
+  return indices;
+}
+
+bool FrameStore::timeRange(size_t offset, size_t length, Timestamp *min,
+                           Timestamp *max) const {
+  std::unique_lock<std::mutex> lock(d->mutex);
+  if (length == 0 || offset + length > d->views.size())
+    return false;
+  size_t first = offset / timeChunkSize;
+  size_t last = (offset + length - 1) / timeChunkSize;
+  *min = d->timeChunks[first].first;
+  *max = d->timeChunks[first].second;
+  for (size_t i = first + 1; i <= last; ++i) {
+    *min = std::min(*min, d->timeChunks[i].first);
+    *max = std::max(*max, d->timeChunks[i].second);
+  }
+  return true;
+}
+
 size_t FrameStore::dissectedSize() const {
   std::unique_lock<std::mutex> lock(d->mutex);
   return d->views.size();
 }
 
-void FrameStore::update(uint32_t index) {
+size_t FrameStore::completedSize() const {
+  std::unique_lock<std::mutex> lock(d->mutex);
+  return d->completedSize;
+}
+
+void FrameStore::update(const Frame **begin, size_t size) {
   {
     std::unique_lock<std::mutex> lock(d->mutex);
-    size_t size = d->views.size();
-    d->views.resize(index);
-    for (size_t i = size; i < index; ++i) {
-      d->views[i] = new FrameView(d->frames[i]);
+    bool updated = false;
+    for (size_t i = 0; i < size; ++i) {
+      const Frame *frame = begin[i];
+      uint32_t index = frame->index();
+      if (index >= 1 && index <= d->views.size()) {
+        d->views[index - 1]->setComplete();
+        updated = true;
+      } else {
+        d->completed.insert(frame);
+      }
     }
+    if (!updated)
+      return;
+    d->advance();
   }
   d->callback();
   d->cond.notify_all();
@@ -1,6 +1,7 @@
 #ifndef PLUGKIT_FRAME_STORE_HPP
 #define PLUGKIT_FRAME_STORE_HPP
 
+#include "types.hpp"
 #include <functional>
 #include <memory>
 #include <thread>
@@ -25,10 +26,23 @@ public:
   void insert(Frame **, size_t size);
   size_t dequeue(size_t offset, size_t max, const FrameView **dst,
                  std::thread::id id = std::thread::id()) const;
-  size_t dequeue(size_t offset, size_t max, const Frame **dst) const;
   size_t dissectedSize() const;
-  void update(uint32_t index);
+  size_t completedSize() const;
+  void update(const Frame **begin, size_t size);
   std::vector<const FrameView *> get(uint32_t offset, uint32_t length) const;
+  size_t get(const uint32_t *indices, size_t size,
+             const FrameView **dst) const;
+
+  /// Returns the indices of the frames in [begin, end).
+  ///
+  /// Chunks of frames are skipped by their earliest and latest timestamps.
+  std::vector<uint32_t> findByTime(const Timestamp &begin,
+                                   const Timestamp &end) const;
+
+  /// Gets the earliest and the latest timestamps of the chunks containing
+  /// the frames in [offset, offset + length).
+  bool timeRange(size_t offset, size_t length, Timestamp *min,
+                 Timestamp *max) const;
   void close(std::thread::id id = std::thread::id());
 
 private:
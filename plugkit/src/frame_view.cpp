@@ -1,42 +1,59 @@
 #include "frame_view.hpp"
 #include "frame.hpp"
 #include "layer.hpp"
+#include <algorithm>
 #include <functional>
 #include <vector>
 
 namespace plugkit {
 
-FrameView::FrameView(Frame *frame) : mFrame(frame), mPrimaryLayer(nullptr) {
+FrameView::FrameView(Frame *frame) : mFrame(frame) {
+  std::atomic_init(&mCompleted, false);
+
+  // Layers handed to the stream dissectors may still be modified by the
+  // stream threads, so they are left out until the frame is complete.
+  findLayers(&mPartial, false);
   frame->setView(this);
+}
 
-  std::function<void(const Layer *)> findLeafLayers = [this, &findLeafLayers](
-      const Layer *layer) {
-    if (!layer)
-      return;
-    mLayers.push_back(layer);
-    if (layer->layers().empty()) {
-      mLeafLayers.push_back(layer);
-    } else {
-      for (const Layer *child : layer->layers()) {
-        findLeafLayers(child);
-      }
-    }
-  };
+FrameView::~FrameView() {}
+
+void FrameView::findLayers(Tree *tree, bool complete) const {
+  const auto &streamLayers = mFrame->streamLayers();
+  std::function<bool(const Layer *)> findLeafLayers =
+      [tree, complete, &streamLayers, &findLeafLayers](const Layer *layer) {
+        if (!layer)
+          return false;
+        if (!complete && std::find(streamLayers.begin(), streamLayers.end(),
+                                   layer) != streamLayers.end())
+          return false;
+        tree->layers.push_back(layer);
+        bool hasChild = false;
+        for (const Layer *child : layer->layers()) {
+          hasChild = findLeafLayers(child) || hasChild;
+        }
+        if (!hasChild) {
+          tree->leafLayers.push_back(layer);
+        }
+        return true;
+      };
   findLeafLayers(mFrame->rootLayer());
 
-  if (!mLeafLayers.empty()) {
-    mPrimaryLayer = mLeafLayers.front();
+  if (!tree->leafLayers.empty()) {
+    tree->primaryLayer = tree->leafLayers.front();
   }
 }
 
-FrameView::~FrameView() {}
+const FrameView::Tree &FrameView::tree() const {
+  return complete() ? mComplete : mPartial;
+}
 
 const Frame *FrameView::frame() const { return mFrame; }
 
-const Layer *FrameView::primaryLayer() const { return mPrimaryLayer; }
+const Layer *FrameView::primaryLayer() const { return tree().primaryLayer; }
 
 const std::vector<const Layer *> &FrameView::leafLayers() const {
-  return mLeafLayers;
+  return tree().leafLayers;
 }
 
 const Attr *FrameView::attr(Token id) const {
@@ -51,11 +68,30 @@ const Attr *FrameView::attr(Token id) const {
 }
 
 const Layer *FrameView::layer(Token id) const {
-  for (const auto &layer : mLayers) {
+  for (const auto &layer : tree().layers) {
     if (layer->id() == id) {
       return layer;
     }
   }
   return nullptr;
 }
+
+bool FrameView::visible(const Layer *layer) const {
+  if (complete())
+    return true;
+  const auto &streamLayers = mFrame->streamLayers();
+  return std::find(streamLayers.begin(), streamLayers.end(), layer) ==
+         streamLayers.end();
+}
+
+bool FrameView::complete() const {
+  return mCompleted.load(std::memory_order_acquire);
+}
+
+void FrameView::setComplete() {
+  if (complete())
+    return;
+  findLayers(&mComplete, true);
+  mCompleted.store(true, std::memory_order_release);
+}
 } // namespace plugkit
@@ -3,6 +3,7 @@
 
 #include "attribute.hpp"
 #include "token.h"
+#include <atomic>
 #include <memory>
 #include <vector>
 
@@ -22,16 +23,28 @@ public:
   const std::vector<const Layer *> &leafLayers() const;
   const Attr *attr(Token id) const;
   const Layer *layer(Token id) const;
+  bool visible(const Layer *layer) const;
+  bool complete() const;
+  void setComplete();
 
 private:
   FrameView(const FrameView &view) = delete;
   FrameView &operator=(const FrameView &view) = delete;
 
+private:
+  struct Tree {
+    const Layer *primaryLayer = nullptr;
+    std::vector<const Layer *> leafLayers;
+    std::vector<const Layer *> layers;
+  };
+  void findLayers(Tree *tree, bool complete) const;
+  const Tree &tree() const;
+
 private:
   const Frame *mFrame;
-  const Layer *mPrimaryLayer;
-  std::vector<const Layer *> mLeafLayers;
-  std::vector<const Layer *> mLayers;
+  Tree mPartial;
+  Tree mComplete;
+  std::atomic<bool> mCompleted;
 };
 } // namespace plugkit
 
@@ -1,5 +1,6 @@
 #include "layer.hpp"
 #include "attribute.hpp"
+#include "frame.hpp"
 #include "payload.hpp"
 #include "wrapper/layer.hpp"
 #include <functional>
@@ -29,9 +30,9 @@ const std::vector<Layer *> &Layer::subLayers() const { return mSubLayers; }
 
 void Layer::addSubLayer(Layer *child) { mSubLayers.push_back(child); }
 
-uint8_t Layer::worker() const { return mData & 0xf; }
+uint32_t Layer::worker() const { return mWorker; }
 
-void Layer::setWorker(uint8_t id) { mData = ((mData & 0xf0) | (id % 16)); }
+void Layer::setWorker(uint32_t id) { mWorker = id; }
 
 const std::vector<Token> &Layer::tags() const { return mTags; }
 
@@ -54,6 +55,9 @@ const Frame *Layer::frame() const { return mFrame; }
 void Layer::setFrame(const Frame *frame) { mFrame = frame; }
 
 const Attr *Layer::attr(Token id) const {
+  if (!mIndex.empty()) {
+    return mIndex.find(id);
+  }
   for (const auto &child : mAttrs) {
     if (child->id() == id) {
       return child;
@@ -62,13 +66,37 @@ const Attr *Layer::attr(Token id) const {
   return nullptr;
 }
 
-void Layer::addAttr(const Attr *prop) { mAttrs.push_back(prop); }
+void Layer::addAttr(const Attr *prop) {
+  mAttrs.push_back(prop);
+  mIndex.clear();
+}
+
+void Layer::reserveAttrs(size_t size) { mAttrs.reserve(size); }
+
+// Called once the dissectors are done with the layer. Attributes added
+// afterwards drop the index and fall back to a linear scan.
+void Layer::seal() {
+  mIndex.build(mAttrs);
+  for (const Payload *payload : mPayloads) {
+    // Payloads are owned by the layer; see Layer_addPayload().
+    const_cast<Payload *>(payload)->seal();
+  }
+}
 
 Token Layer_id(const Layer *layer) { return layer->id(); }
 
-uint8_t Layer_worker(const Layer *layer) { return layer->worker(); }
+uint32_t Layer_worker(const Layer *layer) { return layer->worker(); }
+
+void Layer_setWorker(Layer *layer, uint32_t id) { layer->setWorker(id); }
 
-void Layer_setWorker(Layer *layer, uint8_t id) { layer->setWorker(id); }
+uint64_t Layer_timestamp(const Layer *layer) {
+  if (const Frame *frame = layer->frame()) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               frame->timestamp().time_since_epoch())
+        .count();
+  }
+  return 0;
+}
 
 LayerConfidence Layer_confidence(const Layer *layer) {
   return layer->confidence();
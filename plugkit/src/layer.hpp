@@ -1,6 +1,7 @@
 #ifndef PLUGKIT_LAYER_HPP
 #define PLUGKIT_LAYER_HPP
 
+#include "attribute.hpp"
 #include "layer.h"
 #include "token.h"
 #include "types.hpp"
@@ -28,9 +29,10 @@ public:
   const std::vector<const Attr *> &attrs() const;
   const Attr *attr(Token id) const;
   void addAttr(const Attr *prop);
+  void reserveAttrs(size_t size);
 
-  uint8_t worker() const;
-  void setWorker(uint8_t id);
+  uint32_t worker() const;
+  void setWorker(uint32_t id);
 
   const std::vector<const Payload *> &payloads() const;
   void addPayload(const Payload *payload);
@@ -44,6 +46,8 @@ public:
   const Frame *frame() const;
   void setFrame(const Frame *frame);
 
+  void seal();
+
 private:
   Layer(const Layer &layer) = delete;
   Layer &operator=(const Layer &layer) = delete;
@@ -51,6 +55,7 @@ private:
 private:
   Token mId = 0;
   uint8_t mData = 0;
+  uint32_t mWorker = 0;
   Layer *mParent = nullptr;
   const Frame *mFrame = nullptr;
   std::vector<const Payload *> mPayloads;
@@ -58,6 +63,7 @@ private:
   std::vector<Layer *> mLayers;
   std::vector<Layer *> mSubLayers;
   std::vector<const Attr *> mAttrs;
+  AttrIndex mIndex;
 };
 } // namespace plugkit
 
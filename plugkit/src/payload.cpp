@@ -20,6 +20,9 @@ size_t Payload::length() const { return mLength; }
 const std::vector<const Attr *> &Payload::attrs() const { return mAttrs; }
 
 const Attr *Payload::attr(Token id) const {
+  if (!mIndex.empty()) {
+    return mIndex.find(id);
+  }
   for (const auto &prop : mAttrs) {
     if (prop->id() == id) {
       return prop;
@@ -28,7 +31,12 @@ const Attr *Payload::attr(Token id) const {
   return nullptr;
 }
 
-void Payload::addAttr(const Attr *prop) { mAttrs.push_back(prop); }
+void Payload::addAttr(const Attr *prop) {
+  mAttrs.push_back(prop);
+  mIndex.clear();
+}
+
+void Payload::seal() { mIndex.build(mAttrs); }
 
 Token Payload::type() const { return mType; }
 
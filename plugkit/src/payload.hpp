@@ -1,6 +1,7 @@
 #ifndef PLUGKIT_PAYLOAD_HPP
 #define PLUGKIT_PAYLOAD_HPP
 
+#include "attribute.hpp"
 #include "payload.h"
 #include "slice.h"
 #include "token.h"
@@ -26,6 +27,8 @@ public:
   const Attr *attr(Token id) const;
   void addAttr(const Attr *prop);
 
+  void seal();
+
 private:
   Payload(const Payload &payload) = delete;
   Payload &operator=(const Payload &payload) = delete;
@@ -34,6 +37,7 @@ private:
   Token mType;
   std::vector<Slice> mSlices;
   std::vector<const Attr *> mAttrs;
+  AttrIndex mIndex;
   size_t mLength = 0;
 };
 } // namespace plugkit
@@ -58,6 +58,8 @@ PlugkitModule::PlugkitModule(v8::Isolate *isolate,
              Nan::New<v8::FunctionTemplate>(Token_get_wrap)->GetFunction());
   token->Set(Nan::New("string").ToLocalChecked(),
              Nan::New<v8::FunctionTemplate>(Token_string_wrap)->GetFunction());
+  token->Set(Nan::New("keywordCount").ToLocalChecked(),
+             Nan::New(Token_keywordCount));
   exports->Set(Nan::New("Token").ToLocalChecked(), token);
 
   for (const char *data : files) {
@@ -1,5 +1,6 @@
 #include "plugkit_testing.hpp"
 #include "attribute.hpp"
+#include "filter.hpp"
 #include "payload.hpp"
 #include "layer.hpp"
 #include "frame.hpp"
@@ -11,7 +12,11 @@
 #include "wrapper/layer.hpp"
 #include "wrapper/frame.hpp"
 #include "wrapper/logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <memory>
 #include <nan.h>
+#include <vector>
 
 #define CATCH_CONFIG_RUNNER
 #include "catch.hpp"
@@ -67,6 +72,73 @@ void createLayerInstance(v8::FunctionCallbackInfo<v8::Value> const &info) {
   }, Nan::WeakCallbackType::kParameter);
   info.GetReturnValue().Set(persistent);
 }
+struct BenchFrame {
+  BenchFrame(uint32_t src, uint32_t dst)
+      : eth(Token_get("eth")), ipv4(Token_get("ipv4")), tcp(Token_get("tcp")),
+        src(Token_get("tcp.src"), Variant(src)),
+        dst(Token_get("tcp.dst"), Variant(dst)) {
+    tcp.addAttr(&this->src);
+    tcp.addAttr(&this->dst);
+    ipv4.addLayer(&tcp);
+    eth.addLayer(&ipv4);
+    frame.setRootLayer(&eth);
+    view.reset(new FrameView(&frame));
+  }
+
+  Frame frame;
+  Layer eth;
+  Layer ipv4;
+  Layer tcp;
+  Attr src;
+  Attr dst;
+  std::unique_ptr<FrameView> view;
+};
+
+// Tests the same frames with the script alone, the generic FilterProgram, the
+// specialized FilterProgram and the FilterProgram compiled by FilterJit, and
+// returns the time per frame of each in nanoseconds along with the number of
+// matches.
+void runFilterBenchmark(v8::FunctionCallbackInfo<v8::Value> const &info) {
+  const std::string &body = *Nan::Utf8String(info[0]);
+  const std::string &program = *Nan::Utf8String(info[1]);
+  uint32_t size = info[2]->Uint32Value();
+
+  std::vector<std::unique_ptr<BenchFrame>> frames;
+  std::vector<const FrameView *> views;
+  for (uint32_t i = 0; i < size; ++i) {
+    frames.emplace_back(new BenchFrame(1024 + i % 64000, i % 2048));
+    views.push_back(frames.back()->view.get());
+  }
+
+  auto result = Nan::New<v8::Object>();
+  auto run = [&](const char *name, const Filter &filter) {
+    std::vector<uint64_t> results((size + 63) / 64);
+    const size_t batchSize = 128;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < size; i += batchSize) {
+      filter.test(&results[i / 64], &views[i],
+                  std::min<size_t>(batchSize, size - i));
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start);
+    uint32_t matches = 0;
+    for (uint64_t word : results) {
+      for (; word; word &= word - 1) {
+        ++matches;
+      }
+    }
+    auto entry = Nan::New<v8::Object>();
+    entry->Set(Nan::New("nsPerFrame").ToLocalChecked(),
+               Nan::New(static_cast<double>(elapsed.count()) / size));
+    entry->Set(Nan::New("matches").ToLocalChecked(), Nan::New(matches));
+    result->Set(Nan::New(name).ToLocalChecked(), entry);
+  };
+  run("script", Filter(body, std::string()));
+  run("interpreter", Filter(body, program, false));
+  run("specialized", Filter(body, program, true));
+  run("jit", Filter(body, program, true, true));
+  info.GetReturnValue().Set(result);
+}
 void createFrameInstance(v8::FunctionCallbackInfo<v8::Value> const &info) {
   auto view = new FrameView(new Frame());
   Nan::Persistent<v8::Object> persistent(FrameWrapper::wrap(view));
@@ -86,6 +158,9 @@ void PlugkitTesting::init(v8::Local<v8::Object> exports) {
                LoggerWrapper::wrap(std::make_shared<NullLogger>()));
   testing->Set(Nan::New("runCApiTests").ToLocalChecked(),
                v8::FunctionTemplate::New(isolate, runCApiTests)->GetFunction());
+  testing->Set(
+      Nan::New("runFilterBenchmark").ToLocalChecked(),
+      v8::FunctionTemplate::New(isolate, runFilterBenchmark)->GetFunction());
   testing->Set(Nan::New("externalize").ToLocalChecked(),
                v8::FunctionTemplate::New(isolate, externalize)->GetFunction());
   testing->Set(
@@ -1,7 +1,11 @@
 #include "reader.h"
+#include "attribute.hpp"
+#include "byte_order.hpp"
+#include "layer.hpp"
 #include "payload.hpp"
 #include <algorithm>
 #include <cstring>
+#include <new>
 #include <vector>
 
 namespace plugkit {
@@ -18,8 +22,7 @@ template <class T> T readLE(Reader *reader) {
     reader->lastError = outOfBoundError();
     return T();
   }
-  T value =
-      *reinterpret_cast<const T *>(reader->data.begin + reader->lastRange.end);
+  T value = loadLE<T>(reader->data.begin + reader->lastRange.end);
   reader->lastRange.end += sizeof(T);
   reader->lastRange.begin = reader->lastRange.end - sizeof(T);
   return value;
@@ -30,16 +33,57 @@ template <class T> T readBE(Reader *reader) {
     reader->lastError = outOfBoundError();
     return T();
   }
-  char data[sizeof(T)];
-  std::reverse_copy(reader->data.begin + reader->lastRange.end,
-                    reader->data.begin + reader->lastRange.end + sizeof(T),
-                    data);
-  T value = *reinterpret_cast<const T *>(data);
+  T value = loadBE<T>(reader->data.begin + reader->lastRange.end);
   reader->lastRange.end += sizeof(T);
   reader->lastRange.begin = reader->lastRange.end - sizeof(T);
   return value;
 }
+
+uint64_t loadField(const char *data, const Field &field) {
+  bool littleEndian = field.flags & FIELD_LITTLE_ENDIAN;
+  switch (field.size) {
+  case 1:
+    return static_cast<uint8_t>(data[0]);
+  case 2:
+    return littleEndian ? loadLE<uint16_t>(data) : loadBE<uint16_t>(data);
+  case 4:
+    return littleEndian ? loadLE<uint32_t>(data) : loadBE<uint32_t>(data);
+  case 8:
+    return littleEndian ? loadLE<uint64_t>(data) : loadBE<uint64_t>(data);
+  default:
+    return 0;
+  }
+}
+
+Variant fieldValue(const char *data, const Field &field) {
+  if (field.flags & FIELD_SLICE) {
+    return data ? Variant(Slice{data, data + field.size}) : Variant(Slice{});
+  }
+  uint64_t value = data ? loadField(data, field) : 0;
+  value >>= field.shift;
+  if (field.mask) {
+    value &= field.mask;
+  }
+  if (field.flags & FIELD_BOOL) {
+    return Variant(value != 0);
+  }
+  if (field.flags & FIELD_SIGNED) {
+    if (field.size < 8) {
+      uint64_t sign = uint64_t(1) << (field.size * 8 - 1);
+      value = (value ^ sign) - sign;
+    }
+    if (field.size <= 4) {
+      return Variant(static_cast<int32_t>(value));
+    }
+    return Variant(static_cast<int64_t>(value));
+  }
+  if (field.size <= 4) {
+    return Variant(static_cast<uint32_t>(value));
+  }
+  return Variant(value);
+}
 } // namespace
+
 void Reader_reset(Reader *reader) { std::memset(reader, 0, sizeof(Reader)); }
 
 Slice Reader_slice(Reader *reader, size_t begin, size_t end) {
@@ -89,7 +133,7 @@ int32_t Reader_getInt32(Reader *reader, bool littleEndian) {
   return littleEndian ? readLE<int32_t>(reader) : readBE<int32_t>(reader);
 }
 int64_t Reader_getInt64(Reader *reader, bool littleEndian) {
-  return littleEndian ? readLE<uint64_t>(reader) : readBE<int64_t>(reader);
+  return littleEndian ? readLE<int64_t>(reader) : readBE<int64_t>(reader);
 }
 
 float Reader_getFloat32(Reader *reader, bool littleEndian) {
@@ -98,4 +142,38 @@ float Reader_getFloat32(Reader *reader, bool littleEndian) {
 double Reader_getFloat64(Reader *reader, bool littleEndian) {
   return littleEndian ? readLE<double>(reader) : readBE<double>(reader);
 }
+
+void Reader_readLayout(Reader *reader, const Layout *layout, Layer *layer,
+                       Attr **attrs) {
+  size_t begin = reader->lastRange.end;
+  size_t space = Slice_length(reader->data) - begin;
+  const char *data = reader->data.begin + begin;
+  bool inBounds = space >= layout->size;
+
+  // Attributes are owned by the frame and never deleted one by one, so the
+  // fields of a layout share a single allocation.
+  Attr *block = static_cast<Attr *>(
+      ::operator new(sizeof(Attr) * std::max<size_t>(layout->length, 1)));
+  layer->reserveAttrs(layer->attrs().size() + layout->length);
+  for (size_t i = 0; i < layout->length; ++i) {
+    const Field &field = layout->fields[i];
+    bool available = inBounds || space >= size_t(field.offset) + field.size;
+    Attr *attr = new (block + i) Attr(
+        field.id, fieldValue(available ? data + field.offset : nullptr, field),
+        field.type);
+    attr->setRange(
+        Range{begin + field.offset, begin + field.offset + field.size});
+    layer->addAttr(attr);
+    if (attrs) {
+      attrs[i] = attr;
+    }
+  }
+
+  if (!inBounds) {
+    reader->lastError = outOfBoundError();
+  }
+  size_t size = inBounds ? layout->size : space;
+  reader->lastRange.begin = begin;
+  reader->lastRange.end = begin + size;
+}
 } // namespace plugkit
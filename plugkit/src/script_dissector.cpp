@@ -9,6 +9,7 @@ namespace {
 struct WorkerHolder {
   v8::UniquePersistent<v8::Object> worker;
   v8::UniquePersistent<v8::Function> analyze;
+  v8::UniquePersistent<v8::Function> analyzeBatch;
 };
 }
 
@@ -74,6 +75,12 @@ Dissector ScriptDissector::create(char *script) {
       holder->worker.Reset(v8::Isolate::GetCurrent(), worker);
       holder->analyze.Reset(v8::Isolate::GetCurrent(),
                             analyze.As<v8::Function>());
+      auto analyzeBatch =
+          worker->Get(Nan::New("analyzeBatch").ToLocalChecked());
+      if (analyzeBatch->IsFunction()) {
+        holder->analyzeBatch.Reset(v8::Isolate::GetCurrent(),
+                                   analyzeBatch.As<v8::Function>());
+      }
     }
     return Worker{holder};
   };
@@ -95,6 +102,34 @@ Dissector ScriptDissector::create(char *script) {
       analyze->Call(obj, 2, args);
     }
   };
+  dissector.analyzeBatch = [](Context *ctx, const Dissector *diss,
+                              Worker worker, Layer **layers, size_t size) {
+    auto holder = static_cast<WorkerHolder *>(worker.data);
+    if (!holder)
+      return;
+    auto isolate = v8::Isolate::GetCurrent();
+    auto obj = v8::Local<v8::Object>::New(isolate, holder->worker);
+    auto context = ContextWrapper::wrap(ctx);
+    if (holder->analyzeBatch.IsEmpty()) {
+      auto analyze = v8::Local<v8::Function>::New(isolate, holder->analyze);
+      for (size_t i = 0; i < size; ++i) {
+        v8::Local<v8::Value> args[] = {context, LayerWrapper::wrap(layers[i])};
+        analyze->Call(obj, 2, args);
+      }
+      return;
+    }
+
+    // Workers which define analyzeBatch(ctx, layers) receive the whole batch
+    // in a single call.
+    auto analyzeBatch =
+        v8::Local<v8::Function>::New(isolate, holder->analyzeBatch);
+    auto array = Nan::New<v8::Array>(static_cast<int>(size));
+    for (uint32_t i = 0; i < size; ++i) {
+      array->Set(i, LayerWrapper::wrap(layers[i]));
+    }
+    v8::Local<v8::Value> args[] = {context, array};
+    analyzeBatch->Call(obj, 2, args);
+  };
   return dissector;
 }
 } // namespace plugkit
@@ -1,5 +1,6 @@
 #include "session.hpp"
 #include "script_dissector.hpp"
+#include "attribute_index.hpp"
 #include "dissector_thread.hpp"
 #include "dissector_thread_pool.hpp"
 #include "filter_thread.hpp"
@@ -50,7 +51,8 @@ public:
   std::shared_ptr<UvLoopLogger> logger;
   std::unique_ptr<DissectorThreadPool> dissectorPool;
   std::unique_ptr<StreamDissectorThreadPool> streamDissectorPool;
-  std::unordered_map<std::string, std::unique_ptr<FilterThreadPool>> filters;
+  std::unique_ptr<FilterThreadPool> filterPool;
+  std::unique_ptr<AttributeIndex> attributeIndex;
   std::unordered_map<int, Token> linkLayers;
   std::shared_ptr<FrameStore> frameStore;
   std::unique_ptr<Pcap> pcap;
@@ -84,9 +86,9 @@ void Session::Private::updateStatus() {
   }
   if (flags & Private::UPDATE_FILTER) {
     FilterStatusMap status;
-    for (const auto &pair : filters) {
+    for (const auto &pair : filterPool->sizes()) {
       FilterStatus filter;
-      filter.frames = pair.second->size();
+      filter.frames = pair.second;
       status[pair.first] = filter;
     }
     filterCallback(status);
@@ -94,6 +96,7 @@ void Session::Private::updateStatus() {
   if (flags & Private::UPDATE_FRAME) {
     FrameStatus status;
     status.frames = frameStore->dissectedSize();
+    status.completed = frameStore->completedSize();
     frameCallback(status);
   }
 }
@@ -134,13 +137,28 @@ Session::Session(const Config &config) : d(new Private(config)) {
 
   d->dissectorPool.reset(new DissectorThreadPool(
       d->config.options, [this](Frame **begin, size_t size) {
+        // The stream dissector pool marks the layers it takes over,
+        // so it has to see the frames before they are published.
+        d->streamDissectorPool->push(begin, size);
         d->frameStore->insert(begin, size);
       }));
   d->dissectorPool->setLogger(d->logger);
 
-  d->streamDissectorPool.reset(new StreamDissectorThreadPool(
+  d->filterPool.reset(new FilterThreadPool(
       d->config.options, d->frameStore,
-      [this](uint32_t maxSeq) { d->frameStore->update(maxSeq); }));
+      [this]() { d->notifyStatus(Private::UPDATE_FILTER); }));
+  d->filterPool->setLogger(d->logger);
+
+  d->attributeIndex.reset(new AttributeIndex(d->config.options));
+
+  d->streamDissectorPool.reset(new StreamDissectorThreadPool(
+      d->config.options,
+      [this](const Frame **begin, size_t size) {
+        // Frames are indexed before they are published, so that a complete
+        // frame can always be found in the index.
+        d->attributeIndex->insert(begin, size);
+        d->frameStore->update(begin, size);
+      }));
   d->streamDissectorPool->setLogger(d->logger);
 
   d->pcap->setCallback([this](Frame *frame) {
@@ -176,8 +194,8 @@ Session::Session(const Config &config) : d(new Private(config)) {
 Session::~Session() {
   stopPcap();
   d->updateStatus();
+  d->filterPool.reset();
   d->frameStore->close();
-  d->filters.clear();
   d->pcap.reset();
   d->dissectorPool.reset();
   d->streamDissectorPool.reset();
@@ -220,33 +238,48 @@ int Session::id() const { return d->id; }
 Variant Session::options() const { return d->config.options; }
 
 void Session::setDisplayFilter(const std::string &name,
-                               const std::string &body) {
-
-  auto filter = d->filters.find(name);
-  if (body.empty()) {
-    if (filter != d->filters.end()) {
-      d->filters.erase(filter);
-    }
-  } else {
-    auto pool = std::unique_ptr<FilterThreadPool>(
-        new FilterThreadPool(body, d->config.options, d->frameStore, [this]() {
-          d->notifyStatus(Private::UPDATE_FILTER);
-        }));
-    pool->setLogger(d->logger);
-    pool->start();
-    d->filters[name] = std::move(pool);
-  }
+                               const std::string &body,
+                               const std::string &program) {
+  d->filterPool->setFilter(name, body, program);
   d->notifyStatus(Private::UPDATE_FILTER);
 }
 
 std::vector<uint32_t> Session::getFilteredFrames(const std::string &name,
                                                  uint32_t offset,
                                                  uint32_t length) const {
-  auto filter = d->filters.find(name);
-  if (filter != d->filters.end()) {
-    return filter->second->get(offset, length);
-  }
-  return std::vector<uint32_t>();
+  return d->filterPool->get(name, offset, length);
+}
+
+std::vector<uint32_t>
+Session::getFilteredFrames(const std::vector<std::string> &names,
+                           FilterOperator op, uint32_t offset,
+                           uint32_t length) const {
+  return d->filterPool->get(names,
+                            (op == FILTER_OR) ? FilterThreadPool::OPERATOR_OR
+                                              : FilterThreadPool::OPERATOR_AND,
+                            offset, length);
+}
+
+void Session::setFilterLimit(const std::string &name, uint32_t limit) {
+  d->filterPool->setLimit(name, limit);
+}
+
+std::vector<uint32_t> Session::getNearestFrames(const std::string &name,
+                                                uint32_t index,
+                                                uint32_t length) {
+  return d->filterPool->nearest(name, index, length);
+}
+
+std::vector<uint32_t> Session::getIndexedFrames(const std::string &name,
+                                                const Variant &value,
+                                                uint32_t offset,
+                                                uint32_t length) const {
+  return d->attributeIndex->find(name, value, offset, length);
+}
+
+std::vector<uint32_t> Session::getFramesByTime(const Timestamp &begin,
+                                               const Timestamp &end) const {
+  return d->frameStore->findByTime(begin, end);
 }
 
 std::vector<const FrameView *> Session::getFrames(uint32_t offset,
@@ -254,6 +287,19 @@ std::vector<const FrameView *> Session::getFrames(uint32_t offset,
   return d->frameStore->get(offset, length);
 }
 
+std::vector<Session::StreamThreadStatus>
+Session::getStreamThreadStatus() const {
+  std::vector<StreamThreadStatus> status;
+  for (const auto &thread : d->streamDissectorPool->threadStatus()) {
+    StreamThreadStatus stat;
+    stat.streams = thread.streams;
+    stat.activeStreams = thread.activeStreams;
+    stat.layers = thread.layers;
+    status.push_back(stat);
+  }
+  return status;
+}
+
 void Session::analyze(const std::vector<RawFrame> &rawFrames) {
   Token unknown = Token_get("[unknown]");
   std::vector<Frame *> frames;
@@ -38,12 +38,20 @@ public:
   };
   using FilterStatusMap = std::unordered_map<std::string, FilterStatus>;
   using FilterCallback = std::function<void(const FilterStatusMap &)>;
+  enum FilterOperator { FILTER_AND, FILTER_OR };
 
   struct FrameStatus {
     uint32_t frames = 0;
+    uint32_t completed = 0;
   };
   using FrameCallback = std::function<void(const FrameStatus &)>;
 
+  struct StreamThreadStatus {
+    uint32_t streams = 0;
+    uint32_t activeStreams = 0;
+    uint64_t layers = 0;
+  };
+
   using LoggerCallback = std::function<void(Logger::MessagePtr &&msg)>;
 
 private:
@@ -62,12 +70,26 @@ public:
   bool startPcap();
   bool stopPcap();
 
-  void setDisplayFilter(const std::string &name, const std::string &body);
+  void setDisplayFilter(const std::string &name, const std::string &body,
+                        const std::string &program = std::string());
   std::vector<uint32_t> getFilteredFrames(const std::string &name,
                                           uint32_t offset,
                                           uint32_t length) const;
+  std::vector<uint32_t>
+  getFilteredFrames(const std::vector<std::string> &names, FilterOperator op,
+                    uint32_t offset, uint32_t length) const;
+  void setFilterLimit(const std::string &name, uint32_t limit);
+  std::vector<uint32_t> getNearestFrames(const std::string &name,
+                                         uint32_t index, uint32_t length);
+  std::vector<uint32_t> getIndexedFrames(const std::string &name,
+                                         const Variant &value,
+                                         uint32_t offset,
+                                         uint32_t length) const;
+  std::vector<uint32_t> getFramesByTime(const Timestamp &begin,
+                                        const Timestamp &end) const;
   std::vector<const FrameView *> getFrames(uint32_t offset,
                                            uint32_t length) const;
+  std::vector<StreamThreadStatus> getStreamThreadStatus() const;
 
   void analyze(const std::vector<RawFrame> &rawFrames);
 
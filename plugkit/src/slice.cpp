@@ -1,4 +1,5 @@
 #include "slice.h"
+#include "byte_order.hpp"
 #include <algorithm>
 
 namespace plugkit {
@@ -17,7 +18,7 @@ template <class T> T readLE(const Slice &slice, size_t offset, Token *err) {
     }
     return T();
   }
-  return *reinterpret_cast<const T *>(slice.begin + offset);
+  return loadLE<T>(slice.begin + offset);
 }
 
 template <class T> T readBE(const Slice &slice, size_t offset, Token *err) {
@@ -27,10 +28,7 @@ template <class T> T readBE(const Slice &slice, size_t offset, Token *err) {
     }
     return T();
   }
-  char data[sizeof(T)];
-  std::reverse_copy(slice.begin + offset, slice.begin + offset + sizeof(T),
-                    data);
-  return *reinterpret_cast<const T *>(data);
+  return loadBE<T>(slice.begin + offset);
 }
 } // namespace
 
@@ -6,8 +6,10 @@
 
 #include "context.hpp"
 #include "dissector.h"
+#include "flow_table.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <unordered_map>
 #include <unordered_set>
@@ -18,7 +20,36 @@ namespace plugkit {
 namespace {
 struct WorkerContext {
   std::vector<std::pair<const Dissector *, Worker>> list;
+
+  // Bytes reported by each worker through Context_setWorkerMemory().
+  std::vector<size_t> memory;
+  size_t size = 0;
+
+  size_t footprint() const {
+    size_t bytes = sizeof(WorkerContext);
+    for (size_t retained : memory) {
+      bytes += sizeof(std::pair<const Dissector *, Worker>) + sizeof(size_t) +
+               retained;
+    }
+    return bytes;
+  }
 };
+
+struct WorkerKey {
+  Token id;
+  uint32_t bucket;
+};
+
+struct StreamKey {
+  Token id;
+  uint32_t worker;
+};
+
+// Each thread keeps one set of workers per layer id and bucket, so a worker
+// sees many flows and keeps its own per-flow state. The pool picks the
+// thread by `worker % threads`, and the buckets take the top bits of the
+// flow hash instead.
+const uint32_t bucketBits = 4;
 } // namespace
 
 class StreamDissectorThread::Private {
@@ -27,13 +58,18 @@ public:
   ~Private();
   void analyze(Layer *layer, bool subLayer, std::vector<Layer *> *nextLayers,
                std::vector<Layer *> *nextSubLayers);
+  void analyzeWorker(WorkerContext *context, size_t index, Layer *layer);
+  static void destroyWorkers(void *value, void *data);
 
 public:
   Queue<Layer *> queue;
   std::vector<Dissector> dissectors;
   double confidenceThreshold;
-  using IdMap = std::unordered_map<uint32_t, WorkerContext>;
-  std::unordered_map<Token, IdMap> workers;
+  FlowTable *workers = nullptr;
+  FlowTable *flows = nullptr;
+  std::atomic<uint32_t> streams;
+  std::atomic<uint32_t> activeStreams;
+  std::atomic<uint64_t> layers;
 
   Context ctx;
   const Variant options;
@@ -44,8 +80,39 @@ StreamDissectorThread::Private::Private(const Variant &options,
                                         const Callback &callback)
     : options(options), callback(callback) {
   ctx.options = options;
+  std::atomic_init(&streams, 0u);
+  std::atomic_init(&activeStreams, 0u);
+  std::atomic_init(&layers, static_cast<uint64_t>(0));
+
+  workers = FlowTable_create(destroyWorkers, this);
+  FlowTable_setIdleTimeout(
+      workers, options["_"]["streamIdleTimeout"].uint64Value(0) * 1000000000);
+  FlowTable_setMemoryLimit(
+      workers, options["_"]["streamMemoryLimit"].uint64Value(0) * 1024 * 1024);
+
+  // Only counts the streams, so every value is `this`.
+  flows = FlowTable_create(nullptr, nullptr);
+  FlowTable_setIdleTimeout(
+      flows, options["_"]["streamIdleTimeout"].uint64Value(0) * 1000000000);
+  FlowTable_setMemoryLimit(
+      flows, options["_"]["streamMemoryLimit"].uint64Value(0) * 1024 * 1024);
+}
+
+StreamDissectorThread::Private::~Private() {
+  FlowTable_destroy(workers);
+  FlowTable_destroy(flows);
+}
+
+void StreamDissectorThread::Private::destroyWorkers(void *value, void *data) {
+  Private *d = static_cast<Private *>(data);
+  WorkerContext *context = static_cast<WorkerContext *>(value);
+  for (const auto &pair : context->list) {
+    if (pair.first->destroyWorker) {
+      pair.first->destroyWorker(&d->ctx, pair.first, pair.second);
+    }
+  }
+  delete context;
 }
-StreamDissectorThread::Private::~Private() {}
 
 StreamDissectorThread::StreamDissectorThread(const Variant &options,
                                              const Callback &callback)
@@ -75,7 +142,27 @@ void StreamDissectorThread::Private::analyze(
 
   Token id = layer->id();
   dissectedIds.insert(id);
-  auto &streamWorkers = workers[id][layer->worker()];
+
+  const uint64_t time = Layer_timestamp(layer);
+  if (!subLayer) {
+    const StreamKey stream = {id, layer->worker()};
+    const char *streamKey = reinterpret_cast<const char *>(&stream);
+    if (!FlowTable_find(flows, streamKey, sizeof(stream), time)) {
+      FlowTable_insert(flows, streamKey, sizeof(stream), this, sizeof(stream),
+                       time);
+      streams.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  const WorkerKey key = {id, layer->worker() >> (32 - bucketBits)};
+  WorkerContext *context = static_cast<WorkerContext *>(FlowTable_find(
+      workers, reinterpret_cast<const char *>(&key), sizeof(key), time));
+  if (!context) {
+    context = new WorkerContext();
+    FlowTable_insert(workers, reinterpret_cast<const char *>(&key),
+                     sizeof(key), context, sizeof(WorkerContext), time);
+  }
+  auto &streamWorkers = *context;
 
   if (streamWorkers.list.empty()) {
     std::vector<const Dissector *> workerDissectors;
@@ -107,18 +194,22 @@ void StreamDissectorThread::Private::analyze(
         worker = diss->createWorker(&ctx, diss);
       }
       streamWorkers.list.push_back(std::make_pair(diss, worker));
+      streamWorkers.memory.push_back(0);
     }
   }
 
   if (subLayer) {
-    for (const auto &pair : streamWorkers.list) {
+    for (size_t i = 0; i < streamWorkers.list.size(); ++i) {
       if (Layer *parent = layer->parent()) {
-        pair.first->analyze(&ctx, pair.first, pair.second, parent);
+        analyzeWorker(context, i, parent);
       }
     }
+    if (Layer *parent = layer->parent()) {
+      parent->seal();
+    }
   } else {
-    for (const auto &pair : streamWorkers.list) {
-      pair.first->analyze(&ctx, pair.first, pair.second, layer);
+    for (size_t i = 0; i < streamWorkers.list.size(); ++i) {
+      analyzeWorker(context, i, layer);
       for (Layer *childLayer : layer->layers()) {
         if (childLayer->confidence() >= confidenceThreshold) {
           auto it = dissectedIds.find(childLayer->id());
@@ -128,6 +219,7 @@ void StreamDissectorThread::Private::analyze(
         }
       }
     }
+    layer->seal();
 
     for (Layer *subLayer : layer->subLayers()) {
       if (subLayer->confidence() >= confidenceThreshold) {
@@ -139,6 +231,24 @@ void StreamDissectorThread::Private::analyze(
       }
     }
   }
+
+  // Charges the state retained by the workers, so that streamMemoryLimit
+  // bounds it. The context has just been used and is evicted last.
+  size_t size = streamWorkers.footprint();
+  if (size != streamWorkers.size) {
+    streamWorkers.size = size;
+    FlowTable_setSize(workers, reinterpret_cast<const char *>(&key),
+                      sizeof(key), size);
+  }
+}
+
+void StreamDissectorThread::Private::analyzeWorker(WorkerContext *context,
+                                                   size_t index,
+                                                   Layer *layer) {
+  const auto &pair = context->list[index];
+  ctx.workerMemory = context->memory[index];
+  pair.first->analyze(&ctx, pair.first, pair.second, layer);
+  context->memory[index] = ctx.workerMemory;
 }
 
 bool StreamDissectorThread::loop() {
@@ -149,12 +259,11 @@ bool StreamDissectorThread::loop() {
     return false;
 
   layers.resize(size);
+  d->layers.fetch_add(size, std::memory_order_relaxed);
 
-  uint32_t maxFrameIndex = 0;
+  std::vector<const Frame *> frames;
   for (const Layer *layer : layers) {
-    if (const Frame *frame = layer->frame()) {
-      maxFrameIndex = std::max(maxFrameIndex, frame->index());
-    }
+    frames.push_back(layer->frame());
   }
 
   std::vector<Layer *> subLayers;
@@ -179,18 +288,23 @@ bool StreamDissectorThread::loop() {
     subLayers.swap(nextSubLayers);
   }
 
-  d->callback(maxFrameIndex);
+  d->activeStreams.store(FlowTable_size(d->flows),
+                         std::memory_order_relaxed);
+  d->callback(frames.data(), frames.size());
   return true;
 }
 
 void StreamDissectorThread::exit() {
+  FlowTable_destroy(d->workers);
+  d->workers = nullptr;
+  FlowTable_destroy(d->flows);
+  d->flows = nullptr;
   for (auto &diss : d->dissectors) {
     if (diss.terminate) {
       diss.terminate(&d->ctx, &diss);
     }
   }
   d->dissectors.clear();
-  d->workers.clear();
 }
 
 void StreamDissectorThread::push(Layer **begin, size_t size) {
@@ -198,4 +312,16 @@ void StreamDissectorThread::push(Layer **begin, size_t size) {
 }
 
 void StreamDissectorThread::stop() { d->queue.close(); }
+
+uint32_t StreamDissectorThread::streams() const {
+  return d->streams.load(std::memory_order_relaxed);
+}
+
+uint32_t StreamDissectorThread::activeStreams() const {
+  return d->activeStreams.load(std::memory_order_relaxed);
+}
+
+uint64_t StreamDissectorThread::layers() const {
+  return d->layers.load(std::memory_order_relaxed);
+}
 } // namespace plugkit
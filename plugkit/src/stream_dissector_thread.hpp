@@ -16,7 +16,7 @@ struct Dissector;
 
 class StreamDissectorThread final : public WorkerThread {
 public:
-  using Callback = std::function<void(uint32_t)>;
+  using Callback = std::function<void(const Frame **, size_t)>;
 
 public:
   StreamDissectorThread(const Variant &options, const Callback &callback);
@@ -27,6 +27,9 @@ public:
   void exit() override;
   void push(Layer **begin, size_t size);
   void stop();
+  uint32_t streams() const;
+  uint32_t activeStreams() const;
+  uint64_t layers() const;
 
 private:
   class Private;
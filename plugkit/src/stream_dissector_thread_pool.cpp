@@ -1,78 +1,95 @@
 #include "stream_dissector_thread_pool.hpp"
 #include "dissector.h"
 #include "frame.hpp"
-#include "frame_store.hpp"
-#include "frame_view.hpp"
 #include "layer.hpp"
 #include "stream_dissector_thread.hpp"
 #include "stream_logger.hpp"
 #include "variant.hpp"
-#include <array>
+#include <algorithm>
+#include <map>
+#include <mutex>
 #include <thread>
-#include <uv.h>
+#include <unordered_map>
 
 namespace plugkit {
 
+namespace {
+struct Batch {
+  uint32_t last = 0;
+  std::vector<std::vector<Layer *>> layers;
+};
+} // namespace
+
 class StreamDissectorThreadPool::Private {
 public:
-  Private(const Variant &options, const FrameStorePtr &store,
-          const Callback &callback);
+  Private(const Variant &options, const Callback &callback);
   ~Private();
-  uint32_t updateIndex(int thread, uint32_t pushed = 0, uint32_t dissected = 0);
+  bool hasStreamDissector(const Layer *layer) const;
+  void complete(const Frame **begin, size_t size);
 
 public:
   LoggerPtr logger = std::make_shared<StreamLogger>();
   std::vector<std::unique_ptr<StreamDissectorThread>> threads;
   std::vector<Dissector> dissectors;
-  std::thread thread;
-  std::vector<std::pair<uint32_t, uint32_t>> threadStats;
+  std::map<uint32_t, Batch> pending;
+  std::unordered_map<const Frame *, uint32_t> remaining;
+  uint32_t nextIndex = 1;
   std::mutex mutex;
   const Variant options;
-  const FrameStorePtr store;
   const Callback callback;
 };
 
 StreamDissectorThreadPool::Private::Private(const Variant &options,
-                                            const FrameStorePtr &store,
                                             const Callback &callback)
-    : options(options), store(store), callback(callback) {}
+    : options(options), callback(callback) {}
 
 StreamDissectorThreadPool::Private::~Private() {}
 
-uint32_t StreamDissectorThreadPool::Private::updateIndex(int thread,
-                                                         uint32_t pushed,
-                                                         uint32_t dissected) {
-  std::lock_guard<std::mutex> lock(mutex);
-
-  uint32_t min = 0;
-  if (threadStats[thread].first < pushed) {
-    threadStats[thread].first = pushed;
-  }
-  if (threadStats[thread].second < dissected) {
-    threadStats[thread].second = dissected;
-  }
-
-  for (const auto &pair : threadStats) {
-    if (min < pair.first) {
-      min = pair.first;
+bool StreamDissectorThreadPool::Private::hasStreamDissector(
+    const Layer *layer) const {
+  const auto &tags = layer->tags();
+  for (const auto &diss : dissectors) {
+    bool match = false;
+    for (const Token &token : diss.layerHints) {
+      if (token != Token_null()) {
+        if (std::find(tags.begin(), tags.end(), token) == tags.end()) {
+          match = false;
+          break;
+        }
+        match = true;
+      }
     }
+    if (match)
+      return true;
   }
+  for (const Layer *subLayer : layer->subLayers()) {
+    if (hasStreamDissector(subLayer))
+      return true;
+  }
+  return false;
+}
 
-  for (const auto &pair : threadStats) {
-    if (pair.first > pair.second) {
-      if (min > pair.second) {
-        min = pair.second;
+void StreamDissectorThreadPool::Private::complete(const Frame **begin,
+                                                  size_t size) {
+  std::vector<const Frame *> frames;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < size; ++i) {
+      auto it = remaining.find(begin[i]);
+      if (it != remaining.end() && --it->second == 0) {
+        frames.push_back(it->first);
+        remaining.erase(it);
       }
     }
   }
-
-  return min;
+  if (!frames.empty()) {
+    callback(frames.data(), frames.size());
+  }
 }
 
 StreamDissectorThreadPool::StreamDissectorThreadPool(const Variant &options,
-                                                     const FrameStorePtr &store,
                                                      const Callback &callback)
-    : d(new Private(options, store, callback)) {}
+    : d(new Private(options, callback)) {}
 
 StreamDissectorThreadPool::~StreamDissectorThreadPool() {
   for (const auto &thread : d->threads) {
@@ -81,9 +98,6 @@ StreamDissectorThreadPool::~StreamDissectorThreadPool() {
   for (const auto &thread : d->threads) {
     thread->join();
   }
-  d->store->close();
-  if (d->thread.joinable())
-    d->thread.join();
 }
 
 void StreamDissectorThreadPool::registerDissector(const Dissector &diss) {
@@ -95,7 +109,7 @@ void StreamDissectorThreadPool::setLogger(const LoggerPtr &logger) {
 }
 
 void StreamDissectorThreadPool::start() {
-  if (d->thread.joinable() || !d->threads.empty())
+  if (!d->threads.empty())
     return;
 
   int concurrency = d->options["_"]["concurrency"].uint64Value(0);
@@ -106,9 +120,8 @@ void StreamDissectorThreadPool::start() {
 
   for (int i = 0; i < concurrency; ++i) {
     auto dissectorThread = new StreamDissectorThread(
-        d->options, [this, i](uint32_t maxFrameIndex) {
-          uint32_t index = d->updateIndex(i, 0, maxFrameIndex);
-          d->callback(index);
+        d->options, [this](const Frame **begin, size_t size) {
+          d->complete(begin, size);
         });
     for (const auto &diss : d->dissectors) {
       dissectorThread->pushStreamDissector(diss);
@@ -117,55 +130,106 @@ void StreamDissectorThreadPool::start() {
     d->threads.emplace_back(dissectorThread);
   }
 
-  d->threadStats.resize(d->threads.size());
-
   for (const auto &thread : d->threads) {
     thread->start();
   }
+}
 
-  d->thread = std::thread([this, concurrency]() {
-    size_t offset = 0;
-    std::array<const Frame *, 128> frames;
-    while (true) {
-      size_t size = d->store->dequeue(offset, frames.size(), &frames.front());
-      if (size == 0)
-        return;
-      offset += size;
-
-      std::function<std::vector<Layer *>(Layer *)> findStreamedLayers =
-          [&findStreamedLayers](Layer *layer) -> std::vector<Layer *> {
-
-        std::vector<Layer *> layers;
-        if (layer->layers().empty()) {
-          layers.push_back(layer);
-        } else {
-          for (const auto &child : layer->layers()) {
-            const auto &childList = findStreamedLayers(child);
-            layers.insert(layers.begin(), childList.begin(), childList.end());
-          }
-        }
-        return layers;
-      };
-
-      std::vector<std::vector<Layer *>> layerMap;
-      layerMap.resize(concurrency);
-      for (size_t i = 0; i < size; ++i) {
-        const auto &layers = findStreamedLayers(frames[i]->rootLayer());
-        for (Layer *layer : layers) {
-          int thread = layer->worker() % d->threads.size();
-          layerMap[thread].push_back(layer);
-          if (const Frame *frame = layer->frame()) {
-            d->updateIndex(thread, frame->index(), 0);
-          }
+void StreamDissectorThreadPool::push(Frame **begin, size_t size) {
+  if (size == 0)
+    return;
+
+  std::vector<Frame *> frames(begin, begin + size);
+  if (d->threads.empty()) {
+    std::vector<const Frame *> completed(frames.begin(), frames.end());
+    d->callback(completed.data(), completed.size());
+    return;
+  }
+
+  std::sort(frames.begin(), frames.end(), [](const Frame *a, const Frame *b) {
+    return a->index() < b->index();
+  });
+
+  // Group the leaf layers by their owning thread outside the lock.
+  // Frames are split into runs of consecutive indices so that each run
+  // can be handed off as soon as every preceding frame has been.
+  // Leaf layers without a matching stream dissector are not handed off;
+  // a frame without any is complete as soon as it has been dissected.
+  std::vector<std::pair<uint32_t, Batch>> batches;
+  std::vector<std::pair<const Frame *, uint32_t>> counts;
+  std::vector<const Frame *> completed;
+  std::vector<Layer *> stack;
+  for (Frame *frame : frames) {
+    if (batches.empty() || batches.back().second.last + 1 != frame->index()) {
+      Batch batch;
+      batch.layers.resize(d->threads.size());
+      batches.emplace_back(frame->index(), std::move(batch));
+    }
+    Batch &batch = batches.back().second;
+    batch.last = frame->index();
+
+    std::vector<const Layer *> streamLayers;
+    if (Layer *root = frame->rootLayer()) {
+      stack.push_back(root);
+    }
+    while (!stack.empty()) {
+      Layer *layer = stack.back();
+      stack.pop_back();
+      const auto &children = layer->layers();
+      if (children.empty()) {
+        if (d->hasStreamDissector(layer)) {
+          size_t thread = layer->worker() % d->threads.size();
+          batch.layers[thread].push_back(layer);
+          streamLayers.push_back(layer);
         }
+      } else {
+        stack.insert(stack.end(), children.rbegin(), children.rend());
       }
-      for (size_t i = 0; i < layerMap.size(); ++i) {
-        auto &layer = layerMap[i];
-        if (!layer.empty()) {
-          d->threads[i]->push(&layer.front(), layer.size());
+    }
+
+    if (streamLayers.empty()) {
+      completed.push_back(frame);
+    } else {
+      counts.emplace_back(frame, streamLayers.size());
+      frame->setStreamLayers(streamLayers);
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(d->mutex);
+    d->remaining.insert(counts.begin(), counts.end());
+    for (auto &pair : batches) {
+      d->pending.insert(std::move(pair));
+    }
+    auto it = d->pending.begin();
+    for (; it != d->pending.end() && it->first == d->nextIndex;
+         it = d->pending.erase(it)) {
+      Batch &batch = it->second;
+      for (size_t i = 0; i < batch.layers.size(); ++i) {
+        auto &layers = batch.layers[i];
+        if (!layers.empty()) {
+          d->threads[i]->push(&layers.front(), layers.size());
         }
       }
+      d->nextIndex = batch.last + 1;
     }
-  });
+  }
+
+  if (!completed.empty()) {
+    d->callback(completed.data(), completed.size());
+  }
+}
+
+std::vector<StreamDissectorThreadPool::ThreadStatus>
+StreamDissectorThreadPool::threadStatus() const {
+  std::vector<ThreadStatus> status;
+  for (const auto &thread : d->threads) {
+    ThreadStatus stat;
+    stat.streams = thread->streams();
+    stat.activeStreams = thread->activeStreams();
+    stat.layers = thread->layers();
+    status.push_back(stat);
+  }
+  return status;
 }
 } // namespace plugkit
@@ -13,24 +13,28 @@ using LoggerPtr = std::shared_ptr<Logger>;
 
 class Frame;
 
-class FrameStore;
-using FrameStorePtr = std::shared_ptr<FrameStore>;
-
 struct Variant;
 
 struct Dissector;
 
 class StreamDissectorThreadPool final {
 public:
-  using Callback = std::function<void(uint32_t)>;
+  using Callback = std::function<void(const Frame **, size_t)>;
+
+  struct ThreadStatus {
+    uint32_t streams = 0;
+    uint32_t activeStreams = 0;
+    uint64_t layers = 0;
+  };
 
 public:
-  StreamDissectorThreadPool(const Variant &options, const FrameStorePtr &store,
-                            const Callback &callback);
+  StreamDissectorThreadPool(const Variant &options, const Callback &callback);
   ~StreamDissectorThreadPool();
   void registerDissector(const Dissector &diss);
   void start();
   void setLogger(const LoggerPtr &logger);
+  void push(Frame **begin, size_t size);
+  std::vector<ThreadStatus> threadStatus() const;
 
 private:
   StreamDissectorThreadPool(const StreamDissectorThreadPool &) = delete;
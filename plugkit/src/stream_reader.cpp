@@ -4,13 +4,123 @@
 #include <cstring>
 #include <vector>
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PLUGKIT_STREAM_READER_SSE2
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(PLUGKIT_OS_WIN)
+#include <intrin.h>
+#endif
+
 namespace plugkit {
 
 struct StreamReader {
   std::vector<Slice> slices;
+
+  // offsets[i] is the stream offset of slices[i].
+  std::vector<size_t> offsets;
   size_t length = 0;
+  size_t cursor = 0;
 };
 
+namespace {
+
+// Returns the offset of the first byte which has not been discarded.
+size_t head(const StreamReader *reader) {
+  return reader->offsets.empty() ? reader->length : reader->offsets.front();
+}
+
+// Returns the index of the slice which contains offset.
+// offset must be in [head(reader), reader->length).
+size_t locate(const StreamReader *reader, size_t offset) {
+  return std::upper_bound(reader->offsets.begin(), reader->offsets.end(),
+                          offset) -
+         reader->offsets.begin() - 1;
+}
+
+#if defined(PLUGKIT_STREAM_READER_SSE2)
+int countTrailingZeros(uint32_t mask) {
+#if defined(PLUGKIT_OS_WIN)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return index;
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+// Returns the first position p in [begin, end) where the needle fits before
+// p + length and matches, or nullptr. Candidates are filtered by the first
+// and the last byte of the needle at once.
+const char *find(const char *begin, const char *end, const char *data,
+                 size_t length) {
+  const size_t last = length - 1;
+  const char *p = begin;
+#if defined(__AVX2__)
+  const __m256i first32 = _mm256_set1_epi8(data[0]);
+  const __m256i last32 = _mm256_set1_epi8(data[last]);
+  for (; p + 32 <= end; p += 32) {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    __m256i b =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + last));
+    uint32_t mask = _mm256_movemask_epi8(_mm256_and_si256(
+        _mm256_cmpeq_epi8(a, first32), _mm256_cmpeq_epi8(b, last32)));
+    for (; mask != 0; mask &= mask - 1) {
+      const char *candidate = p + countTrailingZeros(mask);
+      if (length <= 2 || std::memcmp(candidate + 1, data + 1, length - 2) == 0)
+        return candidate;
+    }
+  }
+#endif
+#if defined(PLUGKIT_STREAM_READER_SSE2)
+  const __m128i first16 = _mm_set1_epi8(data[0]);
+  const __m128i last16 = _mm_set1_epi8(data[last]);
+  for (; p + 16 <= end; p += 16) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + last));
+    uint32_t mask = _mm_movemask_epi8(
+        _mm_and_si128(_mm_cmpeq_epi8(a, first16), _mm_cmpeq_epi8(b, last16)));
+    for (; mask != 0; mask &= mask - 1) {
+      const char *candidate = p + countTrailingZeros(mask);
+      if (length <= 2 || std::memcmp(candidate + 1, data + 1, length - 2) == 0)
+        return candidate;
+    }
+  }
+#endif
+  for (; p < end; ++p) {
+    if (p[0] == data[0] && p[last] == data[last] &&
+        (length <= 2 || std::memcmp(p + 1, data + 1, length - 2) == 0))
+      return p;
+  }
+  return nullptr;
+}
+
+// Compares the needle with the bytes starting at pos in the given slice and
+// continuing into the following slices.
+bool matchesAcross(const StreamReader *reader, size_t index, const char *pos,
+                   const char *data, size_t length) {
+  for (; index < reader->slices.size(); ++index) {
+    const Slice &slice = reader->slices[index];
+    if (pos == nullptr) {
+      pos = slice.begin;
+    }
+    size_t len = std::min(length, static_cast<size_t>(slice.end - pos));
+    if (std::memcmp(pos, data, len) != 0)
+      return false;
+    data += len;
+    length -= len;
+    if (length == 0)
+      return true;
+    pos = nullptr;
+  }
+  return false;
+}
+} // namespace
+
 StreamReader *StreamReader_create() { return new StreamReader(); }
 
 void StreamReader_destroy(StreamReader *reader) { delete reader; }
@@ -20,7 +130,10 @@ size_t StreamReader_length(const StreamReader *reader) {
 }
 
 void StreamReader_addSlice(StreamReader *reader, Slice slice) {
+  if (Slice_length(slice) == 0)
+    return;
   reader->slices.push_back(slice);
+  reader->offsets.push_back(reader->length);
   reader->length += Slice_length(slice);
 }
 
@@ -32,96 +145,126 @@ void StreamReader_addPayload(StreamReader *reader, const Payload *payload) {
 
 size_t StreamReader_search(StreamReader *reader, const char *data,
                            size_t length, size_t offset) {
-  if (reader->slices.empty() || length == 0) {
+  offset = std::max(offset, head(reader));
+  if (length == 0 || offset >= reader->length ||
+      reader->length - offset < length) {
     return 0;
   }
-  size_t beginOffset = 0;
-  size_t begin = 0;
-  for (; begin < reader->slices.size() &&
-         (beginOffset += Slice_length(reader->slices[begin])) <= offset;
-       ++begin)
-    ;
-  size_t beginLen = Slice_length(reader->slices[begin]);
-  beginOffset -= beginLen;
-  size_t front = beginOffset;
-
-  std::unique_ptr<char[]> buf(new char[length]);
-
-  for (size_t i = begin; i < reader->slices.size(); ++i) {
+  for (size_t i = locate(reader, offset); i < reader->slices.size(); ++i) {
     const Slice &slice = reader->slices[i];
+    size_t sliceOffset = reader->offsets[i];
+    if (reader->length - sliceOffset < length)
+      break;
+    const char *begin = slice.begin;
+    if (sliceOffset < offset) {
+      begin += offset - sliceOffset;
+    }
+
+    // Matches which fit in the slice.
     size_t sliceLen = Slice_length(slice);
-    size_t index = 0;
-    if (i == begin) {
-      index = offset - beginOffset;
+    const char *inner = begin;
+    if (sliceLen >= length) {
+      inner = std::max(begin, slice.end - (length - 1));
+      if (const char *found = find(begin, inner, data, length)) {
+        return sliceOffset + (found - slice.begin) + length;
+      }
     }
-    for (; index < sliceLen - length + 1; ++index) {
-      if (slice.begin[index] == data[0]) {
-        const Slice &window =
-            StreamReader_read(reader, &buf[0], length, front + index);
-        if (Slice_length(window) == length &&
-            std::memcmp(window.begin, data, length) == 0) {
-          front += index;
-          return front + length;
-        }
+
+    // Matches which span the following slices.
+    for (const char *p = inner; p < slice.end; ++p) {
+      if (sliceOffset + (p - slice.begin) + length > reader->length)
+        break;
+      if (*p == data[0] && matchesAcross(reader, i, p, data, length)) {
+        return sliceOffset + (p - slice.begin) + length;
       }
     }
-    front += sliceLen;
   }
-
   return 0;
 }
 
 Slice StreamReader_read(StreamReader *reader, char *buffer, size_t length,
                         size_t offset) {
-  if (reader->slices.empty()) {
+  if (offset < head(reader) || offset >= reader->length) {
     return Slice{buffer, buffer};
   }
-  size_t beginOffset = 0;
-  size_t begin = 0;
-  for (; begin < reader->slices.size() &&
-         (beginOffset += Slice_length(reader->slices[begin])) <= offset;
-       ++begin) {
-  };
-  if (beginOffset <= offset) {
-    return Slice{buffer, buffer};
+  size_t begin = locate(reader, offset);
+  length = std::min(length, reader->length - offset);
+  const char *data =
+      reader->slices[begin].begin + (offset - reader->offsets[begin]);
+
+  const char *end = reader->slices[begin].end;
+  for (size_t i = begin + 1; static_cast<size_t>(end - data) < length &&
+                             i < reader->slices.size() &&
+                             reader->slices[i].begin == end;
+       ++i) {
+    end = reader->slices[i].end;
   }
-  beginOffset -= Slice_length(reader->slices[begin]);
-  size_t endOffset = beginOffset;
-  size_t end = begin;
-  for (; end < reader->slices.size() &&
-         (endOffset += Slice_length(reader->slices[end])) < offset + length;
-       ++end)
-    ;
-  bool continuous = true;
-  for (size_t i = begin; i < end; ++i) {
-    if (reader->slices[i].end != reader->slices[i + 1].begin) {
-      if (!buffer) {
-        const char *data = reader->slices[begin].begin + (offset - beginOffset);
-        return Slice{data, reader->slices[i].end};
-      }
-      continuous = false;
-      break;
-    }
+  if (static_cast<size_t>(end - data) >= length) {
+    return Slice{data, data + length};
   }
-  size_t buflen = std::min(length, endOffset - beginOffset);
-  if (continuous) {
-    const char *data = reader->slices[begin].begin + (offset - beginOffset);
-    return Slice{data, data + buflen};
+  if (!buffer) {
+    return Slice{data, end};
   }
+
   char *dst = buffer;
-  for (size_t i = begin; i <= end; ++i) {
-    Slice slice = reader->slices[i];
-    if (i == begin) {
-      slice.begin += (offset - beginOffset);
-    }
-    size_t capacity = buffer + buflen - dst;
-    size_t sliceLen = Slice_length(slice);
-    if (sliceLen > capacity) {
-      sliceLen = capacity;
-    }
+  Slice slice = {data, reader->slices[begin].end};
+  for (size_t i = begin;;) {
+    size_t sliceLen = std::min(Slice_length(slice),
+                               static_cast<size_t>(buffer + length - dst));
     std::memcpy(dst, slice.begin, sliceLen);
     dst += sliceLen;
+    if (dst == buffer + length)
+      break;
+    slice = reader->slices[++i];
+  }
+  return Slice{buffer, buffer + length};
+}
+
+void StreamReader_discard(StreamReader *reader, size_t offset) {
+  size_t count = 0;
+  while (count < reader->slices.size() &&
+         reader->offsets[count] + Slice_length(reader->slices[count]) <=
+             offset) {
+    ++count;
+  }
+  reader->slices.erase(reader->slices.begin(), reader->slices.begin() + count);
+  reader->offsets.erase(reader->offsets.begin(),
+                        reader->offsets.begin() + count);
+}
+
+size_t StreamReader_tell(const StreamReader *reader) { return reader->cursor; }
+
+size_t StreamReader_advance(StreamReader *reader, size_t length) {
+  length = std::min(length, reader->length - reader->cursor);
+  reader->cursor += length;
+  return length;
+}
+
+Slice StreamReader_peek(StreamReader *reader, char *buffer, size_t length) {
+  return StreamReader_read(reader, buffer, length, reader->cursor);
+}
+
+Slice StreamReader_readUntil(StreamReader *reader, char *buffer, size_t length,
+                             const char *data, size_t dataLength,
+                             size_t *lineLength) {
+  size_t end = StreamReader_search(reader, data, dataLength, reader->cursor);
+  size_t offset = reader->cursor;
+  size_t len = (end == 0) ? 0 : end - dataLength - offset;
+  if (lineLength) {
+    *lineLength = len;
+  }
+  if (end == 0) {
+    return Slice{nullptr, nullptr};
+  }
+
+  Slice slice = StreamReader_read(reader, nullptr, len, offset);
+  if (Slice_length(slice) < len) {
+    if (len > length) {
+      return Slice{nullptr, nullptr};
+    }
+    slice = StreamReader_read(reader, buffer, len, offset);
   }
-  return Slice{buffer, buffer + buflen};
+  reader->cursor = end;
+  return slice;
 }
 } // namespace plugkit
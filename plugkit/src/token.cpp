@@ -1,9 +1,8 @@
 #include "token.h"
+#include <atomic>
+#include <cstddef>
 #include <cstring>
-#include <mutex>
-#include <string>
-#include <unordered_map>
-#include <vector>
+#include <new>
 
 namespace plugkit {
 
@@ -15,11 +14,106 @@ extern "C" {
 #undef register
 }
 
-thread_local std::unordered_map<std::string, Token> localMap;
-thread_local std::unordered_map<Token, const char *> localReverseMap;
-std::unordered_map<std::string, Token> map;
-std::unordered_map<Token, const char *> reverseMap;
-std::mutex mutex;
+// Dynamic tokens are interned in an append-only hash table shared by all
+// threads. Entries are never removed, so a lookup only follows pointers
+// published with release semantics and never blocks.
+struct Entry {
+  const Entry *next;
+  uint32_t hash;
+  uint32_t length;
+  Token token;
+  char data[1];
+};
+
+const size_t bucketBits = 14;
+const size_t segmentBits = 10;
+const size_t maxSegments = 22;
+const size_t chunkSize = 64 * 1024;
+const Token firstToken = Token_keyCount_ + 1;
+
+std::atomic<const Entry *> buckets[1 << bucketBits];
+
+// Token -> entry, stored in segments which double in size so that the
+// array never moves.
+std::atomic<std::atomic<const Entry *> *> segments[maxSegments];
+std::atomic<Token> nextToken(firstToken);
+
+// Each thread copies its strings into its own chunks, which are never
+// freed since tokens live as long as the process.
+thread_local char *chunkBegin = nullptr;
+thread_local char *chunkEnd = nullptr;
+
+Entry *allocate(const char *str, uint32_t length, uint32_t hash) {
+  size_t size = offsetof(Entry, data) + length + 1;
+  size = (size + alignof(Entry) - 1) & ~(alignof(Entry) - 1);
+  if (static_cast<size_t>(chunkEnd - chunkBegin) < size) {
+    size_t capacity = (size > chunkSize) ? size : chunkSize;
+    chunkBegin = new char[capacity];
+    chunkEnd = chunkBegin + capacity;
+  }
+  Entry *entry = new (chunkBegin) Entry();
+  chunkBegin += size;
+  entry->hash = hash;
+  entry->length = length;
+  std::memcpy(entry->data, str, length);
+  entry->data[length] = '\0';
+  return entry;
+}
+
+// Gives back the last allocation of the thread.
+void deallocate(Entry *entry) { chunkBegin = reinterpret_cast<char *>(entry); }
+
+uint32_t fnv1a(const char *str, size_t length) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < length; ++i) {
+    hash = (hash ^ static_cast<unsigned char>(str[i])) * 16777619u;
+  }
+  return hash;
+}
+
+const Entry *find(const Entry *entry, const Entry *last, const char *str,
+                  uint32_t length, uint32_t hash) {
+  for (; entry != last; entry = entry->next) {
+    if (entry->hash == hash && entry->length == length &&
+        std::memcmp(entry->data, str, length) == 0)
+      return entry;
+  }
+  return nullptr;
+}
+
+// Segment i holds the tokens [firstToken + base(i), firstToken + base(i+1)).
+size_t segmentBase(size_t segment) {
+  return ((static_cast<size_t>(1) << segment) - 1) << segmentBits;
+}
+
+std::atomic<const Entry *> *slot(Token token, bool create) {
+  size_t index = token - firstToken;
+  size_t segment = 0;
+  while (segment < maxSegments && segmentBase(segment + 1) <= index) {
+    ++segment;
+  }
+  if (segment == maxSegments)
+    return nullptr;
+
+  std::atomic<const Entry *> *slots =
+      segments[segment].load(std::memory_order_acquire);
+  if (!slots) {
+    if (!create)
+      return nullptr;
+    size_t size = static_cast<size_t>(1) << (segment + segmentBits);
+    std::atomic<const Entry *> *created = new std::atomic<const Entry *>[size];
+    for (size_t i = 0; i < size; ++i) {
+      created[i].store(nullptr, std::memory_order_relaxed);
+    }
+    if (segments[segment].compare_exchange_strong(slots, created,
+                                                  std::memory_order_acq_rel)) {
+      slots = created;
+    } else {
+      delete[] created;
+    }
+  }
+  return &slots[index - segmentBase(segment)];
+}
 } // namespace
 
 Token Token_literal_(const char *str, size_t length) {
@@ -27,65 +121,55 @@ Token Token_literal_(const char *str, size_t length) {
     return Token_null();
   }
 
-  if (length <= MAX_WORD_LENGTH && length >= MIN_WORD_LENGTH) {
-    unsigned int key = hash(str, length);
-    if (key <= MAX_HASH_VALUE) {
-      const char *s = wordlist[key];
-      if (strcmp(str, s) == 0) {
-        return key + 1;
-      }
-    }
+  if (const TokenKeyword_ *keyword = Token_keyword_(str, length)) {
+    return keyword->token;
   }
 
-  // suppress warnings
-  if (false) {
-    in_word_set(nullptr, 0);
+  uint32_t hash = fnv1a(str, length);
+  std::atomic<const Entry *> &bucket =
+      buckets[hash & ((1 << bucketBits) - 1)];
+  const Entry *head = bucket.load(std::memory_order_acquire);
+  if (const Entry *entry = find(head, nullptr, str, length, hash)) {
+    return entry->token;
   }
 
-  auto it = localMap.find(str);
-  if (it != localMap.end()) {
-    return it->second;
+  Entry *entry = allocate(str, static_cast<uint32_t>(length), hash);
+  entry->token = nextToken.fetch_add(1, std::memory_order_relaxed);
+  std::atomic<const Entry *> *reverse = slot(entry->token, true);
+  if (!reverse) {
+    deallocate(entry);
+    return Token_null();
   }
+  reverse->store(entry, std::memory_order_release);
 
-  Token id;
-  char *data = new char[length + 1]();
-  {
-    std::lock_guard<std::mutex> lock(mutex);
-    const std::string &key = str;
-    auto it = map.find(key);
-    if (it != map.end()) {
-      localMap.insert(*it);
-      return it->second;
+  entry->next = head;
+  while (!bucket.compare_exchange_weak(head, entry,
+                                       std::memory_order_release,
+                                       std::memory_order_acquire)) {
+    // Another thread may have added the same string in the meantime. The
+    // token reserved for this entry is left unused.
+    if (const Entry *found = find(head, entry->next, str, length, hash)) {
+      reverse->store(nullptr, std::memory_order_relaxed);
+      deallocate(entry);
+      return found->token;
     }
-    id = map.size() + 1 + MAX_HASH_VALUE + 1;
-    map.emplace(key, id);
-    key.copy(data, length);
-    reverseMap.emplace(id, data);
+    entry->next = head;
   }
-  localMap.emplace(data, id);
-  localReverseMap.emplace(id, data);
-  return id;
+  return entry->token;
 }
 
 const char *Token_string(Token token) {
   if (token == Token_null()) {
     return "";
   }
-  if (token <= MAX_HASH_VALUE + 1) {
-    return wordlist[token - 1];
+  if (token < firstToken) {
+    return Token_keywords_[token - 1];
   }
-  {
-    auto it = localReverseMap.find(token);
-    if (it != localReverseMap.end()) {
-      return it->second;
+  if (std::atomic<const Entry *> *reverse = slot(token, false)) {
+    if (const Entry *entry = reverse->load(std::memory_order_acquire)) {
+      return entry->data;
     }
   }
-  std::lock_guard<std::mutex> lock(mutex);
-  auto it = reverseMap.find(token);
-  if (it != reverseMap.end()) {
-    localReverseMap.insert(*it);
-    return it->second;
-  }
   return "";
 }
 } // namespace plugkit
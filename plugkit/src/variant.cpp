@@ -1,17 +1,35 @@
 #include "variant.hpp"
 #include "plugkit_module.hpp"
+#include <cstring>
 #include <iomanip>
 #include <nan.h>
 #include <sstream>
-#include <unordered_map>
 #include <uv.h>
 
 namespace plugkit {
 
 namespace {
 
+const Variant nullVariant;
 const Variant::Array nullArray;
 const Variant::Map nullMap;
+
+void release(Variant *var) {
+  switch (var->type()) {
+  case Variant::TYPE_STRING:
+    if (var->tag() == 0) {
+      delete var->d.str;
+    }
+    break;
+  case Variant::TYPE_ARRAY:
+    delete var->d.array;
+    break;
+  case Variant::TYPE_MAP:
+    delete var->d.map;
+    break;
+  default:;
+  }
+}
 } // namespace
 
 void Variant::init(v8::Isolate *isolate) {
@@ -52,10 +70,10 @@ Variant::Variant(double value) : type_(TYPE_DOUBLE) { d.double_ = value; }
 Variant::Variant(const std::string &str) : type_(TYPE_STRING) {
   if (str.empty()) {
     d.str = nullptr;
-  } else if (str.size() < sizeof(d.str)) {
+  } else if (str.size() < sizeof(d.chars)) {
     type_ = TYPE_STRING | (str.size() << 4);
-    d.str = nullptr;
-    str.copy(reinterpret_cast<char *>(&d.str), sizeof(d.str));
+    std::memset(d.chars, 0, sizeof(d.chars));
+    str.copy(d.chars, sizeof(d.chars));
   } else {
     d.str = new std::shared_ptr<std::string>(new std::string(str));
   }
@@ -65,65 +83,58 @@ Variant::Variant(const Array &array) : type_(TYPE_ARRAY) {
   d.array = new Array(array);
 }
 
+Variant::Variant(Array &&array) : type_(TYPE_ARRAY) {
+  d.array = new Array(std::move(array));
+}
+
 Variant::Variant(const Map &map) : type_(TYPE_MAP) { d.map = new Map(map); }
 
-Variant::Variant(const Slice &slice) : type_(TYPE_SLICE) {
-  d.slice = new Slice(slice);
+Variant::Variant(Map &&map) : type_(TYPE_MAP) {
+  d.map = new Map(std::move(map));
 }
 
+Variant::Variant(const Slice &slice) : type_(TYPE_SLICE) { d.slice = slice; }
+
 Variant::Variant(const Timestamp &ts) : type_(TYPE_TIMESTAMP) {
-  d.ts = new Timestamp(ts);
+  d.ts = ts.time_since_epoch().count();
 }
 
-Variant::~Variant() {
+Variant::~Variant() { release(this); }
+
+Variant::Variant(const Variant &value) : type_(value.type_), d(value.d) {
   switch (type()) {
-  case Variant::TYPE_TIMESTAMP:
-    delete d.ts;
-    break;
   case Variant::TYPE_STRING:
-    if (tag() == 0) {
-      delete d.str;
+    if (tag() == 0 && d.str) {
+      d.str = new std::shared_ptr<std::string>(*value.d.str);
     }
     break;
-  case Variant::TYPE_SLICE:
-    delete d.slice;
-    break;
   case Variant::TYPE_ARRAY:
-    delete d.array;
+    d.array = new Array(*value.d.array);
     break;
   case Variant::TYPE_MAP:
-    delete d.map;
+    d.map = new Map(*value.d.map);
     break;
   default:;
   }
 }
 
-Variant::Variant(const Variant &value) { *this = value; }
+Variant::Variant(Variant &&value) noexcept : type_(value.type_), d(value.d) {
+  value.type_ = TYPE_NIL;
+}
 
 Variant &Variant::operator=(const Variant &value) {
-  this->type_ = value.type_;
-  this->d = value.d;
-  switch (this->type()) {
-  case Variant::TYPE_TIMESTAMP:
-    this->d.ts = new Timestamp(*value.d.ts);
-    break;
-  case Variant::TYPE_STRING:
-    if (value.d.str && tag() == 0) {
-      this->d.str = new std::shared_ptr<std::string>(*value.d.str);
-    } else {
-      this->d.str = value.d.str;
-    }
-    break;
-  case Variant::TYPE_SLICE:
-    this->d.slice = new Slice(*value.d.slice);
-    break;
-  case Variant::TYPE_ARRAY:
-    this->d.array = new Array(*value.d.array);
-    break;
-  case Variant::TYPE_MAP:
-    this->d.map = new Map(*value.d.map);
-    break;
-  default:;
+  if (this != &value) {
+    *this = Variant(value);
+  }
+  return *this;
+}
+
+Variant &Variant::operator=(Variant &&value) noexcept {
+  if (this != &value) {
+    release(this);
+    type_ = value.type_;
+    d = value.d;
+    value.type_ = TYPE_NIL;
   }
   return *this;
 }
@@ -251,12 +262,10 @@ double Variant::doubleValue(double defaultValue) const {
 std::string Variant::string(const std::string &defaultValue) const {
   switch (type()) {
   case TYPE_STRING:
-    if (d.str) {
-      if (tag() == 0) {
-        return **d.str;
-      } else {
-        return std::string(reinterpret_cast<const char *>(&d.str), tag());
-      }
+    if (tag() > 0) {
+      return std::string(d.chars, tag());
+    } else if (d.str) {
+      return **d.str;
     } else {
       return std::string();
     }
@@ -284,7 +293,7 @@ std::string Variant::string(const std::string &defaultValue) const {
 
 Timestamp Variant::timestamp(const Timestamp &defaultValue) const {
   if (isTimestamp()) {
-    return *d.ts;
+    return Timestamp(std::chrono::nanoseconds(d.ts));
   } else {
     return defaultValue;
   }
@@ -292,7 +301,7 @@ Timestamp Variant::timestamp(const Timestamp &defaultValue) const {
 
 Slice Variant::slice() const {
   if (isSlice()) {
-    return *d.slice;
+    return d.slice;
   } else {
     return Slice();
   }
@@ -314,12 +323,11 @@ const Variant::Map &Variant::map() const {
   }
 }
 
-Variant Variant::operator[](size_t index) const {
+const Variant &Variant::operator[](size_t index) const {
   if (type() == TYPE_ARRAY && index < d.array->size()) {
     return (*d.array)[index];
-  } else {
-    return Variant();
   }
+  return nullVariant;
 }
 
 Variant &Variant::operator[](size_t index) {
@@ -333,14 +341,14 @@ Variant &Variant::operator[](size_t index) {
   return null;
 }
 
-Variant Variant::operator[](const std::string &key) const {
+const Variant &Variant::operator[](const std::string &key) const {
   if (type() == TYPE_MAP) {
     auto it = d.map->find(key);
     if (it != d.map->end()) {
       return it->second;
     }
   }
-  return Variant();
+  return nullVariant;
 }
 
 Variant &Variant::operator[](const std::string &key) {
@@ -565,11 +573,10 @@ Variant Variant::getVariant(v8::Local<v8::Value> var) {
     auto obj = var.As<v8::Object>();
     auto keys = obj->GetOwnPropertyNames();
     Variant::Map map;
+    map.reserve(keys->Length());
     for (size_t i = 0; i < keys->Length(); ++i) {
       const auto keyObj = keys->Get(i);
-      const std::string &key = *Nan::Utf8String(keyObj);
-      const Variant &value = getVariant(obj->Get(keyObj));
-      map.emplace(key, value);
+      map.emplace(*Nan::Utf8String(keyObj), getVariant(obj->Get(keyObj)));
     }
     return map;
   }
@@ -619,11 +626,11 @@ double Variant_double(const Variant *var) {
 void Variant_setDouble(Variant *var, double value) { *var = Variant(value); }
 
 const char *Variant_string(const Variant *var) {
-  if (var && var->isString() && var->d.str) {
-    if (var->tag() == 0) {
+  if (var && var->isString()) {
+    if (var->tag() > 0) {
+      return var->d.chars;
+    } else if (var->d.str) {
       return (*var->d.str)->c_str();
-    } else {
-      return reinterpret_cast<const char *>(&var->d.str);
     }
   }
   return "";
@@ -634,7 +641,7 @@ void Variant_setString(Variant *var, const char *str, int length) {
 
 Slice Variant_slice(const Variant *var) {
   if (var && var->isSlice()) {
-    return var->slice();
+    return var->d.slice;
   }
   return Slice{nullptr, nullptr};
 }
@@ -663,8 +670,7 @@ const Variant *Variant_mapValue(const Variant *var, const char *key,
     return nullptr;
   if (var->isMap()) {
     const auto &map = var->map();
-    auto it =
-        map.find(length < 0 ? std::string(key) : std::string(key, length));
+    auto it = map.find(key, length < 0 ? std::strlen(key) : length);
     if (it != map.end()) {
       return &it->second;
     }
@@ -676,6 +682,6 @@ Variant *Variant_mapValueRef(Variant *var, const char *key, int length) {
   if (!var->isMap()) {
     *var = Variant::Map();
   }
-  return &(*var)[length < 0 ? std::string(key) : std::string(key, length)];
+  return &var->d.map->get(key, length < 0 ? std::strlen(key) : length);
 }
 } // namespace plugkit
@@ -1,12 +1,12 @@
 #ifndef PLUGKIT_VARIANT_HPP
 #define PLUGKIT_VARIANT_HPP
 
+#include "flat_map.hpp"
 #include "types.hpp"
 #include "variant.h"
 #include <json11.hpp>
 #include <memory>
 #include <string>
-#include <unordered_map>
 #include <v8.h>
 #include <vector>
 
@@ -30,7 +30,7 @@ public:
     TYPE_MASK = 0x0f
   };
   using Array = std::vector<Variant>;
-  using Map = std::unordered_map<std::string, Variant>;
+  using Map = FlatMap<Variant>;
 
 public:
   Variant();
@@ -47,12 +47,16 @@ public:
   Variant(const std::string &str);
   Variant(const Slice &slice);
   Variant(const Array &array);
+  Variant(Array &&array);
   Variant(const Map &map);
+  Variant(Map &&map);
   Variant(const Timestamp &ts);
   Variant(void *) = delete;
   ~Variant();
   Variant(const Variant &value);
+  Variant(Variant &&value) noexcept;
   Variant &operator=(const Variant &value);
+  Variant &operator=(Variant &&value) noexcept;
 
 public:
   Type type() const;
@@ -82,9 +86,9 @@ public:
   const Array &array() const;
   const Map &map() const;
   uint8_t tag() const;
-  Variant operator[](size_t index) const;
+  const Variant &operator[](size_t index) const;
   Variant &operator[](size_t index);
-  Variant operator[](const std::string &key) const;
+  const Variant &operator[](const std::string &key) const;
   Variant &operator[](const std::string &key);
   size_t length() const;
 
@@ -98,14 +102,18 @@ public:
 
 public:
   uint8_t type_;
+
+  // Strings shorter than sizeof(d) are stored in chars and their length is
+  // kept in the tag. Timestamps are stored as nanoseconds since the epoch.
   union {
     bool bool_;
     double double_;
     int64_t int_;
     uint64_t uint_;
-    Timestamp *ts;
+    int64_t ts;
     std::shared_ptr<std::string> *str;
-    Slice *slice;
+    char chars[sizeof(Slice)];
+    Slice slice;
     Array *array;
     Map *map;
   } d;
@@ -21,6 +21,7 @@ public:
   static NAN_GETTER(primaryLayer);
   static NAN_GETTER(leafLayers);
   static NAN_GETTER(sourceId);
+  static NAN_GETTER(complete);
   static NAN_METHOD(attr);
   static NAN_METHOD(layer);
 
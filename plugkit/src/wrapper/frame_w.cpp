@@ -24,6 +24,7 @@ void FrameWrapper::init(v8::Isolate *isolate) {
                    primaryLayer);
   Nan::SetAccessor(otl, Nan::New("leafLayers").ToLocalChecked(), leafLayers);
   Nan::SetAccessor(otl, Nan::New("sourceId").ToLocalChecked(), sourceId);
+  Nan::SetAccessor(otl, Nan::New("complete").ToLocalChecked(), complete);
 
   PlugkitModule *module = PlugkitModule::get(isolate);
   module->frame.ctor.Reset(isolate, Nan::GetFunction(tpl).ToLocalChecked());
@@ -64,7 +65,8 @@ NAN_GETTER(FrameWrapper::index) {
 NAN_GETTER(FrameWrapper::rootLayer) {
   FrameWrapper *wrapper = ObjectWrap::Unwrap<FrameWrapper>(info.Holder());
   if (const auto &view = wrapper->view) {
-    if (const auto &layer = view->frame()->rootLayer()) {
+    const auto &layer = view->frame()->rootLayer();
+    if (layer && view->visible(layer)) {
       info.GetReturnValue().Set(LayerWrapper::wrap(layer));
     } else {
       info.GetReturnValue().Set(Nan::Null());
@@ -103,6 +105,13 @@ NAN_GETTER(FrameWrapper::sourceId) {
   }
 }
 
+NAN_GETTER(FrameWrapper::complete) {
+  FrameWrapper *wrapper = ObjectWrap::Unwrap<FrameWrapper>(info.Holder());
+  if (const auto &view = wrapper->view) {
+    info.GetReturnValue().Set(view->complete());
+  }
+}
+
 NAN_METHOD(FrameWrapper::attr) {
   FrameWrapper *wrapper = ObjectWrap::Unwrap<FrameWrapper>(info.Holder());
   if (const auto &view = wrapper->view) {
@@ -1,4 +1,5 @@
 #include "../frame.hpp"
+#include "../frame_view.hpp"
 #include "../layer.hpp"
 #include "layer.hpp"
 #include "payload.hpp"
@@ -64,7 +65,7 @@ NAN_GETTER(LayerWrapper::worker) {
 NAN_SETTER(LayerWrapper::setWorker) {
   LayerWrapper *wrapper = ObjectWrap::Unwrap<LayerWrapper>(info.Holder());
   if (auto layer = wrapper->layer) {
-    layer->setWorker(value->NumberValue());
+    layer->setWorker(value->Uint32Value());
   }
 }
 
@@ -123,10 +124,13 @@ NAN_GETTER(LayerWrapper::layers) {
   LayerWrapper *wrapper = ObjectWrap::Unwrap<LayerWrapper>(info.Holder());
   if (auto layer = wrapper->constLayer) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    const FrameView *view = layer->frame() ? layer->frame()->view() : nullptr;
     const auto &layers = layer->layers();
-    auto array = v8::Array::New(isolate, layers.size());
-    for (size_t i = 0; i < layers.size(); ++i) {
-      array->Set(i, LayerWrapper::wrap(layers[i]));
+    auto array = v8::Array::New(isolate);
+    for (Layer *child : layers) {
+      if (!view || view->visible(child)) {
+        array->Set(array->Length(), LayerWrapper::wrap(child));
+      }
     }
     info.GetReturnValue().Set(array);
   }
@@ -24,9 +24,14 @@ public:
   static NAN_GETTER(options);
   static NAN_METHOD(destroy);
   static NAN_METHOD(getFilteredFrames);
+  static NAN_METHOD(getNearestFrames);
+  static NAN_METHOD(getIndexedFrames);
+  static NAN_METHOD(getFramesByTime);
   static NAN_METHOD(getFrames);
+  static NAN_METHOD(getStreamThreadStatus);
   static NAN_METHOD(analyze);
   static NAN_METHOD(setDisplayFilter);
+  static NAN_METHOD(setFilterLimit);
   static NAN_METHOD(setStatusCallback);
   static NAN_METHOD(setFilterCallback);
   static NAN_METHOD(setFrameCallback);
@@ -2,7 +2,7 @@
 #include "plugkit_module.hpp"
 #include "session_factory.hpp"
 #include "session.hpp"
-#include "dissector.h"
+#include "../src/dissector.hpp"
 
 namespace plugkit {
 
@@ -144,8 +144,9 @@ NAN_METHOD(SessionFactoryWrapper::registerDissector) {
       type = DISSECTOR_STREAM;
     }
     if (info[0]->IsExternal()) {
-      Dissector dissector =
-          *static_cast<const Dissector *>(info[0].As<v8::External>()->Value());
+      Dissector dissector;
+      Dissector_copy(&dissector, static_cast<const Dissector *>(
+                                     info[0].As<v8::External>()->Value()));
       factory->registerDissector(dissector, type);
     } else if (info[0]->IsString()) {
       factory->registerDissector(std::string(*Nan::Utf8String(info[0])), type);
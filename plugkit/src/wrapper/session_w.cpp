@@ -14,9 +14,14 @@ void SessionWrapper::init(v8::Isolate *isolate) {
   SetPrototypeMethod(tpl, "stopPcap", stopPcap);
   SetPrototypeMethod(tpl, "destroy", destroy);
   SetPrototypeMethod(tpl, "getFilteredFrames", getFilteredFrames);
+  SetPrototypeMethod(tpl, "getNearestFrames", getNearestFrames);
+  SetPrototypeMethod(tpl, "getIndexedFrames", getIndexedFrames);
+  SetPrototypeMethod(tpl, "getFramesByTime", getFramesByTime);
   SetPrototypeMethod(tpl, "getFrames", getFrames);
+  SetPrototypeMethod(tpl, "getStreamThreadStatus", getStreamThreadStatus);
   SetPrototypeMethod(tpl, "analyze", analyze);
   SetPrototypeMethod(tpl, "setDisplayFilter", setDisplayFilter);
+  SetPrototypeMethod(tpl, "setFilterLimit", setFilterLimit);
   SetPrototypeMethod(tpl, "setStatusCallback", setStatusCallback);
   SetPrototypeMethod(tpl, "setFilterCallback", setFilterCallback);
   SetPrototypeMethod(tpl, "setFrameCallback", setFrameCallback);
@@ -103,10 +108,75 @@ NAN_METHOD(SessionWrapper::destroy) {
 NAN_METHOD(SessionWrapper::getFilteredFrames) {
   SessionWrapper *wrapper = ObjectWrap::Unwrap<SessionWrapper>(info.Holder());
   if (const auto &session = wrapper->session) {
-    const std::string &name = *Nan::Utf8String(info[0]);
     uint32_t offset = info[1]->Uint32Value();
     uint32_t length = info[2]->Uint32Value();
-    const auto &frames = session->getFilteredFrames(name, offset, length);
+    std::vector<uint32_t> frames;
+    if (info[0]->IsArray()) {
+      auto array = info[0].As<v8::Array>();
+      std::vector<std::string> names;
+      for (uint32_t i = 0; i < array->Length(); ++i) {
+        names.push_back(*Nan::Utf8String(array->Get(i)));
+      }
+      Session::FilterOperator op = Session::FILTER_AND;
+      if (info[3]->IsString() &&
+          std::string(*Nan::Utf8String(info[3])) == "or") {
+        op = Session::FILTER_OR;
+      }
+      frames = session->getFilteredFrames(names, op, offset, length);
+    } else {
+      const std::string &name = *Nan::Utf8String(info[0]);
+      frames = session->getFilteredFrames(name, offset, length);
+    }
+    auto array = Nan::New<v8::Array>(frames.size());
+    for (size_t i = 0; i < frames.size(); ++i) {
+      array->Set(i, Nan::New(frames[i]));
+    }
+    info.GetReturnValue().Set(array);
+  }
+}
+
+NAN_METHOD(SessionWrapper::getNearestFrames) {
+  SessionWrapper *wrapper = ObjectWrap::Unwrap<SessionWrapper>(info.Holder());
+  if (const auto &session = wrapper->session) {
+    const std::string &name = *Nan::Utf8String(info[0]);
+    uint32_t index = info[1]->Uint32Value();
+    uint32_t length = info[2]->Uint32Value();
+    const auto &frames = session->getNearestFrames(name, index, length);
+    auto array = Nan::New<v8::Array>(frames.size());
+    for (size_t i = 0; i < frames.size(); ++i) {
+      array->Set(i, Nan::New(frames[i]));
+    }
+    info.GetReturnValue().Set(array);
+  }
+}
+
+NAN_METHOD(SessionWrapper::getIndexedFrames) {
+  SessionWrapper *wrapper = ObjectWrap::Unwrap<SessionWrapper>(info.Holder());
+  if (const auto &session = wrapper->session) {
+    const std::string &name = *Nan::Utf8String(info[0]);
+    const Variant &value = Variant::getVariant(info[1]);
+    uint32_t offset = info[2]->Uint32Value();
+    uint32_t length = info[3]->Uint32Value();
+    const auto &frames =
+        session->getIndexedFrames(name, value, offset, length);
+    auto array = Nan::New<v8::Array>(frames.size());
+    for (size_t i = 0; i < frames.size(); ++i) {
+      array->Set(i, Nan::New(frames[i]));
+    }
+    info.GetReturnValue().Set(array);
+  }
+}
+
+NAN_METHOD(SessionWrapper::getFramesByTime) {
+  SessionWrapper *wrapper = ObjectWrap::Unwrap<SessionWrapper>(info.Holder());
+  if (const auto &session = wrapper->session) {
+    // Dates and numbers are both taken as milliseconds since the epoch.
+    auto toTimestamp = [](v8::Local<v8::Value> value) {
+      return Timestamp(std::chrono::nanoseconds(
+          static_cast<int64_t>(value->NumberValue() * 1000000)));
+    };
+    const auto &frames = session->getFramesByTime(toTimestamp(info[0]),
+                                                  toTimestamp(info[1]));
     auto array = Nan::New<v8::Array>(frames.size());
     for (size_t i = 0; i < frames.size(); ++i) {
       array->Set(i, Nan::New(frames[i]));
@@ -129,6 +199,25 @@ NAN_METHOD(SessionWrapper::getFrames) {
   }
 }
 
+NAN_METHOD(SessionWrapper::getStreamThreadStatus) {
+  SessionWrapper *wrapper = ObjectWrap::Unwrap<SessionWrapper>(info.Holder());
+  if (const auto &session = wrapper->session) {
+    const auto &status = session->getStreamThreadStatus();
+    auto array = Nan::New<v8::Array>(status.size());
+    for (size_t i = 0; i < status.size(); ++i) {
+      auto obj = Nan::New<v8::Object>();
+      obj->Set(Nan::New("streams").ToLocalChecked(),
+               Nan::New(status[i].streams));
+      obj->Set(Nan::New("activeStreams").ToLocalChecked(),
+               Nan::New(status[i].activeStreams));
+      obj->Set(Nan::New("layers").ToLocalChecked(),
+               Nan::New(static_cast<double>(status[i].layers)));
+      array->Set(i, obj);
+    }
+    info.GetReturnValue().Set(array);
+  }
+}
+
 NAN_METHOD(SessionWrapper::analyze) {
   SessionWrapper *wrapper = ObjectWrap::Unwrap<SessionWrapper>(info.Holder());
   if (const auto &session = wrapper->session) {
@@ -168,7 +257,17 @@ NAN_METHOD(SessionWrapper::setDisplayFilter) {
   if (const auto &session = wrapper->session) {
     const std::string &name = *Nan::Utf8String(info[0]);
     const std::string &body = *Nan::Utf8String(info[1]);
-    session->setDisplayFilter(name, body);
+    const std::string &program =
+        info[2]->IsString() ? *Nan::Utf8String(info[2]) : std::string();
+    session->setDisplayFilter(name, body, program);
+  }
+}
+
+NAN_METHOD(SessionWrapper::setFilterLimit) {
+  SessionWrapper *wrapper = ObjectWrap::Unwrap<SessionWrapper>(info.Holder());
+  if (const auto &session = wrapper->session) {
+    const std::string &name = *Nan::Utf8String(info[0]);
+    session->setFilterLimit(name, info[1]->Uint32Value());
   }
 }
 
@@ -238,6 +337,8 @@ NAN_METHOD(SessionWrapper::setFrameCallback) {
           auto obj = Nan::New<v8::Object>();
           obj->Set(Nan::New("frames").ToLocalChecked(),
                    Nan::New(status.frames));
+          obj->Set(Nan::New("completed").ToLocalChecked(),
+                   Nan::New(status.completed));
           v8::Local<v8::Value> args[1] = {obj};
           func->Call(obj, 1, args);
         }
@@ -0,0 +1,67 @@
+#include "attribute.hpp"
+#include "attribute_index.hpp"
+#include "frame.hpp"
+#include "layer.hpp"
+#include <catch.hpp>
+#include <vector>
+
+using namespace plugkit;
+
+namespace {
+
+struct TestFrame {
+  TestFrame(uint32_t index, uint32_t streamId, uint32_t port)
+      : ipv4(Token_get("ipv4")), tcp(Token_get("tcp")),
+        src(Token_get(".src"), Variant(Slice{addr, addr + 4})),
+        dst(Token_get(".dst"), Variant(port)),
+        stream(Token_get("tcp.streamId"), Variant(streamId)) {
+    ipv4.addAttr(&src);
+    tcp.addAttr(&dst);
+    tcp.addAttr(&stream);
+    ipv4.addLayer(&tcp);
+    frame.setRootLayer(&ipv4);
+    frame.setIndex(index);
+  }
+
+  const char addr[4] = {10, 0, 0, 5};
+  Frame frame;
+  Layer ipv4;
+  Layer tcp;
+  Attr src;
+  Attr dst;
+  Attr stream;
+};
+
+TEST_CASE("AttributeIndex_find", "[AttributeIndex]") {
+  TestFrame a(1, 0, 80);
+  TestFrame b(2, 1, 443);
+  TestFrame c(3, 0, 80);
+  const Frame *frames[] = {&a.frame, &b.frame, &c.frame};
+
+  AttributeIndex index{Variant()};
+  index.insert(frames, 3);
+  CHECK(index.find("tcp.streamId", Variant(0.0), 0, 10) ==
+        (std::vector<uint32_t>{1, 3}));
+  CHECK(index.find("tcp.streamId", Variant(static_cast<uint32_t>(1)), 0, 10) ==
+        std::vector<uint32_t>{2});
+  CHECK(index.find("tcp.dst", Variant(443.0), 0, 10) ==
+        std::vector<uint32_t>{2});
+  CHECK(index.find("tcp", Variant(), 1, 10) == (std::vector<uint32_t>{2, 3}));
+  CHECK(index.size("ipv4.src", Variant(Slice{a.addr, a.addr + 4})) == 3);
+  CHECK(index.size("tcp.dst", Variant(22.0)) == 0);
+  CHECK(index.size("tcp.seq", Variant(0.0)) == 0);
+}
+
+TEST_CASE("AttributeIndex_options", "[AttributeIndex]") {
+  TestFrame a(1, 0, 80);
+  const Frame *frames[] = {&a.frame};
+
+  Variant options;
+  options["_"]["indexedAttributes"] =
+      Variant(Variant::Array{Variant(std::string("tcp.dst"))});
+  AttributeIndex index(options);
+  index.insert(frames, 1);
+  CHECK(index.size("tcp.dst", Variant(80.0)) == 1);
+  CHECK(index.size("tcp.streamId", Variant(0.0)) == 0);
+}
+} // namespace
@@ -0,0 +1,70 @@
+#include "bitmap.hpp"
+#include <catch.hpp>
+#include <vector>
+
+using namespace plugkit;
+
+namespace {
+
+TEST_CASE("Bitmap_add", "[Bitmap]") {
+  Bitmap bitmap;
+  CHECK(bitmap.empty());
+  bitmap.add(5);
+  bitmap.add(70000);
+  bitmap.add(1);
+  bitmap.add(5);
+  CHECK(bitmap.size() == 3);
+  CHECK(bitmap.contains(1));
+  CHECK(bitmap.contains(70000));
+  CHECK_FALSE(bitmap.contains(2));
+  CHECK(bitmap.values(0, 10) == (std::vector<uint32_t>{1, 5, 70000}));
+  bitmap.clear();
+  CHECK(bitmap.empty());
+}
+
+TEST_CASE("Bitmap_rank", "[Bitmap]") {
+  Bitmap bitmap;
+  for (uint32_t i = 1; i <= 200000; i += 2) {
+    bitmap.add(i);
+  }
+  CHECK(bitmap.size() == 100000);
+  CHECK(bitmap.rank(1) == 0);
+  CHECK(bitmap.rank(2) == 1);
+  CHECK(bitmap.rank(100001) == 50000);
+  CHECK(bitmap.rank(300000) == 100000);
+  CHECK(bitmap.select(0) == 1);
+  CHECK(bitmap.select(50000) == 100001);
+  CHECK(bitmap.select(99999) == 199999);
+  CHECK(bitmap.values(65535, 3) ==
+        (std::vector<uint32_t>{131071, 131073, 131075}));
+
+  uint32_t value = 0;
+  CHECK(bitmap.lowerBound(131072, &value));
+  CHECK(value == 131073);
+  CHECK_FALSE(bitmap.lowerBound(200000, &value));
+  CHECK(bitmap.bytes() < 100000 * sizeof(uint32_t) / 2);
+}
+
+TEST_CASE("Bitmap_operators", "[Bitmap]") {
+  Bitmap even;
+  Bitmap three;
+  for (uint32_t i = 0; i < 150000; ++i) {
+    if (i % 2 == 0)
+      even.add(i);
+    if (i % 3 == 0)
+      three.add(i);
+  }
+  three.add(200001);
+
+  Bitmap both = even & three;
+  CHECK(both.size() == 25000);
+  CHECK(both.select(1) == 6);
+  CHECK_FALSE(both.contains(200001));
+
+  Bitmap either = even | three;
+  CHECK(either.size() == 100001);
+  CHECK(either.contains(9));
+  CHECK(either.contains(200001));
+  CHECK_FALSE(either.contains(7));
+}
+} // namespace
@@ -0,0 +1,30 @@
+const assert = require('assert')
+const bpf = require('../bpf')
+
+describe('bpf', () => {
+  it('should translate port and address comparisons', () => {
+    assert.strictEqual('tcp dst port 80', bpf('tcp.dst == 80'))
+    assert.strictEqual('udp src portrange 1024-65535', bpf('1023 < udp.src'))
+    assert.strictEqual('(tcp) and (ip src host 10.0.0.5)',
+      bpf('tcp && ipv4.src == `10.0.0.5`'))
+  })
+  it('should drop untranslatable conjuncts', () => {
+    assert.strictEqual('(tcp dst port 80)', bpf('tcp.dst == 80 && eth.src == 1'))
+  })
+  it('should return null for untranslatable filters', () => {
+    assert.strictEqual(null, bpf('eth.src == 1 || tcp'))
+    assert.strictEqual(null, bpf('!(tcp.dst == 80 && eth.src == 1)'))
+    assert.strictEqual(null, bpf('tcp.'))
+  })
+  it('should negate only exact translations', () => {
+    assert.strictEqual('not (tcp dst port 80)', bpf('!(tcp.dst == 80)'))
+    assert.strictEqual(null, bpf('!(ipv4 && eth.src == 1)'))
+  })
+  it('should not translate attributes the dissectors do not emit', () => {
+    assert.strictEqual(null, bpf('tcp.port == 80'))
+    assert.strictEqual(null, bpf('!(tcp.port == 80)'))
+    assert.strictEqual(null, bpf('!(udp.port == 53)'))
+    assert.strictEqual(null, bpf('ipv4.addr == `10.0.0.5`'))
+    assert.strictEqual('(tcp)', bpf('tcp && tcp.port == 80'))
+  })
+})
@@ -0,0 +1,43 @@
+#include "dissector.hpp"
+#include <catch.hpp>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+
+using namespace plugkit;
+
+namespace {
+
+void analyzeBatch(Context *ctx, const Dissector *diss, Worker worker,
+                  Layer **layers, size_t size) {}
+
+// A dissector as exported by a plugin built before analyzeBatch was added.
+const size_t originalSize = offsetof(Dissector, analyzeBatch);
+
+TEST_CASE("Dissector_reset", "[Dissector]") {
+  std::unique_ptr<char[]> old(new char[originalSize]);
+  std::memset(old.get(), 0xff, originalSize);
+  Dissector_reset(reinterpret_cast<Dissector *>(old.get()));
+  for (size_t i = 0; i < originalSize; ++i) {
+    CHECK(old[i] == 0);
+  }
+}
+
+TEST_CASE("Dissector_copy", "[Dissector]") {
+  static Dissector current;
+  Dissector_init(&current);
+  current.data = &current;
+  current.analyzeBatch = analyzeBatch;
+  Dissector copy;
+  Dissector_copy(&copy, &current);
+  CHECK(copy.data == &current);
+  CHECK(copy.analyzeBatch == analyzeBatch);
+
+  std::unique_ptr<char[]> old(new char[originalSize]());
+  Dissector *diss = reinterpret_cast<Dissector *>(old.get());
+  diss->data = &current;
+  Dissector_copy(&copy, diss);
+  CHECK(copy.data == &current);
+  CHECK(copy.analyzeBatch == nullptr);
+}
+} // namespace
@@ -0,0 +1,97 @@
+#include "dissector_thread.hpp"
+#include "dissector.h"
+#include "frame.hpp"
+#include "layer.hpp"
+#include "variant.hpp"
+#include <catch.hpp>
+#include <memory>
+#include <vector>
+
+using namespace plugkit;
+
+namespace {
+
+struct Calls {
+  std::vector<size_t> batches;
+  std::vector<Layer *> layers;
+};
+
+void addChild(Layer *layer, const char *id, const char *tag) {
+  Layer *child = Layer_addLayer(layer, Token_get(id));
+  Layer_addTag(child, Token_get(tag));
+}
+
+TEST_CASE("DissectorThread_analyzeBatch", "[DissectorThread]") {
+  Calls batch;
+  Calls single;
+  Calls child;
+
+  Dissector eth = Dissector();
+  eth.layerHints[0] = Token_get("[eth]");
+  eth.data = &batch;
+  eth.analyzeBatch = [](Context *ctx, const Dissector *diss, Worker worker,
+                        Layer **layers, size_t size) {
+    Calls *calls = static_cast<Calls *>(diss->data);
+    calls->batches.push_back(size);
+    for (size_t i = 0; i < size; ++i) {
+      calls->layers.push_back(layers[i]);
+      addChild(layers[i], "ipv4", "[ipv4]");
+    }
+  };
+
+  Dissector other = Dissector();
+  other.layerHints[0] = Token_get("[eth]");
+  other.data = &single;
+  other.analyze = [](Context *ctx, const Dissector *diss, Worker worker,
+                     Layer *layer) {
+    static_cast<Calls *>(diss->data)->layers.push_back(layer);
+  };
+
+  Dissector ipv4 = Dissector();
+  ipv4.layerHints[0] = Token_get("[ipv4]");
+  ipv4.data = &child;
+  ipv4.analyze = [](Context *ctx, const Dissector *diss, Worker worker,
+                    Layer *layer) {
+    static_cast<Calls *>(diss->data)->layers.push_back(layer);
+    addChild(layer, "eth", "[eth]");
+  };
+
+  std::vector<Frame *> done;
+  auto queue = std::make_shared<FrameQueue>();
+  DissectorThread thread(Variant(), queue, [&done](Frame **begin, size_t size) {
+    done.insert(done.end(), begin, begin + size);
+  });
+  thread.pushDissector(eth);
+  thread.pushDissector(other);
+  thread.pushDissector(ipv4);
+
+  std::vector<std::unique_ptr<Frame>> frames;
+  std::vector<Frame *> input;
+  for (uint32_t i = 0; i < 128; ++i) {
+    Layer *root = new Layer(Token_get("eth"));
+    Layer_addTag(root, Token_get("[eth]"));
+    frames.emplace_back(new Frame());
+    frames.back()->setIndex(i);
+    frames.back()->setRootLayer(root);
+    input.push_back(frames.back().get());
+  }
+  queue->enqueue(input.begin(), input.end());
+
+  thread.enter();
+  REQUIRE(thread.loop());
+  thread.exit();
+
+  CHECK(done == input);
+  REQUIRE(batch.batches == std::vector<size_t>{128});
+  REQUIRE(batch.layers.size() == 128);
+  REQUIRE(single.layers.size() == 128);
+  REQUIRE(child.layers.size() == 128);
+  for (size_t i = 0; i < 128; ++i) {
+    Layer *root = frames[i]->rootLayer();
+    CHECK(batch.layers[i] == root);
+    CHECK(single.layers[i] == root);
+    REQUIRE(root->layers().size() == 1);
+    CHECK(child.layers[i] == root->layers()[0]);
+  }
+}
+} // namespace
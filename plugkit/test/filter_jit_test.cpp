@@ -0,0 +1,122 @@
+#include "filter_jit.hpp"
+#include <catch.hpp>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+using namespace plugkit;
+
+namespace {
+
+using Instruction = FilterJit::Instruction;
+
+Instruction test(uint32_t column, FilterJit::Compare compare, double constant,
+                 bool reversed = false) {
+  Instruction inst;
+  inst.column = column;
+  inst.compare = compare;
+  inst.constant = constant;
+  inst.reversed = reversed;
+  return inst;
+}
+
+Instruction masked(uint32_t column, int32_t mask) {
+  Instruction inst;
+  inst.column = column;
+  inst.masked = true;
+  inst.mask = mask;
+  return inst;
+}
+
+Instruction op(FilterJit::Opcode opcode) {
+  Instruction inst;
+  inst.opcode = opcode;
+  return inst;
+}
+
+std::vector<uint8_t> run(const std::vector<Instruction> &code,
+                         const std::vector<std::vector<double>> &columns) {
+  FilterJit jit(code);
+  REQUIRE(jit.valid());
+  std::vector<const double *> pointers;
+  for (const auto &column : columns) {
+    pointers.push_back(column.data());
+  }
+  std::vector<uint8_t> results(columns[0].size(), 0xff);
+  jit.run(pointers.data(), results.size(), results.data());
+  return results;
+}
+
+#if defined(__x86_64__) || defined(_M_X64)
+
+TEST_CASE("FilterJit_compare", "[FilterJit]") {
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  const std::vector<std::vector<double>> columns = {{79, 80, 81, nan, -80}};
+  using R = std::vector<uint8_t>;
+  CHECK(run({test(0, FilterJit::COMPARE_EQ, 80)}, columns) ==
+        (R{0, 1, 0, 0, 0}));
+  CHECK(run({test(0, FilterJit::COMPARE_NE, 80)}, columns) ==
+        (R{1, 0, 1, 1, 1}));
+  CHECK(run({test(0, FilterJit::COMPARE_LT, 80)}, columns) ==
+        (R{1, 0, 0, 0, 1}));
+  CHECK(run({test(0, FilterJit::COMPARE_GT, 80)}, columns) ==
+        (R{0, 0, 1, 0, 0}));
+  CHECK(run({test(0, FilterJit::COMPARE_LE, 80)}, columns) ==
+        (R{1, 1, 0, 0, 1}));
+  CHECK(run({test(0, FilterJit::COMPARE_GE, 80)}, columns) ==
+        (R{0, 1, 1, 0, 0}));
+  CHECK(run({test(0, FilterJit::COMPARE_LT, 80, true)}, columns) ==
+        (R{0, 0, 1, 0, 0}));
+  CHECK(run({test(0, FilterJit::COMPARE_GE, 80, true)}, columns) ==
+        (R{1, 1, 0, 0, 1}));
+  CHECK(run({test(0, FilterJit::COMPARE_TRUTHY, 0)}, {{0, -0.0, 1, nan}}) ==
+        (R{0, 0, 1, 0}));
+}
+
+TEST_CASE("FilterJit_masked", "[FilterJit]") {
+  const std::vector<std::vector<double>> columns = {
+      {0, 1, 2, 3, -1, 4294967295.0, 4294967296.0 + 2}};
+  using R = std::vector<uint8_t>;
+  CHECK(run({masked(0, 2)}, columns) == (R{0, 0, 1, 1, 1, 1, 1}));
+
+  Instruction sign = masked(0, -2147483647 - 1);
+  sign.compare = FilterJit::COMPARE_LT;
+  CHECK(run({sign}, columns) == (R{0, 0, 0, 0, 1, 1, 0}));
+}
+
+TEST_CASE("FilterJit_logical", "[FilterJit]") {
+  const std::vector<std::vector<double>> columns = {{0, 1, 0, 1},
+                                                    {0, 0, 1, 1}};
+  using R = std::vector<uint8_t>;
+  const Instruction a = test(0, FilterJit::COMPARE_TRUTHY, 0);
+  const Instruction b = test(1, FilterJit::COMPARE_TRUTHY, 0);
+  CHECK(run({a, b, op(FilterJit::OPCODE_AND)}, columns) == (R{0, 0, 0, 1}));
+  CHECK(run({a, b, op(FilterJit::OPCODE_OR)}, columns) == (R{0, 1, 1, 1}));
+  CHECK(run({a, op(FilterJit::OPCODE_NOT)}, columns) == (R{1, 0, 1, 0}));
+  CHECK(run({a, a, b, op(FilterJit::OPCODE_OR), a, b,
+             op(FilterJit::OPCODE_AND), op(FilterJit::OPCODE_NOT),
+             op(FilterJit::OPCODE_AND), op(FilterJit::OPCODE_AND)},
+            columns) == (R{0, 1, 0, 0}));
+}
+
+TEST_CASE("FilterJit_empty", "[FilterJit]") {
+  FilterJit jit({test(0, FilterJit::COMPARE_EQ, 1)});
+  REQUIRE(jit.valid());
+  uint8_t result = 0xff;
+  jit.run(nullptr, 0, &result);
+  CHECK(result == 0xff);
+}
+
+#endif
+
+TEST_CASE("FilterJit_invalid", "[FilterJit]") {
+  const Instruction a = test(0, FilterJit::COMPARE_EQ, 1);
+  CHECK_FALSE(FilterJit({}).valid());
+  CHECK_FALSE(FilterJit({a, a}).valid());
+  CHECK_FALSE(FilterJit({a, op(FilterJit::OPCODE_AND)}).valid());
+  CHECK_FALSE(FilterJit({a, a, a, a, a, op(FilterJit::OPCODE_AND),
+                         op(FilterJit::OPCODE_AND), op(FilterJit::OPCODE_AND),
+                         op(FilterJit::OPCODE_AND)})
+                  .valid());
+}
+} // namespace
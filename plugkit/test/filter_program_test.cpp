@@ -0,0 +1,277 @@
+#include "attribute.hpp"
+#include "filter_program.hpp"
+#include "frame.hpp"
+#include "frame_view.hpp"
+#include "layer.hpp"
+#include <catch.hpp>
+#include <limits>
+#include <string>
+
+using namespace plugkit;
+
+namespace {
+
+std::string literal(const std::string &value) {
+  return R"({"type":"Literal","value":)" + value + "}";
+}
+
+std::string op(const std::string &opcode, const std::string &left,
+               const std::string &right = std::string()) {
+  return R"({"type":"CallExpression","callee":{"type":"Identifier",)"
+         R"("name":"$_op"},"arguments":[)" +
+         literal("\"" + opcode + "\"") + "," + left +
+         (right.empty() ? "" : "," + right) + "]}";
+}
+
+std::string call(const std::string &object, const std::string &method,
+                 const std::string &arg) {
+  return R"({"type":"CallExpression","callee":{"type":"MemberExpression",)"
+         R"("computed":false,"object":)" +
+         object + R"(,"property":{"type":"Identifier","name":")" + method +
+         R"("}},"arguments":[)" + arg + "]}";
+}
+
+std::string member(const std::string &object, const std::string &property) {
+  return R"({"type":"MemberExpression","computed":false,"object":)" + object +
+         R"(,"property":{"type":"Identifier","name":")" + property + "\"}}";
+}
+
+std::string frame() { return R"({"type":"Identifier","name":"$_frame"})"; }
+
+std::string attr(const std::string &layer, const std::string &name) {
+  return call(call(frame(), "layer", literal("\"" + layer + "\"")), "attr",
+              literal("\"" + name + "\""));
+}
+
+std::string program(const std::string &expr) {
+  return R"({"type":"Program","body":[{"type":"ExpressionStatement",)"
+         R"("expression":{"type":"FunctionExpression","params":[)" +
+         frame() +
+         R"(],"body":{"type":"BlockStatement","body":[{"type":)"
+         R"("ReturnStatement","argument":{"type":"UnaryExpression",)"
+         R"("operator":"!","prefix":true,"argument":)" +
+         op("!", expr) + "}}]}}}]}";
+}
+
+struct TestFrame {
+  TestFrame()
+      : eth(Token_get("eth")), tcp(Token_get("tcp")),
+        dst(Token_get("tcp.dst"), Variant(static_cast<uint32_t>(80))),
+        flags(Token_get("tcp.flags"), Variant(Slice{data, data + 3})),
+        name(Token_get("tcp.name"), Variant(std::string("http"))),
+        seq(Token_get("tcp.seq"), Variant(static_cast<uint64_t>(1))) {
+    tcp.addAttr(&dst);
+    tcp.addAttr(&flags);
+    tcp.addAttr(&name);
+    tcp.addAttr(&seq);
+    eth.addLayer(&tcp);
+    frame.setRootLayer(&eth);
+    view.reset(new FrameView(&frame));
+  }
+
+  const char data[3] = {1, 2, 3};
+  Frame frame;
+  Layer eth;
+  Layer tcp;
+  Attr dst;
+  Attr flags;
+  Attr name;
+  Attr seq;
+  std::unique_ptr<FrameView> view;
+};
+
+FilterProgram::Result test(const std::string &expr, bool specialize = true) {
+  TestFrame frame;
+  FilterProgram filter(program(expr), specialize);
+  REQUIRE(filter.valid());
+  return filter.test(frame.view.get());
+}
+
+TEST_CASE("FilterProgram_layer", "[FilterProgram]") {
+  CHECK(test(call(frame(), "layer", literal("\"tcp\""))) ==
+        FilterProgram::RESULT_TRUE);
+  CHECK(test(call(frame(), "layer", literal("\"udp\""))) ==
+        FilterProgram::RESULT_FALSE);
+  CHECK(test(attr("udp", "udp.dst")) == FilterProgram::RESULT_FALSE);
+}
+
+TEST_CASE("FilterProgram_compare", "[FilterProgram]") {
+  const std::string &dst = attr("tcp", "tcp.dst");
+  CHECK(test(op("==", dst, literal("80"))) == FilterProgram::RESULT_TRUE);
+  CHECK(test(op("==", dst, literal("\"80\""))) == FilterProgram::RESULT_TRUE);
+  CHECK(test(op("===", dst, literal("\"80\""))) ==
+        FilterProgram::RESULT_FALSE);
+  CHECK(test(op(">=", dst, literal("1024"))) == FilterProgram::RESULT_FALSE);
+  CHECK(test(op("<", dst, literal("1024"))) == FilterProgram::RESULT_TRUE);
+  CHECK(test(op("==", member(dst, "value"), literal("80"))) ==
+        FilterProgram::RESULT_TRUE);
+  CHECK(test(op("==", attr("tcp", "tcp.name"), literal("\"http\""))) ==
+        FilterProgram::RESULT_TRUE);
+  CHECK(test(op("==", attr("tcp", "tcp.none"), literal("80"))) ==
+        FilterProgram::RESULT_FALSE);
+}
+
+TEST_CASE("FilterProgram_specialize", "[FilterProgram]") {
+  const std::string &dst = attr("tcp", "tcp.dst");
+  const std::string &none = attr("tcp", "tcp.none");
+  const std::string exprs[] = {
+      op("==", dst, literal("80")),
+      op("!==", literal("80"), dst),
+      op(">", literal("1024"), dst),
+      op("<=", member(dst, "value"), literal("80")),
+      op("<", none, literal("1")),
+      op(">", literal("1"), none),
+      op("==", literal("0"), none),
+      op("==", attr("udp", "udp.dst"), literal("80")),
+      op("==", attr("tcp", "tcp.seq"), literal("1")),
+      op("==", attr("tcp", "tcp.name"), literal("4"))};
+  for (const std::string &expr : exprs) {
+    CHECK(test(expr, true) == test(expr, false));
+  }
+  CHECK(test(op(">", literal("1"), none)) == FilterProgram::RESULT_TRUE);
+  CHECK(test(op("<", none, literal("1"))) == FilterProgram::RESULT_FALSE);
+}
+
+TEST_CASE("FilterProgram_logical", "[FilterProgram]") {
+  const std::string &dst = attr("tcp", "tcp.dst");
+  const std::string &eq = op("==", dst, literal("80"));
+  const std::string &ne = op("!=", dst, literal("80"));
+  CHECK(test(op("&&", eq, ne)) == FilterProgram::RESULT_FALSE);
+  CHECK(test(op("||", ne, eq)) == FilterProgram::RESULT_TRUE);
+  CHECK(test(op("!", ne)) == FilterProgram::RESULT_TRUE);
+  CHECK(test(op("==", op("&", dst, literal("16")), literal("16"))) ==
+        FilterProgram::RESULT_TRUE);
+}
+
+TEST_CASE("FilterProgram_buffer", "[FilterProgram]") {
+  const std::string &flags = attr("tcp", "tcp.flags");
+  const std::string &array = R"({"type":"ArrayExpression","elements":[)" +
+                             literal("1") + "," + literal("2") + "," +
+                             literal("3") + "]}";
+  CHECK(test(op("==", flags, array)) == FilterProgram::RESULT_TRUE);
+  const std::string &value = member(flags, "value");
+  CHECK(test(op("==", member(value, "length"), literal("3"))) ==
+        FilterProgram::RESULT_TRUE);
+  CHECK(test(op("==",
+                R"({"type":"MemberExpression","computed":true,"object":)" +
+                    value + R"(,"property":)" + literal("1") + "}",
+                literal("2"))) == FilterProgram::RESULT_TRUE);
+}
+
+TEST_CASE("FilterProgram_batch", "[FilterProgram]") {
+  TestFrame frames[3];
+  frames[1].dst.setValue(Variant(static_cast<uint32_t>(443)));
+  frames[2].dst.setValue(Variant(static_cast<uint64_t>(80)));
+  const FrameView *views[3] = {frames[0].view.get(), frames[1].view.get(),
+                               frames[2].view.get()};
+
+  FilterProgram filter(
+      program(op("==", attr("tcp", "tcp.dst"), literal("80"))));
+  uint64_t results = 0;
+  uint64_t unsupported = 0;
+  filter.test(&results, &unsupported, views, 3);
+  CHECK(results == 0x1);
+  CHECK(unsupported == 0x4);
+}
+
+TEST_CASE("FilterProgram_jit", "[FilterProgram]") {
+  const Variant values[] = {Variant(static_cast<uint32_t>(80)),
+                            Variant(static_cast<uint32_t>(443)),
+                            Variant(static_cast<uint32_t>(1040)),
+                            Variant(static_cast<int32_t>(-1)),
+                            Variant(std::numeric_limits<double>::quiet_NaN()),
+                            Variant(1e20),
+                            Variant(std::string("80")),
+                            Variant(static_cast<uint64_t>(80))};
+  const size_t size = sizeof(values) / sizeof(values[0]);
+  TestFrame frames[size];
+  const FrameView *views[size];
+  for (size_t i = 0; i < size; ++i) {
+    frames[i].dst.setValue(values[i]);
+    views[i] = frames[i].view.get();
+  }
+
+  const std::string &dst = attr("tcp", "tcp.dst");
+  const std::string &none = attr("tcp", "tcp.none");
+  const std::string exprs[] = {
+      op("==", dst, literal("80")),
+      op("!=", literal("80"), dst),
+      op("&&", op(">=", dst, literal("1024")), op("!=", dst, literal("443"))),
+      op("||", op("!", op("<", dst, literal("100"))),
+         op("==", member(dst, "value"), literal("80"))),
+      op("&", dst, literal("16")),
+      op("==", op("&", literal("16"), dst), literal("16")),
+      op("<", op("&", dst, literal("-2147483648")), literal("0")),
+      op("||", op("==", dst, literal("80")), op("<", none, literal("1"))),
+      op("||", op("==", dst, literal("80")), op(">", literal("1"), none)),
+      op("&&", op("==", attr("udp", "udp.dst"), literal("80")),
+         op("==", dst, literal("80")))};
+  for (const std::string &expr : exprs) {
+    FilterProgram interpreter(program(expr));
+    FilterProgram jit(program(expr), true, true);
+    REQUIRE(jit.valid());
+#if defined(__x86_64__) || defined(_M_X64)
+    CHECK(jit.native());
+#endif
+    uint64_t expected[2] = {0, 0};
+    uint64_t results[2] = {0, 0};
+    interpreter.test(&expected[0], &expected[1], views, size);
+    jit.test(&results[0], &results[1], views, size);
+    CHECK(results[0] == expected[0]);
+    CHECK(results[1] == expected[1]);
+  }
+
+  CHECK_FALSE(FilterProgram(program(op("==", dst, literal("80")))).native());
+  CHECK_FALSE(FilterProgram(program(op("==", attr("tcp", "tcp.name"),
+                                       literal("\"http\""))),
+                            true, true)
+                  .native());
+}
+
+TEST_CASE("FilterProgram_refines", "[FilterProgram]") {
+  const std::string &dst = attr("tcp", "tcp.dst");
+  const std::string &eq = op("==", dst, literal("80"));
+  const std::string &ne = op("!=", dst, literal("443"));
+  const std::string &lt = op("<", dst, literal("1024"));
+  CHECK(FilterProgram::refines(program(eq), program(eq)));
+  CHECK(FilterProgram::refines(program(op("&&", eq, ne)), program(eq)));
+  CHECK(FilterProgram::refines(program(op("&&", op("&&", eq, ne), lt)),
+                               program(eq)));
+  CHECK(FilterProgram::refines(program(op("&&", op("&&", eq, ne), lt)),
+                               program(op("&&", eq, ne))));
+  CHECK_FALSE(FilterProgram::refines(program(op("&&", ne, eq)), program(eq)));
+  CHECK_FALSE(FilterProgram::refines(program(op("||", eq, ne)), program(eq)));
+  CHECK_FALSE(FilterProgram::refines(program(eq), program(op("&&", eq, ne))));
+  CHECK_FALSE(FilterProgram::refines(program(eq), ""));
+}
+
+TEST_CASE("FilterProgram_timeRange", "[FilterProgram]") {
+  const std::string &ts = member(frame(), "timestamp");
+  const std::string &eq = op("==", attr("tcp", "tcp.dst"), literal("80"));
+  FilterProgram::TimeRange range;
+  REQUIRE(FilterProgram::timeRange(
+      program(op("&&", op("&&", op(">=", ts, literal("1000")), eq),
+                 op(">", literal("2000"), ts))),
+      &range));
+  CHECK(range.begin == 1000);
+  CHECK(range.beginInclusive);
+  CHECK(range.end == 2000);
+  CHECK_FALSE(range.endInclusive);
+  CHECK(range.overlaps(0, 1000));
+  CHECK(range.overlaps(1500, 1600));
+  CHECK_FALSE(range.overlaps(0, 999));
+  CHECK_FALSE(range.overlaps(2000, 3000));
+
+  CHECK_FALSE(FilterProgram::timeRange(program(eq), &range));
+  CHECK_FALSE(FilterProgram::timeRange(
+      program(op("||", op("<", ts, literal("1000")), eq)), &range));
+}
+
+TEST_CASE("FilterProgram_unsupported", "[FilterProgram]") {
+  CHECK(test(op("==", attr("tcp", "tcp.seq"), literal("1"))) ==
+        FilterProgram::RESULT_UNSUPPORTED);
+  CHECK_FALSE(FilterProgram(program(R"({"type":"Identifier","name":"x"})"))
+                  .valid());
+  CHECK_FALSE(FilterProgram("").valid());
+}
+} // namespace
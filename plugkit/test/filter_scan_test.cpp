@@ -0,0 +1,172 @@
+#include "filter_scan.hpp"
+#include <catch.hpp>
+#include <vector>
+
+using namespace plugkit;
+
+namespace {
+
+struct Claims {
+  // Every 4th offset matches once it has been tested.
+  uint32_t count(uint32_t begin, uint32_t end) const {
+    uint32_t count = 0;
+    for (uint32_t i = begin; i < end && i < tested.size(); ++i) {
+      count += (tested[i] > 0 && i % 4 == 0);
+    }
+    return count;
+  }
+
+  void claim(uint32_t begin, uint32_t end) {
+    if (tested.size() < end) {
+      tested.resize(end);
+    }
+    for (uint32_t i = begin; i < end; ++i) {
+      ++tested[i];
+    }
+  }
+
+  bool scan(FilterScan *scan, uint32_t completed, size_t batchSize) {
+    scan->stepOver();
+    uint32_t start = scan->next();
+    if (start >= completed)
+      return false;
+    size_t size = scan->fit(start, std::min<size_t>(batchSize, completed - start));
+    scan->advance(size);
+    claim(start, start + size);
+    return true;
+  }
+
+  bool focus(FilterScan *scan, uint32_t completed, size_t batchSize,
+             bool *waiting = nullptr) {
+    bool wait = false;
+    uint32_t begin;
+    uint32_t end;
+    if (!scan->claimFocus(completed, batchSize,
+                          [this](uint32_t begin, uint32_t end) {
+                            return count(begin, end);
+                          },
+                          &begin, &end, waiting ? waiting : &wait))
+      return false;
+    REQUIRE(begin < end);
+    claim(begin, end);
+    return true;
+  }
+
+  std::vector<uint32_t> tested;
+};
+
+TEST_CASE("FilterScan_focusAhead", "[FilterScan]") {
+  FilterScan scan;
+  Claims claims;
+  scan.reset(0);
+  REQUIRE(claims.scan(&scan, 10000, 100));
+  CHECK(scan.next() == 100);
+
+  // A focus ahead of the shared scan is claimed on both sides first.
+  CHECK(scan.setFocus(5000, 10));
+  CHECK_FALSE(scan.setFocus(5000, 10));
+  while (claims.focus(&scan, 10000, 16)) {
+  }
+  CHECK(claims.count(5000, 10000) >= 10);
+  CHECK(claims.count(100, 5000) >= 10);
+  CHECK(claims.count(100, 4900) == 0);
+  CHECK(claims.count(5100, 10000) == 0);
+
+  while (claims.scan(&scan, 10000, 100)) {
+  }
+  REQUIRE(claims.tested.size() == 10000);
+  for (uint32_t i = 0; i < 10000; ++i) {
+    REQUIRE(claims.tested[i] == 1);
+  }
+}
+
+TEST_CASE("FilterScan_focusBehind", "[FilterScan]") {
+  FilterScan scan;
+  Claims claims;
+  scan.reset(0);
+  while (scan.next() < 5000 && claims.scan(&scan, 10000, 100)) {
+  }
+
+  // The offsets behind the shared scan have been claimed already, so only
+  // the ones ahead of it are claimed for the focus.
+  CHECK(scan.setFocus(1000, 10));
+  while (claims.focus(&scan, 10000, 16)) {
+  }
+  CHECK(claims.count(1000, 5000) >= 10);
+  CHECK(claims.tested.size() == 5000);
+
+  CHECK(scan.setFocus(4990, 10));
+  while (claims.focus(&scan, 10000, 16)) {
+  }
+  CHECK(claims.count(4990, 10000) >= 10);
+  CHECK(claims.tested.size() < 5100);
+  for (uint32_t value : claims.tested) {
+    REQUIRE(value == 1);
+  }
+}
+
+TEST_CASE("FilterScan_waiting", "[FilterScan]") {
+  FilterScan scan;
+  Claims claims;
+  scan.reset(0);
+  CHECK(scan.setFocus(90, 10));
+  bool waiting = false;
+  while (claims.focus(&scan, 100, 16, &waiting)) {
+  }
+  CHECK(waiting);
+  CHECK(claims.tested.size() == 100);
+
+  // Frames completed later are claimed for the focus as well.
+  waiting = false;
+  while (claims.focus(&scan, 200, 16, &waiting)) {
+  }
+  CHECK_FALSE(waiting);
+  CHECK(claims.count(90, 200) >= 10);
+}
+
+TEST_CASE("FilterScan_exactlyOnce", "[FilterScan]") {
+  // Interleaves the shared scan with claims around a moving focus while
+  // frames are completed.
+  FilterScan scan;
+  Claims claims;
+  scan.reset(0);
+  uint32_t completed = 0;
+  uint32_t random = 1;
+  for (int step = 0; step < 20000; ++step) {
+    random = random * 1103515245 + 12345;
+    uint32_t value = (random >> 8) % 1000;
+    if (value < 50) {
+      completed = std::min<uint32_t>(completed + value * 10, 50000);
+    } else if (value < 60) {
+      scan.setFocus((random >> 4) % 50000, value % 8 + 1);
+    } else if (value < 500) {
+      claims.focus(&scan, completed, value % 64 + 1);
+    } else {
+      claims.scan(&scan, completed, value % 64 + 1);
+    }
+  }
+  completed = 50000;
+  while (claims.focus(&scan, completed, 32) ||
+         claims.scan(&scan, completed, 128)) {
+  }
+  REQUIRE(claims.tested.size() == completed);
+  for (uint32_t i = 0; i < completed; ++i) {
+    REQUIRE(claims.tested[i] == 1);
+  }
+}
+
+TEST_CASE("FilterScan_reset", "[FilterScan]") {
+  FilterScan scan;
+  Claims claims;
+  scan.reset(0);
+  CHECK(scan.setFocus(500, 1));
+  CHECK(claims.focus(&scan, 1000, 16));
+  CHECK(scan.focused());
+
+  // Resuming drops the claims made for the previous focus.
+  scan.reset(200);
+  CHECK_FALSE(scan.focused());
+  CHECK(scan.next() == 200);
+  CHECK(scan.fit(200, 1000) == 1000);
+}
+} // namespace
@@ -0,0 +1,42 @@
+const assert = require('assert')
+const fs = require('fs')
+const path = require('path')
+const esprima = require('esprima')
+const escodegen = require('escodegen')
+const transform = require('../transform')
+const {Testing} = require('../test')
+
+const filterScript = fs.readFileSync(path.join(__dirname, '../filter.js'))
+const attributes = {
+  eth: {},
+  ipv4: {},
+  tcp: {},
+  'tcp.src': {},
+  'tcp.dst': {},
+}
+
+// Tests 4096 frames where tcp.dst is index % 2048 with every filter engine.
+function run(filter) {
+  const ast = transform(esprima.parse(filter), [], attributes)
+  const body = filterScript + escodegen.generate(ast)
+  return Testing.runFilterBenchmark(body, JSON.stringify(ast), 4096)
+}
+
+describe('Filter', () => {
+  it('should give the same results with the script and native programs', () => {
+    const filters = {
+      'tcp.dst >= 1024': 2048,
+      'tcp.dst <= 80': 162,
+      '1024 >= tcp.dst': 2050,
+      '80 <= tcp.dst && tcp.dst < 1024': 1888,
+    }
+    for (const filter in filters) {
+      const result = run(filter)
+      assert.strictEqual(filters[filter], result.script.matches, filter)
+      for (const name of ['interpreter', 'specialized', 'jit']) {
+        assert.strictEqual(result.script.matches, result[name].matches,
+          `${filter} (${name})`)
+      }
+    }
+  })
+})
@@ -0,0 +1,167 @@
+#include "attribute.hpp"
+#include "filter_thread_pool.hpp"
+#include "frame.hpp"
+#include "frame_store.hpp"
+#include "layer.hpp"
+#include "variant.hpp"
+#include <catch.hpp>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace plugkit;
+
+namespace {
+
+const uint32_t frameCount = 4096;
+
+// Frames 1, 17, 33, ... match.
+std::vector<uint32_t> matches(uint32_t begin, uint32_t end) {
+  std::vector<uint32_t> list;
+  for (uint32_t index = begin; index < end; ++index) {
+    if (index % 16 == 1) {
+      list.push_back(index);
+    }
+  }
+  return list;
+}
+
+// The script fallback, which the native program leaves unused here.
+const char body[] = "(function (frame) { return false })";
+
+std::string program() {
+  return R"({"type":"Program","body":[{"type":"ExpressionStatement",)"
+         R"("expression":{"type":"FunctionExpression","params":[{"type":)"
+         R"("Identifier","name":"$_frame"}],"body":{"type":"BlockStatement",)"
+         R"("body":[{"type":"ReturnStatement","argument":{"type":)"
+         R"("CallExpression","callee":{"type":"Identifier","name":"$_op"},)"
+         R"("arguments":[{"type":"Literal","value":"=="},{"type":)"
+         R"("CallExpression","callee":{"type":"MemberExpression",)"
+         R"("computed":false,"object":{"type":"CallExpression","callee":)"
+         R"({"type":"MemberExpression","computed":false,"object":{"type":)"
+         R"("Identifier","name":"$_frame"},"property":{"type":"Identifier",)"
+         R"("name":"layer"}},"arguments":[{"type":"Literal","value":"tcp"}]},)"
+         R"("property":{"type":"Identifier","name":"attr"}},"arguments":)"
+         R"([{"type":"Literal","value":"tcp.dst"}]},{"type":"Literal",)"
+         R"("value":80}]}}]}}}]})";
+}
+
+struct TestFrame {
+  TestFrame(uint32_t index)
+      : eth(Token_get("eth")), tcp(Token_get("tcp")),
+        dst(Token_get("tcp.dst"),
+            Variant(static_cast<uint32_t>(index % 16 == 1 ? 80 : 443))) {
+    tcp.addAttr(&dst);
+    eth.addLayer(&tcp);
+    frame.setRootLayer(&eth);
+    frame.setIndex(index);
+  }
+
+  Frame frame;
+  Layer eth;
+  Layer tcp;
+  Attr dst;
+};
+
+struct Capture {
+  Capture() {
+    for (uint32_t index = 1; index <= frameCount; ++index) {
+      frames.emplace_back(new TestFrame(index));
+    }
+    Variant options(Variant::Map{});
+    options["_"] = Variant(Variant::Map{});
+    options["_"]["concurrency"] = Variant(static_cast<uint32_t>(2));
+    store = std::make_shared<FrameStore>([]() {});
+    pool.reset(new FilterThreadPool(options, store, []() {}));
+  }
+
+  ~Capture() { pool.reset(); }
+
+  void insert() {
+    std::vector<Frame *> list;
+    for (const auto &frame : frames) {
+      list.push_back(&frame->frame);
+    }
+    store->insert(list.data(), list.size());
+    store->update(const_cast<const Frame **>(list.data()), list.size());
+  }
+
+  uint32_t size() const { return pool->sizes().at("main"); }
+
+  std::vector<std::unique_ptr<TestFrame>> frames;
+  FrameStorePtr store;
+  std::unique_ptr<FilterThreadPool> pool;
+};
+
+bool waitFor(const std::function<bool()> &done) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (!done()) {
+    if (std::chrono::steady_clock::now() > deadline)
+      return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+void settle() { std::this_thread::sleep_for(std::chrono::milliseconds(100)); }
+
+TEST_CASE("FilterThreadPool_limit", "[FilterThreadPool]") {
+  Capture capture;
+  capture.pool->setFilter("main", body, program());
+  capture.pool->setLimit("main", 10);
+  capture.insert();
+
+  REQUIRE(waitFor([&]() { return capture.size() >= 10; }));
+  settle();
+  uint32_t limited = capture.size();
+  CHECK(limited < matches(1, frameCount + 1).size());
+
+  // Raising the limit resumes the scan where it stopped.
+  capture.pool->setLimit("main", 100);
+  REQUIRE(waitFor([&]() { return capture.size() >= 100; }));
+  settle();
+  CHECK(capture.size() < matches(1, frameCount + 1).size());
+
+  capture.pool->setLimit("main", 0);
+  REQUIRE(waitFor([&]() {
+    return capture.size() == matches(1, frameCount + 1).size();
+  }));
+  CHECK(capture.pool->get("main", 0, frameCount) ==
+        matches(1, frameCount + 1));
+}
+
+TEST_CASE("FilterThreadPool_nearest", "[FilterThreadPool]") {
+  Capture capture;
+  capture.pool->setFilter("main", body, program());
+  capture.pool->setLimit("main", 8);
+  capture.insert();
+  REQUIRE(waitFor([&]() { return capture.size() >= 8; }));
+  settle();
+  uint32_t scanned = capture.size();
+
+  // Ahead of the shared scan, the frames around the index are tested first.
+  const std::vector<uint32_t> ahead = {2977, 2993, 3009, 3025};
+  REQUIRE(waitFor(
+      [&]() { return capture.pool->nearest("main", 3000, 4) == ahead; }));
+  CHECK(capture.size() == scanned);
+
+  // Behind the shared scan, the results are already known.
+  CHECK(capture.pool->nearest("main", 20, 2) ==
+        (std::vector<uint32_t>{17, 33}));
+
+  // The frames tested for the viewport are not tested again, and the
+  // results are the same once the shared scan has passed them.
+  capture.pool->setLimit("main", 0);
+  REQUIRE(waitFor([&]() {
+    return capture.size() == matches(1, frameCount + 1).size();
+  }));
+  CHECK(capture.pool->get("main", 0, frameCount) ==
+        matches(1, frameCount + 1));
+  CHECK(capture.pool->nearest("main", 3000, 4) == ahead);
+  CHECK(capture.pool->nearest("main", frameCount, 2) ==
+        (std::vector<uint32_t>{4065, 4081}));
+}
+} // namespace
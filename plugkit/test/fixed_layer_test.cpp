@@ -0,0 +1,72 @@
+#include "fixed_layer.h"
+#include "attribute.hpp"
+#include "layer.hpp"
+#include "payload.hpp"
+#include <catch.hpp>
+
+using namespace plugkit;
+
+namespace {
+
+constexpr Field fields[] = {
+    {Token_const("ipv4.version"), 0, 0, 1, 0, 4, 0xf},
+    {Token_const("ipv4.protocol"), Token_const("@enum"), 1, 1},
+    {Token_const(".src"), Token_const("@ipv4:addr"), 2, 4, FIELD_SLICE},
+};
+
+constexpr FieldTag tags[] = {
+    {0x06, Token_const("[tcp]"), Token_const("ipv4.protocol.tcp")},
+    {0x11, Token_const("[udp]"), Token_const("ipv4.protocol.udp")},
+};
+
+constexpr FixedLayer ipv4 = {Token_const("ipv4"), Layout_make(fields), tags,
+                             2, 1};
+
+void analyzeLength(Context *ctx, Layer *layer, Reader *reader,
+                   Attr *const *attrs) {
+  Payload *chunk = Layer_addPayload(layer);
+  Payload_addSlice(chunk, Reader_slice(reader, 0, Attr_uint32(attrs[0])));
+}
+
+constexpr Field udpFields[] = {
+    {Token_const("udp.length"), 0, 0, 1},
+};
+
+constexpr FixedLayer udp = {Token_const("udp"), Layout_make(udpFields),
+                            nullptr, 0, 0, analyzeLength};
+
+TEST_CASE("FixedLayer_analyze", "[FixedLayer]") {
+  const char data[] = {0x45, 0x11, 10, 0, 0, 1, 3, 'a', 'b', 'c', 'd'};
+  Layer parent(Token_const("eth"));
+  Payload *payload = Layer_addPayload(&parent);
+  Payload_addSlice(payload, Slice{data, data + sizeof(data)});
+
+  FixedLayer_analyze<ipv4>(nullptr, nullptr, Worker(), &parent);
+  REQUIRE(parent.layers().size() == 1);
+  Layer *child = parent.layers()[0];
+  CHECK(child->id() == Token_const("ipv4"));
+  CHECK(child->tags().size() == 2);
+  CHECK(child->tags()[1] == Token_const("[udp]"));
+  CHECK(Attr_uint32(Layer_attr(child, Token_const("ipv4.version"))) == 4);
+  CHECK(Attr_type(Layer_attr(child, Token_const("ipv4.protocol"))) ==
+        Token_const("@enum"));
+  const Attr *proto = Layer_attr(child, Token_const("ipv4.protocol.udp"));
+  CHECK(Attr_bool(proto));
+  CHECK(Attr_range(proto).begin == 1);
+  CHECK(Attr_range(proto).end == 2);
+  CHECK(Layer_attr(child, Token_const("ipv4.protocol.tcp")) == nullptr);
+  REQUIRE(child->payloads().size() == 1);
+  const Slice *slices = Payload_slices(child->payloads()[0], nullptr);
+  CHECK(slices[0].begin == data + 6);
+  CHECK(slices[0].end == data + sizeof(data));
+
+  FixedLayer_analyze<udp>(nullptr, nullptr, Worker(), child);
+  REQUIRE(child->layers().size() == 1);
+  Layer *grandchild = child->layers()[0];
+  CHECK(Attr_uint32(Layer_attr(grandchild, Token_const("udp.length"))) == 3);
+  REQUIRE(grandchild->payloads().size() == 1);
+  slices = Payload_slices(grandchild->payloads()[0], nullptr);
+  CHECK(slices[0].begin == data + 7);
+  CHECK(slices[0].end == data + 10);
+}
+} // namespace
@@ -0,0 +1,77 @@
+#include "flow_table.h"
+#include <catch.hpp>
+#include <vector>
+
+using namespace plugkit;
+
+namespace {
+
+void destroyValue(void *value, void *data) {
+  static_cast<std::vector<int> *>(data)->push_back(
+      *static_cast<int *>(value));
+}
+
+TEST_CASE("FlowTable_find", "[FlowTable]") {
+  std::vector<int> destroyed;
+  int a = 1;
+  int b = 2;
+  FlowTable *table = FlowTable_create(destroyValue, &destroyed);
+  FlowTable_insert(table, "a", 1, &a, 0, 0);
+  FlowTable_insert(table, "b", 1, &b, 0, 0);
+  CHECK(FlowTable_find(table, "a", 1, 0) == &a);
+  CHECK(FlowTable_find(table, "b", 1, 0) == &b);
+  CHECK(FlowTable_find(table, "c", 1, 0) == nullptr);
+  CHECK(FlowTable_size(table) == 2);
+
+  FlowTableStats stats = FlowTable_stats(table);
+  CHECK(stats.inserted == 2);
+  CHECK(stats.lookups == 3);
+  CHECK(stats.hits == 2);
+
+  FlowTable_remove(table, "a", 1);
+  CHECK(FlowTable_find(table, "a", 1, 0) == nullptr);
+  CHECK(destroyed == std::vector<int>{1});
+  FlowTable_destroy(table);
+  CHECK(destroyed == (std::vector<int>{1, 2}));
+}
+
+TEST_CASE("FlowTable_expire", "[FlowTable]") {
+  std::vector<int> destroyed;
+  int a = 1;
+  int b = 2;
+  FlowTable *table = FlowTable_create(destroyValue, &destroyed);
+  FlowTable_setIdleTimeout(table, 100);
+  FlowTable_setClosedTimeout(table, 10);
+  FlowTable_insert(table, "a", 1, &a, 0, 0);
+  FlowTable_insert(table, "b", 1, &b, 0, 0);
+  CHECK(FlowTable_find(table, "a", 1, 50) == &a);
+  FlowTable_expire(table, 120);
+  CHECK(destroyed == std::vector<int>{2});
+  FlowTable_close(table, "a", 1, 130);
+  CHECK(FlowTable_find(table, "a", 1, 135) == &a);
+  CHECK(FlowTable_find(table, "a", 1, 150) == nullptr);
+  CHECK(destroyed == (std::vector<int>{2, 1}));
+
+  FlowTableStats stats = FlowTable_stats(table);
+  CHECK(stats.expired == 2);
+  CHECK(stats.closed == 1);
+  FlowTable_destroy(table);
+}
+
+TEST_CASE("FlowTable_setMemoryLimit", "[FlowTable]") {
+  std::vector<int> destroyed;
+  int a = 1;
+  int b = 2;
+  int c = 3;
+  FlowTable *table = FlowTable_create(destroyValue, &destroyed);
+  FlowTable_setMemoryLimit(table, 2500);
+  FlowTable_insert(table, "a", 1, &a, 1000, 0);
+  FlowTable_insert(table, "b", 1, &b, 1000, 0);
+  CHECK(FlowTable_find(table, "a", 1, 0) == &a);
+  FlowTable_insert(table, "c", 1, &c, 1000, 0);
+  CHECK(destroyed == std::vector<int>{2});
+  CHECK(FlowTable_size(table) == 2);
+  CHECK(FlowTable_stats(table).evicted == 1);
+  FlowTable_destroy(table);
+}
+} // namespace
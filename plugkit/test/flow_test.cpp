@@ -0,0 +1,56 @@
+#include "flow.h"
+#include <catch.hpp>
+#include <cstring>
+
+using namespace plugkit;
+
+namespace {
+
+TEST_CASE("Flow_hash", "[Flow]") {
+  const char addr1[] = {10, 0, 0, 1};
+  const char addr2[] = {10, 0, 0, 2};
+  const Slice src = {addr1, addr1 + sizeof(addr1)};
+  const Slice dst = {addr2, addr2 + sizeof(addr2)};
+
+  CHECK(Flow_hash(src, dst, 80, 1234, 6) == Flow_hash(src, dst, 80, 1234, 6));
+  CHECK(Flow_hash(src, dst, 80, 1234, 6) == Flow_hash(dst, src, 1234, 80, 6));
+  CHECK(Flow_hash(src, dst, 80, 1234, 6) != Flow_hash(src, dst, 80, 1235, 6));
+  CHECK(Flow_hash(src, dst, 80, 1234, 6) != Flow_hash(src, dst, 80, 1234, 17));
+  CHECK(Flow_hash(src, src, 80, 1234, 6) == Flow_hash(src, src, 1234, 80, 6));
+
+  const uint8_t addr3[] = {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+                           0,    0,    0,    0,    0, 0, 0, 1};
+  const uint8_t addr4[] = {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+                           0,    0,    0,    0,    0, 0, 0, 2};
+  const char *data3 = reinterpret_cast<const char *>(addr3);
+  const char *data4 = reinterpret_cast<const char *>(addr4);
+  const Slice src6 = {data3, data3 + sizeof(addr3)};
+  const Slice dst6 = {data4, data4 + sizeof(addr4)};
+  CHECK(Flow_hash(src6, dst6, 443, 50000, 6) ==
+        Flow_hash(dst6, src6, 50000, 443, 6));
+
+  const Slice empty = {nullptr, nullptr};
+  CHECK(Flow_hash(empty, empty, 0, 0, 0) == Flow_hash(empty, empty, 0, 0, 0));
+}
+
+TEST_CASE("FlowKey_set", "[Flow]") {
+  const char addr1[] = {10, 0, 0, 1};
+  const char addr2[] = {10, 0, 0, 2};
+  const Slice src = {addr1, addr1 + sizeof(addr1)};
+  const Slice dst = {addr2, addr2 + sizeof(addr2)};
+
+  FlowKey a;
+  FlowKey b;
+  FlowKey_set(&a, src, dst, 80, 1234, 6);
+  FlowKey_set(&b, src, dst, 80, 1234, 6);
+  CHECK(std::memcmp(&a, &b, sizeof(FlowKey)) == 0);
+  CHECK(a.srcLength == 4);
+  CHECK(a.src[3] == 1);
+  CHECK(a.src[4] == 0);
+
+  FlowKey_set(&b, dst, src, 1234, 80, 6);
+  CHECK(std::memcmp(&a, &b, sizeof(FlowKey)) != 0);
+  FlowKey_set(&b, src, dst, 80, 1234, 17);
+  CHECK(std::memcmp(&a, &b, sizeof(FlowKey)) != 0);
+}
+} // namespace
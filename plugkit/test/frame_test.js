@@ -26,6 +26,12 @@ describe('Frame', () => {
       assert.strictEqual(0, frame.sourceId)
     })
   })
+  describe('#complete', () => {
+    it('should return false until stream dissection finishes', () => {
+      const frame = Testing.createFrameInstance()
+      assert.strictEqual(false, frame.complete)
+    })
+  })
   describe('#leafLayers', () => {
     it('should return frame leafLayers', () => {
       const frame = Testing.createFrameInstance()
@@ -0,0 +1,62 @@
+#include "attribute.hpp"
+#include "frame.hpp"
+#include "frame_view.hpp"
+#include "layer.hpp"
+#include <catch.hpp>
+#include <vector>
+
+using namespace plugkit;
+
+namespace {
+
+TEST_CASE("FrameView_complete", "[FrameView]") {
+  Frame frame;
+  Layer eth(Token_get("eth"));
+  Layer ipv4(Token_get("ipv4"));
+  Layer tcp(Token_get("tcp"));
+  Layer http(Token_get("http"));
+  Attr dst(Token_get("tcp.dst"), Variant(static_cast<uint32_t>(80)));
+  tcp.addAttr(&dst);
+  tcp.setParent(&ipv4);
+  ipv4.addLayer(&tcp);
+  ipv4.setParent(&eth);
+  eth.addLayer(&ipv4);
+  frame.setRootLayer(&eth);
+
+  // The tcp layer is handed to the stream dissectors, which may still
+  // modify it, so it stays hidden until the frame is complete.
+  frame.setStreamLayers({&tcp});
+  FrameView view(&frame);
+  CHECK_FALSE(view.complete());
+  CHECK(view.primaryLayer() == &ipv4);
+  CHECK(view.leafLayers() == (std::vector<const Layer *>{&ipv4}));
+  CHECK(view.layer(Token_get("tcp")) == nullptr);
+  CHECK(view.attr(Token_get("tcp.dst")) == nullptr);
+  CHECK(view.visible(&ipv4));
+  CHECK_FALSE(view.visible(&tcp));
+
+  // Stream dissection adds a child layer, which appears along with its
+  // parent once the frame completes.
+  http.setParent(&tcp);
+  tcp.addLayer(&http);
+  CHECK(view.leafLayers() == (std::vector<const Layer *>{&ipv4}));
+  view.setComplete();
+  CHECK(view.complete());
+  CHECK(view.primaryLayer() == &http);
+  CHECK(view.leafLayers() == (std::vector<const Layer *>{&http}));
+  CHECK(view.layer(Token_get("tcp")) == &tcp);
+  CHECK(view.attr(Token_get("tcp.dst")) == &dst);
+  CHECK(view.visible(&tcp));
+}
+
+TEST_CASE("FrameView_noStreamLayers", "[FrameView]") {
+  Frame frame;
+  Layer eth(Token_get("eth"));
+  Layer ipv4(Token_get("ipv4"));
+  eth.addLayer(&ipv4);
+  frame.setRootLayer(&eth);
+  FrameView view(&frame);
+  CHECK(view.primaryLayer() == &ipv4);
+  CHECK(view.layer(Token_get("eth")) == &eth);
+}
+} // namespace
@@ -0,0 +1,38 @@
+#include "attribute.hpp"
+#include "layer.hpp"
+#include <catch.hpp>
+#include <string>
+
+using namespace plugkit;
+
+namespace {
+
+TEST_CASE("Layer_seal", "[Layer]") {
+  Layer layer(Token_get("eth"));
+  Attr *attrs[20];
+  for (size_t i = 0; i < 20; ++i) {
+    const std::string &name = "eth.attr" + std::to_string(i % 16);
+    attrs[i] = Layer_addAttr(&layer, Token_get(name.c_str()));
+  }
+  const Attr *linear[16];
+  for (size_t i = 0; i < 16; ++i) {
+    const std::string &name = "eth.attr" + std::to_string(i);
+    linear[i] = Layer_attr(&layer, Token_get(name.c_str()));
+    CHECK(linear[i] == attrs[i]);
+  }
+
+  layer.seal();
+  for (size_t i = 0; i < 16; ++i) {
+    const std::string &name = "eth.attr" + std::to_string(i);
+    CHECK(Layer_attr(&layer, Token_get(name.c_str())) == linear[i]);
+  }
+  CHECK(Layer_attr(&layer, Token_get("eth.none")) == nullptr);
+
+  Attr *added = Layer_addAttr(&layer, Token_get("eth.added"));
+  CHECK(Layer_attr(&layer, Token_get("eth.added")) == added);
+  CHECK(Layer_attr(&layer, Token_get("eth.attr3")) == attrs[3]);
+  for (const Attr *attr : layer.attrs()) {
+    delete attr;
+  }
+}
+} // namespace
@@ -1,4 +1,6 @@
 #include "reader.h"
+#include "attribute.hpp"
+#include "layer.hpp"
 #include <catch.hpp>
 
 using namespace plugkit;
@@ -401,4 +403,58 @@ TEST_CASE("Reader_getFloat64 (little endian)", "[Reader]") {
   CHECK(reader.lastRange.end == sizeof(double));
   CHECK(reader.lastError == Token_get("!out-of-bounds"));
 }
+
+TEST_CASE("Reader_readLayout", "[Reader]") {
+  static const Field fields[] = {
+      {Token_get("test.version"), Token_null(), 0, 1, 0, 4, 0xf},
+      {Token_get("test.length"), Token_null(), 0, 1, 0, 0, 0xf},
+      {Token_get("test.flag"), Token_null(), 1, 1, FIELD_BOOL, 7, 1},
+      {Token_get("test.id"), Token_null(), 2, 2, 0, 0, 0},
+      {Token_get("test.seq"), Token_null(), 4, 4, 0, 0, 0},
+      {Token_get("test.le"), Token_null(), 4, 2, FIELD_LITTLE_ENDIAN, 0, 0},
+      {Token_get("test.signed"), Token_null(), 8, 2, FIELD_SIGNED, 0, 0},
+      {Token_get("test.addr"), Token_get("@addr"), 10, 4, FIELD_SLICE, 0, 0},
+  };
+  const Layout layout = Layout_make(fields);
+  CHECK(layout.length == 8);
+  CHECK(layout.size == 14);
+
+  const char data[] = {0x00, 0x45, -0x80, 0x12, 0x34, -0x22, -0x53, -0x42,
+                       -0x11, -0x01, -0x02, 10,    0,     0,     1};
+  Reader reader;
+  Reader_reset(&reader);
+  reader.data = Slice{data, data + sizeof(data)};
+  Reader_getUint8(&reader);
+
+  Layer layer(Token_get("test"));
+  Attr *attrs[8];
+  Reader_readLayout(&reader, &layout, &layer, attrs);
+  CHECK(reader.lastError == Token_null());
+  CHECK(reader.lastRange.begin == 1);
+  CHECK(reader.lastRange.end == 15);
+  CHECK(Attr_uint32(attrs[0]) == 4);
+  CHECK(Attr_uint32(attrs[1]) == 5);
+  CHECK(Attr_bool(attrs[2]));
+  CHECK(Attr_uint32(attrs[3]) == 0x1234);
+  CHECK(Attr_uint32(attrs[4]) == 0xdeadbeef);
+  CHECK(Attr_uint32(attrs[5]) == 0xadde);
+  CHECK(Attr_int32(attrs[6]) == -2);
+  CHECK(Slice_length(Attr_slice(attrs[7])) == 4);
+  CHECK(Attr_slice(attrs[7]).begin == reader.data.begin + 11);
+  CHECK(Attr_type(attrs[7]) == Token_get("@addr"));
+  CHECK(Attr_range(attrs[3]).begin == 3);
+  CHECK(Attr_range(attrs[3]).end == 5);
+  CHECK(Layer_attr(&layer, Token_get("test.id")) == attrs[3]);
+
+  Reader_reset(&reader);
+  reader.data = Slice{data + 1, data + 7};
+  Layer truncated(Token_get("test"));
+  Reader_readLayout(&reader, &layout, &truncated, attrs);
+  CHECK(reader.lastError == Token_get("!out-of-bounds"));
+  CHECK(reader.lastRange.end == 6);
+  CHECK(Attr_uint32(attrs[3]) == 0x1234);
+  CHECK(Attr_uint32(attrs[4]) == 0);
+  CHECK(Attr_uint32(attrs[5]) == 0xadde);
+  CHECK(Slice_length(Attr_slice(attrs[7])) == 0);
+}
 } // namespace
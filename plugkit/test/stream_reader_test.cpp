@@ -1,5 +1,7 @@
 #include "stream_reader.h"
 #include <catch.hpp>
+#include <memory>
+#include <string>
 
 using namespace plugkit;
 
@@ -73,6 +75,98 @@ TEST_CASE("StreamReader_search", "[StreamReader]") {
   StreamReader_destroy(reader);
 }
 
+TEST_CASE("StreamReader_search_across", "[StreamReader]") {
+  StreamReader *reader = StreamReader_create();
+  const char data[] = "GET / HTTP/1.1\r";
+  const char data2[] = "\nHost: example.com\r\n\r";
+  const char data3[] = "\n";
+  StreamReader_addSlice(reader, Slice{data, data + sizeof(data) - 1});
+  StreamReader_addSlice(reader, Slice{data2, data2 + sizeof(data2) - 1});
+  StreamReader_addSlice(reader, Slice{data3, data3 + sizeof(data3) - 1});
+
+  size_t offset = StreamReader_search(reader, "\r\n", 2, 0);
+  CHECK(offset == 16);
+  offset = StreamReader_search(reader, "\r\n", 2, offset);
+  CHECK(offset == 35);
+  CHECK(StreamReader_search(reader, "\r\n\r\n", 4, 0) == 37);
+  CHECK(StreamReader_search(reader, "1.1\r\nHost", 9, 0) == 20);
+  CHECK(StreamReader_search(reader, "\n\n", 2, 0) == 0);
+
+  StreamReader_destroy(reader);
+}
+
+TEST_CASE("StreamReader_cursor", "[StreamReader]") {
+  StreamReader *reader = StreamReader_create();
+  const char data[] = "Host: a\r";
+  const char data2[] = "\n\r\nbody";
+  StreamReader_addSlice(reader, Slice{data, data + sizeof(data) - 1});
+  StreamReader_addSlice(reader, Slice{data2, data2 + sizeof(data2) - 1});
+
+  char buf[16];
+  Slice slice =
+      StreamReader_readUntil(reader, buf, sizeof(buf), "\r\n", 2, nullptr);
+  CHECK(std::string(slice.begin, slice.end) == "Host: a");
+  CHECK(StreamReader_tell(reader) == 9);
+  slice = StreamReader_readUntil(reader, buf, sizeof(buf), "\r\n", 2, nullptr);
+  CHECK(slice.begin != nullptr);
+  CHECK(Slice_length(slice) == 0);
+  slice = StreamReader_readUntil(reader, buf, sizeof(buf), "\r\n", 2, nullptr);
+  CHECK(slice.begin == nullptr);
+  CHECK(StreamReader_tell(reader) == 11);
+
+  slice = StreamReader_peek(reader, buf, 2);
+  CHECK(std::string(slice.begin, slice.end) == "bo");
+  CHECK(StreamReader_advance(reader, 10) == 4);
+  CHECK(StreamReader_tell(reader) == 15);
+
+  StreamReader_discard(reader, 11);
+  CHECK(StreamReader_length(reader) == 15);
+  slice = StreamReader_read(reader, buf, 4, 0);
+  CHECK(Slice_length(slice) == 0);
+  slice = StreamReader_read(reader, buf, 4, 11);
+  CHECK(std::string(slice.begin, slice.end) == "body");
+  CHECK(StreamReader_search(reader, "\r\n", 2, 0) == 11);
+
+  StreamReader_destroy(reader);
+}
+
+TEST_CASE("StreamReader_readUntil", "[StreamReader]") {
+  StreamReader *reader = StreamReader_create();
+  const char data[] = "Cookie: a=1; b=2";
+  const char data2[] = "; c=3\r\nHost: example.com\r\n";
+  StreamReader_addSlice(reader, Slice{data, data + sizeof(data) - 1});
+  StreamReader_addSlice(reader, Slice{data2, data2 + sizeof(data2) - 1});
+
+  char buf[8];
+  size_t length = 1;
+  Slice slice =
+      StreamReader_readUntil(reader, buf, sizeof(buf), "\r\n", 2, &length);
+  CHECK(slice.begin == nullptr);
+  CHECK(length == 21);
+  CHECK(StreamReader_tell(reader) == 0);
+
+  std::unique_ptr<char[]> line(new char[length]);
+  slice = StreamReader_readUntil(reader, line.get(), length, "\r\n", 2,
+                                 nullptr);
+  CHECK(std::string(slice.begin, slice.end) == "Cookie: a=1; b=2; c=3");
+  CHECK(StreamReader_tell(reader) == 23);
+
+  // A line in a single slice is returned even if it exceeds the buffer.
+  slice =
+      StreamReader_readUntil(reader, buf, sizeof(buf), "\r\n", 2, &length);
+  CHECK(std::string(slice.begin, slice.end) == "Host: example.com");
+  CHECK(length == 17);
+  CHECK(StreamReader_tell(reader) == 42);
+
+  slice =
+      StreamReader_readUntil(reader, buf, sizeof(buf), "\r\n", 2, &length);
+  CHECK(slice.begin == nullptr);
+  CHECK(length == 0);
+  CHECK(StreamReader_tell(reader) == 42);
+
+  StreamReader_destroy(reader);
+}
+
 TEST_CASE("StreamReader_length", "[StreamReader]") {
   StreamReader *reader = StreamReader_create();
   CHECK(StreamReader_length(reader) == 0);
@@ -1,5 +1,8 @@
 #include "token.h"
 #include <catch.hpp>
+#include <string>
+#include <thread>
+#include <vector>
 
 using namespace plugkit;
 
@@ -81,4 +84,51 @@ TEST_CASE("Token_string", "[Token]") {
             Token_string(Token_get("7a250b5e-0cb3-4987-81f6-1a8bb5f26704"))) ==
         Token_get("7a250b5e-0cb3-4987-81f6-1a8bb5f26704"));
 }
+
+TEST_CASE("Token_const", "[Token]") {
+  constexpr Token ipv4 = Token_const("ipv4");
+  constexpr Token flags = Token_const("tcp.flags.ack");
+  static_assert(Token_const("") == 0, "null token");
+  CHECK(ipv4 == Token_get("ipv4"));
+  CHECK(flags == Token_get("tcp.flags.ack"));
+  CHECK(Token_const("[ipv4]") == Token_get("[ipv4]"));
+  CHECK(Token_const("5d5a6c21-4bd6-4c5a-8e3e-9b6b1a5b8c4f") ==
+        Token_get("5d5a6c21-4bd6-4c5a-8e3e-9b6b1a5b8c4f"));
+}
+
+TEST_CASE("Token_keywordCount", "[Token]") {
+  // Keywords are numbered by their position in token.keys.
+  CHECK(Token_get(".length") == 1);
+  CHECK(Token_const(".dst") == 2);
+  CHECK(Token_string(3) == std::string(".src"));
+  const char *last = Token_keywords_[Token_keywordCount - 1];
+  CHECK(Token_get(last) == Token_keywordCount);
+  CHECK(Token_string(Token_keywordCount) == std::string(last));
+  CHECK(Token_get("0b8a7c1e-5d6f-4e3a-9b2c-1f0e9d8c7b6a") > Token_keywordCount);
+}
+
+TEST_CASE("Token_concurrent", "[Token]") {
+  const size_t words = 4096;
+  std::vector<std::vector<Token>> tokens(4, std::vector<Token>(words));
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < tokens.size(); ++i) {
+    threads.emplace_back([i, &tokens]() {
+      for (size_t j = 0; j < words; ++j) {
+        size_t word = (j * 7 + i * 13) % words;
+        const std::string &str = "concurrent-" + std::to_string(word);
+        tokens[i][word] = Token_get(str.c_str());
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (size_t i = 1; i < tokens.size(); ++i) {
+    CHECK(tokens[i] == tokens[0]);
+  }
+  for (size_t word = 0; word < words; ++word) {
+    CHECK(Token_string(tokens[0][word]) ==
+          "concurrent-" + std::to_string(word));
+  }
+}
 } // namespace
@@ -2,6 +2,7 @@
 #include <catch.hpp>
 #include <cfloat>
 #include <cstring>
+#include <string>
 
 using namespace plugkit;
 
@@ -103,6 +104,34 @@ TEST_CASE("Variant_slice", "[variant]") {
   CHECK(slice2.end == nullptr);
 }
 
+TEST_CASE("Variant_move", "[variant]") {
+  const std::string &longStr = "HELLO WORLD HELLO WORLD";
+  Variant str(longStr);
+  Variant copy(str);
+  Variant moved(std::move(str));
+  CHECK(str.isNil());
+  CHECK(moved.string() == longStr);
+  CHECK(copy.string() == longStr);
+
+  Variant shortStr(std::string("HELLO WORLD"));
+  CHECK(shortStr.tag() == 11);
+  copy = shortStr;
+  CHECK(strcmp(Variant_string(&copy), "HELLO WORLD") == 0);
+
+  const Timestamp ts(std::chrono::nanoseconds(1500000000123456789ll));
+  Variant timestamp(ts);
+  moved = std::move(timestamp);
+  CHECK(timestamp.isNil());
+  CHECK(moved.timestamp() == ts);
+
+  Variant array(Variant::Array{Variant(longStr), Variant(true)});
+  Variant target(Variant::Map{});
+  target = std::move(array);
+  CHECK(array.isNil());
+  CHECK(target.length() == 2);
+  CHECK(target[0].string() == longStr);
+}
+
 TEST_CASE("Variant_arrayValue", "[variant]") {
   Variant variant;
   const Variant *value = Variant_arrayValue(&variant, 0);
@@ -140,4 +169,52 @@ TEST_CASE("Variant_mapValue", "[variant]") {
   value = Variant_mapValue(&variant, "ddd", 3);
   CHECK(Variant_bool(value) == false);
 }
+
+TEST_CASE("Variant_mapLookup", "[variant]") {
+  Variant variant;
+  const char *keys[] = {"zeta", "alpha", "mid", "alpha2"};
+  for (int i = 0; i < 4; ++i) {
+    Variant_setInt32(Variant_mapValueRef(&variant, keys[i], -1), i);
+  }
+  CHECK(variant.length() == 4);
+  CHECK(Variant_int32(Variant_mapValue(&variant, "alpha2xyz", 6)) == 3);
+  CHECK(Variant_mapValue(&variant, "alp", 3) == nullptr);
+  CHECK(variant["mid"].int32Value() == 2);
+
+  std::string prev;
+  for (const auto &pair : variant.map()) {
+    CHECK(prev < pair.first);
+    prev = pair.first;
+  }
+
+  const Variant &constVariant = variant;
+  CHECK(constVariant["none"].isNil());
+  CHECK(constVariant["zeta"].int32Value() == 0);
+}
+
+TEST_CASE("Variant_mapValueRef", "[variant]") {
+  Variant variant;
+  Variant_setInt32(Variant_mapValueRef(&variant, "host", -1), 1);
+  Variant_setInt32(Variant_mapValueRef(&variant, "cookie", -1), 2);
+
+  // Looking up existing keys does not move the entries.
+  Variant *host = Variant_mapValueRef(&variant, "host", -1);
+  Variant *cookie = Variant_mapValueRef(&variant, "cookie", -1);
+  CHECK(Variant_mapValueRef(&variant, "host", 4) == host);
+  CHECK(Variant_mapValueRef(&variant, "cookie", 6) == cookie);
+  Variant_setInt32(host, 3);
+  CHECK(Variant_int32(Variant_mapValue(&variant, "host", -1)) == 3);
+
+  // Inserting may move them, so both refs are looked up again.
+  for (int i = 0; i < 64; ++i) {
+    const std::string &key = "accept" + std::to_string(i);
+    Variant_setInt32(Variant_mapValueRef(&variant, key.c_str(), -1), i);
+  }
+  host = Variant_mapValueRef(&variant, "host", -1);
+  cookie = Variant_mapValueRef(&variant, "cookie", -1);
+  CHECK(host != cookie);
+  CHECK(Variant_int32(host) == 3);
+  CHECK(Variant_int32(cookie) == 2);
+  CHECK(variant.length() == 66);
+}
 } // namespace
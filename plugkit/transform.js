@@ -81,6 +81,8 @@ module.exports = function transform(ast, transforms, attributes) {
       if (node.type === 'Identifier' && parent.type !== 'MemberExpression') {
         if (node.name in attributes) {
           return esprima.parse(`$_frame.layer('${node.name}')`).body[0].expression
+        } else if (node.name === 'timestamp') {
+          return esprima.parse('$_frame.timestamp').body[0].expression
         }
       }
     }
@@ -0,0 +1,130 @@
+#!/usr/bin/env node
+// Generates the well-known token tables.
+//
+// The keywords in token.keys are numbered by their position in the file,
+// starting from 1. Native plugins bake these numbers in with Token_const(),
+// so the file is append-only: keywords are never removed or reordered.
+//
+//   token-keys.js keys <token.keys> <sources...>
+//     Appends the string literals passed to Token_get() and Token_const()
+//     in the given sources to token.keys.
+//
+//   token-keys.js gperf <token.keys> <output.gperf>
+//     Emits a gperf input which maps each keyword to its number.
+//
+//   token-keys.js header <token.keys> <output.h>
+//     Emits the keywords as compile-time constants for Token_const().
+const fs = require('fs')
+
+const literalPattern = /\bToken_(?:get|const)\(\s*"((?:[^"\\\n]|\\.)*)"\s*\)/g
+
+function fnv1a(str) {
+  let hash = 2166136261
+  for (const byte of Buffer.from(str, 'utf8')) {
+    hash = Math.imul(hash ^ byte, 16777619) >>> 0
+  }
+  return hash
+}
+
+function readKeywords(file) {
+  return fs.readFileSync(file, 'utf8').split('\n')
+    .filter((line) => line.length > 0)
+}
+
+function keys(file, sources) {
+  const words = readKeywords(file)
+  const known = new Set(words)
+  const added = []
+  for (const source of sources) {
+    const content = fs.readFileSync(source, 'utf8')
+    let match = null
+    while ((match = literalPattern.exec(content)) !== null) {
+      const word = JSON.parse(`"${match[1]}"`)
+      if (word.length > 0 && !/[\s,"\\]/.test(word) && !known.has(word)) {
+        known.add(word)
+        added.push(word)
+      }
+    }
+  }
+  if (added.length > 0) {
+    fs.appendFileSync(file, `${added.join('\n')}\n`)
+  }
+}
+
+function gperf(file, output) {
+  const entries = readKeywords(file)
+    .map((word, index) => `${JSON.stringify(word)}, ${index + 1}`)
+  write(output, `%struct-type
+%define lookup-function-name Token_keyword_
+%define hash-function-name Token_keywordHash_
+struct TokenKeyword_ {
+  const char *name;
+  unsigned int token;
+};
+%%
+${entries.join('\n')}
+`)
+}
+
+function header(file, output) {
+  const words = readKeywords(file)
+  const keys = words.map((word, index) => ({ hash: fnv1a(word), token: index + 1 }))
+  keys.sort((a, b) => a.hash - b.hash || a.token - b.token)
+
+  const keywords = words.map((word) => `    ${JSON.stringify(word)},`)
+  const entries = keys.map((key) =>
+    `    {0x${key.hash.toString(16).padStart(8, '0')}u, ${key.token}},`)
+  write(output, `// Generated by scripts/token-keys.js. Do not edit.
+#ifndef PLUGKIT_TOKEN_KEYS_H
+#define PLUGKIT_TOKEN_KEYS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace plugkit {
+
+struct TokenKey_ {
+  uint32_t hash;
+  uint32_t token;
+};
+
+// Token_keywords_[i] is the keyword of the token i + 1.
+constexpr const char *Token_keywords_[] = {
+${keywords.join('\n')}
+};
+
+// Sorted by the FNV-1a hash of the keyword.
+constexpr TokenKey_ Token_keys_[] = {
+${entries.join('\n')}
+};
+
+constexpr size_t Token_keyCount_ = ${keys.length};
+
+} // namespace plugkit
+
+#endif
+`)
+}
+
+// Leaves the output untouched if nothing changed to avoid rebuilding every
+// file which includes it.
+function write(output, content) {
+  if (fs.existsSync(output) && fs.readFileSync(output, 'utf8') === content) {
+    return
+  }
+  fs.writeFileSync(output, content)
+}
+
+const [command, ...args] = process.argv.slice(2)
+if (command === 'keys' && args.length >= 1) {
+  keys(args[0], args.slice(1))
+} else if (command === 'gperf' && args.length === 2) {
+  gperf(args[0], args[1])
+} else if (command === 'header' && args.length === 2) {
+  header(args[0], args[1])
+} else {
+  console.error('usage: token-keys.js keys <token.keys> <sources...>')
+  console.error('       token-keys.js gperf <token.keys> <output.gperf>')
+  console.error('       token-keys.js header <token.keys> <output.h>')
+  process.exit(1)
+}